@@ -0,0 +1,68 @@
+#!/bin/sh
+# Headless linux build of the engine core (jni/linux_main.c) against the null gl backend.
+#
+#   host.sh [command] [bench args...]
+#   By default build and run the frame time benchmark.
+#
+#   Optional [command] is:
+#     build     - only build bin/host/nativeapp_bench
+#     bench     - only run the benchmark, extra args are passed through
+#     record    - build and run with the gl command recorder (GFX_BACKEND_RECORD) and
+#                 report gl calls/bytes per frame, extra args are passed through
+#     split     - run a dashboard sized load (100000 quads) that is more than the stream ring
+#                 holds, so the ui bucket has to split into several draws. fails if a quad is
+#                 dropped or nothing split, extra args are passed through
+#
+# CC and CFLAGS can be overridden from the environment.
+
+PROJECT_DIR=$(cd "$(dirname "$0")" && pwd)
+OUT_DIR="$PROJECT_DIR/bin/host"
+BENCH="$OUT_DIR/nativeapp_bench"
+RECORD_BENCH="$OUT_DIR/nativeapp_bench_record"
+
+: "${CC:=cc}"
+: "${CFLAGS:=-O2 -g}"
+
+# compile <output> [extra flags...]
+compile() {
+  OUTPUT=$1; shift
+  mkdir -p "$OUT_DIR" || exit 1
+  # -fgnu89-inline: the ui helpers are plain `inline` and need an out of line definition
+  $CC -std=gnu11 $CFLAGS -fgnu89-inline -Wno-incompatible-pointer-types "$@" \
+    -I"$PROJECT_DIR/jni" -I"$PROJECT_DIR/jni/cglm/include" \
+    -o "$OUTPUT" "$PROJECT_DIR/jni/linux_main.c" -lm -pthread || exit 1
+}
+
+build() {
+  compile "$BENCH"
+}
+
+bench() {
+  "$BENCH" -assets "$PROJECT_DIR/assets" "$@"
+}
+
+record() {
+  compile "$RECORD_BENCH" -DGFX_BACKEND_RECORD
+  "$RECORD_BENCH" -assets "$PROJECT_DIR/assets" "$@"
+}
+
+# the frame arena holds ENGINE_FRAME_MAX_QUADS, the ring a lot less
+split() {
+  OUTPUT=$(bench -quads 100000 -frames 300 "$@") || exit 1
+  echo "$OUTPUT"
+  echo "$OUTPUT" | grep -q " 0 quads dropped total" || { echo "split: quads were dropped"; exit 1; }
+  echo "$OUTPUT" | grep -q " 0.00 overflow draws" && { echo "split: the bucket never split"; exit 1; }
+  return 0
+}
+
+case "$1" in
+  build) build ;;
+  bench) shift; bench "$@" ;;
+  record) shift; record "$@" ;;
+  split) shift; split "$@" ;;
+  "")    build && bench ;;
+  *)
+    echo "Usage: $(basename "$0") [build|bench|record|split] [bench args...]"
+    exit 1
+    ;;
+esac
@@ -13,9 +13,10 @@ LOCAL_MODULE := main
 LOCAL_SRC_FILES := main.c 
 LOCAL_C_INCLUDES := ${LOCAL_PATH}/cglm/include
 LOCAL_CFLAGS := -fdiagnostics-absolute-paths
+# add -DGFX_BACKEND_RECORD to log gl calls/bytes per frame through logcat (see gfx_record.h)
 #LOCAL_CPPFLAGS
 #LOCAL_LDFLAGS
-LOCAL_LDLIBS := -llog -landroid -lEGL -lGLESv3
+LOCAL_LDLIBS := -llog -landroid -ldl -lEGL -lGLESv3
 LOCAL_STATIC_LIBRARIES := android_native_app_glue
 #LOCAL_SHARED_LIBRARIES
 #LOCAL_ARM_MODE := arm
@@ -1,31 +1,111 @@
 #ifndef DRAW_H
 #define DRAW_H
 
-#define DRAW_BUCKET_MAX_COUNT (256)
+// NOTE(MIGUEL): cpu side buckets grow in chunks of this many quads out of the frame arena
+#define DRAW_BATCH_CHUNK_COUNT (1024)
 // TODO(MIGUEL): add border thickness, roundness, border color
 typedef struct quad_attribs quad_attribs;
 struct quad_attribs
 {r2f Rect; v4f Color;};
+// NOTE(MIGUEL): a contiguous run of quads. Either mapped gpu memory (write only) that is drawn
+//               from in place or a chunk in the frame arena that the gfx layer streams at submit
+//               time.
+typedef struct draw_batch draw_batch;
+struct draw_batch
+{
+  quad_attribs *QuadAttribs;
+  u32 Count;
+  u32 Capacity;
+  b32 IsMapped;
+  u32 BufferId; //gpu buffer QuadAttribs is mapped from, starting at offset 0
+  draw_batch *Next;
+};
 typedef struct draw_bucket draw_bucket;
 struct draw_bucket
 {
   //trasform (projection)
-  quad_attribs QuadAttribs [DRAW_BUCKET_MAX_COUNT];
-  u32 Count;
+  arena *Arena; //where batches past the mapped one grow
+  draw_batch *First;
+  draw_batch *Last;
+  u32 Count; //quads over all batches
+  u32 DroppedCount; //quads that did not fit in the arena
+  b32 IsFull;       //a batch failed to grow, the rest of the frame is dropped straight away
   mat4 Model;
   mat4 Projection;
 };
-void DrawBucketBegin(draw_bucket *Bucket, mat4 Model, mat4 Projection)
+draw_batch *DrawBucketPushBatch(draw_bucket *Bucket, quad_attribs *Mapped, u32 Capacity, u32 BufferId)
+{
+  if(!Bucket->Arena) return NULL;
+  //all or nothing, a header without its quads would be left behind
+  arena_temp Temp = ArenaTempBegin(Bucket->Arena);
+  draw_batch *Batch = ArenaPushStruct(Bucket->Arena, draw_batch);
+  quad_attribs *QuadAttribs = Mapped?Mapped:ArenaPushArray(Bucket->Arena, quad_attribs, Capacity);
+  if(!Batch || !QuadAttribs)
+  {
+    ArenaTempEnd(Temp);
+    return NULL;
+  }
+  Batch->QuadAttribs = QuadAttribs;
+  Batch->Count       = 0;
+  Batch->Capacity    = Capacity;
+  Batch->IsMapped    = Mapped?1:0;
+  Batch->BufferId    = BufferId;
+  Batch->Next        = NULL;
+  if(Bucket->Last) { Bucket->Last->Next = Batch; }
+  else             { Bucket->First      = Batch; }
+  Bucket->Last = Batch;
+  return Batch;
+}
+// NOTE(MIGUEL): Mapped is write only memory (Capacity quads of BufferId) that becomes the first
+//               batch. Pass NULL to only use the arena and let the gfx layer copy it later.
+void DrawBucketBegin(draw_bucket *Bucket, arena *Arena, quad_attribs *Mapped, u32 Capacity,
+                     u32 BufferId, mat4 Model, mat4 Projection)
 {
-  // TODO(MIGUEL): zero QuadAttribs array, maybe?
-  Bucket->Count = 0;
+  Bucket->Arena        = Arena;
+  Bucket->First        = NULL;
+  Bucket->Last         = NULL;
+  Bucket->Count        = 0;
+  Bucket->DroppedCount = 0;
+  Bucket->IsFull       = 0;
+  if(Mapped) { DrawBucketPushBatch(Bucket, Mapped, Capacity, BufferId); }
   if(Model     ) { memcpy(Bucket->Model     , Model     , sizeof(mat4)); }
   if(Projection) { memcpy(Bucket->Projection, Projection, sizeof(mat4)); }
   return;
 }
-void DrawBucketEnd(draw_bucket *Bucket)
+// NOTE(MIGUEL): returns the bytes written to the mapped batch so just that range gets flushed.
+//               The mapped batch is closed, anything pushed after this lands in the arena.
+u32 DrawBucketEnd(draw_bucket *Bucket)
 {
-  // NOTE(MIGUEL): push bucket to some storage for later for gfx rendering code
+  draw_batch *Batch = Bucket->First;
+  if(!(Batch && Batch->IsMapped)) return 0;
+  Batch->Capacity = Batch->Count;
+  return Batch->Count*sizeof(quad_attribs);
+}
+// NOTE(MIGUEL): NULL when the arena is out of room, the quad is counted as dropped. only the
+//               first overflow tries the arena, every quad after it is dropped without a push.
+quad_attribs *DrawBucketPushAttribs(draw_bucket *Bucket)
+{
+  draw_batch *Batch = Bucket->Last;
+  if(!(Batch && Batch->Count<Batch->Capacity))
+  {
+    Batch = Bucket->IsFull?NULL:DrawBucketPushBatch(Bucket, NULL, DRAW_BATCH_CHUNK_COUNT, 0);
+    if(!Batch)
+    {
+      Bucket->IsFull = 1;
+      Bucket->DroppedCount++;
+      return NULL;
+    }
+  }
+  Bucket->Count++;
+  return &Batch->QuadAttribs[Batch->Count++];
+}
+void DrawBucketPushRect(draw_bucket *Bucket, r2f Rect, v4f Color)
+{
+  quad_attribs *Attribs = DrawBucketPushAttribs(Bucket);
+  if(!Attribs) return;
+  Attribs->Rect  = Rect;
+  Attribs->Color = Color;
+  return;
 }
 void DrawBucketPushText(draw_bucket *Bucket)
 {
@@ -36,14 +116,18 @@ void DrawBucketPushQuad(draw_bucket *Bucket, u32 Count)
   //vertex3d *Verts, 
   return;
 }
-void DrawBucketPushUIElements(draw_bucket *Bucket, ui_elm *Elements, u32 Count)
+// NOTE(MIGUEL): back to front along the z list. VisibleBits (one bit per element slot, see
+//               UIRectsHitTestRect) skips what is culled, NULL draws everything. Each element's
+//               attribute stack values (offset, clip, tint) are baked into its quad here.
+void DrawBucketPushUIElements(draw_bucket *Bucket, ui_state *State, u32 *VisibleBits)
 {
-  if(!(Bucket->Count<DRAW_BUCKET_MAX_COUNT)) return;
-  for(ui_elm *Current = Elements; Current!=NULL; Current = Current->Next)
+  for(ui_elm *Current = State->ZList.Bottom; Current!=NULL; Current = Current->Next)
   {
-    quad_attribs *Attribs = &Bucket->QuadAttribs[Bucket->Count++];
-    Attribs->Rect  = Current->Rect;
-    Attribs->Color = Current->Color;
+    if(VisibleBits && !UIBitsIsSet(VisibleBits, (u32)(Current-State->Elements))) continue;
+    if(Current->Flags & UI_Flag_Layout) continue;
+    r2f Rect = UIElementVisibleRect(Current);
+    if(R2fIsEmpty(Rect)) continue;
+    DrawBucketPushRect(Bucket, Rect, V4fHadamard(Current->Color, Current->Tint));
     //DrawBucketPushText(draw_bucket *Bucket, Elements.Text);
   }
   return;
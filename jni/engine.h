@@ -1,357 +1,1066 @@
 #ifndef ENGINE_H
 #define ENGINE_H
-//10*10
-#define QUAD3D_PLANE_QUADS_PER_SIDE (64)
-#define QUAD3D_PLANE_QUADCOUNT (QUAD3D_PLANE_QUADS_PER_SIDE*QUAD3D_PLANE_QUADS_PER_SIDE)
+// NOTE(MIGUEL): Platform agnostic engine core. A platform layer (main.c on android, linux_main.c
+//               for the headless host build) defines LOG/Assert, includes this and owns the
+//               window, gl context, asset loading and the input pump.
+#include <assert.h>
+#include <string.h>
+#include "types.h"
+#include "timing.h"
+#include "mymath.h"
+#include "memory.h"
+#include "jobs.h"
+#include "packet.h"
+#include "input.h"
+#include "gesture.h"
+#include "latency.h"
+#include "pacing.h"
+#include "simd.h"
+#include "ui.h"
+
+//Global Input
+// NOTE(MIGUEL): touch globals are the update's view of the frame, EngineBeginFrame sets them
+//               from the drained input events. platforms push events, never write these.
+v2f GlobalRes      = {0};
+v2f GlobalTouchPos = {0};
+v2f GlobalTouchDelta = {0};
+b32 GlobalIsPressed = 0;
+b32 GlobalJustPressed = 0;
+b32 GlobalJustReleased = 0;
+b32 GlobalJustTapped = 0;
+v2f GlobalTapPos = {0};
+f64 GlobalDeltaTime = 0;
+f64 GlobalTimeElapsed = 0;
+//Global Input
+
+#include "widget.h"
+#include "draw.h"
+#include "render.h"
+#include "gfx.h"
+#include "mesh.h"
+#include "heightfield.h"
+#include "terrain.h"
+
+vertex QuadData[6] =
+{
+  //tri:a//Pos            Color
+  {{-1.0f,  1.0f},    {1.f, 1.f, 0.f,} },
+  {{1.0f ,  1.0f},    {1.f, 0.f, 0.f,} },
+  {{1.0f , -1.0f},    {0.f, 1.f, 0.f,} },
+  //tri:b
+  {{-1.0f, -1.0f},    {0.f, 0.f, 1.f,} },
+  {{1.0f , -1.0f},    {0.f, 1.f, 0.f,} },
+  {{-1.0f,  1.0f},    {1.f, 1.f, 0.f,} },
+};
+
+vertex3d QuadData3d[6] =
+{
+  //tri:a       v(Pos)            v(uv)
+  {{-1.f, 0.f,  1.f,}, { 0.f,  1.f,} },
+  {{ 1.f, 0.f,  1.f,}, { 1.f,  1.f,} },
+  {{ 1.f, 0.f, -1.f,}, { 1.f,  0.f,} },
+  //tri:b
+  {{-1.f, 0.f, -1.f,}, { 0.f,  0.f,} },
+  {{ 1.f, 0.f, -1.f,}, { 1.f,  0.f,} },
+  {{-1.f, 0.f,  1.f,}, { 0.f,  1.f,} },
+};
+
+//build the terrain mesh on a worker thread, 0 builds it inline in EngineCreate
+#ifndef ENGINE_TERRAIN_ASYNC
+#define ENGINE_TERRAIN_ASYNC (1)
+#endif
+//per frame budget for everything streamed through the ring (ui instances, terrain heights, ...)
+#define ENGINE_STREAM_RING_FRAME_SIZE (1024*1024)
+// NOTE(MIGUEL): the platform hands the engine one block of ENGINE_MEMORY_SIZE bytes. Every frame
+//               packet gets a frame arena, scratch that is reset when the update starts filling
+//               the packet again, the permanent arena gets the rest and holds the engine itself.
+//quads a frame's draw buckets can hold. past the stream ring's room they still get drawn, just
+//split into several draws through the overflow buffer (GfxCtxDrawInstancesOverflow)
+#define ENGINE_FRAME_MAX_QUADS (128*1024)
+#define ENGINE_FRAME_ARENA_SIZE (2*1024*1024+ENGINE_FRAME_MAX_QUADS*sizeof(quad_attribs))
+#define ENGINE_PERMANENT_ARENA_SIZE (6*1024*1024) //mostly the terrain heightfield
+#define ENGINE_MEMORY_SIZE (ENGINE_FRAME_ARENA_SIZE*PACKET_QUEUE_MAX_COUNT+ENGINE_PERMANENT_ARENA_SIZE)
+//packets between update and render, 2 is double buffered (lowest latency), 3 triple
+#ifndef ENGINE_FRAME_PACKETS
+#define ENGINE_FRAME_PACKETS (2)
+#endif
+#define ENGINE_UI_ELEMENT_CAPACITY (256)
+#define ENGINE_DASHBOARD_COLUMNS (8)
+//permanent arena bytes per element of capacity, the key table rounds up to at most 4 entries each
+#define ENGINE_UI_ELEMENT_SIZE (sizeof(ui_elm)+UI_GRID_NODES_PER_ELEMENT*sizeof(ui_grid_node)+ \
+                                sizeof(ui_grid_span)+4*sizeof(f32)+4*sizeof(ui_table_entry))
+//job threads counting the engine's own, 0 for one per core
+#ifndef ENGINE_JOB_THREADS
+#define ENGINE_JOB_THREADS (0)
+#endif
+#define ENGINE_HEIGHTS_JOB_CHUNKS (8) //chunks gathered per stream heights job
+// NOTE(MIGUEL): where the terrain vertex shader gets heights from. Both run off the same cpu
+//               heightfield, stream gathers every drawn vertex's height into the ring each frame,
+//               texture keeps a gpu copy of the heightfield and only uploads what scrolled in.
+//               Switchable at runtime, frame times are kept per source to compare them.
+typedef enum engine_terrain_heights engine_terrain_heights;
+enum engine_terrain_heights
+{
+  TerrainHeights_Stream,
+  TerrainHeights_Texture,
+  TerrainHeights_Count,
+};
+const char *EngineTerrainHeightsNames[TerrainHeights_Count] = { "stream", "texture" };
+#ifndef ENGINE_TERRAIN_HEIGHTS
+#define ENGINE_TERRAIN_HEIGHTS (TerrainHeights_Texture)
+#endif
+//frames between automatic source switches for a/b runs on device, 0 to never switch
+#ifndef ENGINE_TERRAIN_HEIGHTS_SWITCH_FRAMES
+#define ENGINE_TERRAIN_HEIGHTS_SWITCH_FRAMES (0)
+#endif
+typedef struct engine_terrain_heights_stats engine_terrain_heights_stats;
+struct engine_terrain_heights_stats
+{
+  u64 FrameCount;
+  u64 FrameNs;   //EngineBeginFrame through EngineRender, includes time spent queued
+  u64 HeightsNs; //scroll, packing and getting this frame's heights to the gpu
+  u64 Bytes;     //ring or texture bytes those heights cost
+};
+// NOTE(MIGUEL): input latency, per input event from the time the os stamped it to: the update
+//               picking it up, the render side finishing the frame it went into, and the swap
+//               of that frame returning. rolling histograms, logged every
+//               ENGINE_LATENCY_LOG_FRAMES presented frames (0 to only log at teardown).
+typedef enum engine_latency_stage engine_latency_stage;
+enum engine_latency_stage
+{
+  LatencyStage_Update,
+  LatencyStage_Submit,
+  LatencyStage_Present,
+  LatencyStage_Count,
+};
+const char *EngineLatencyStageNames[LatencyStage_Count] = { "update", "submit", "present" };
+#ifndef ENGINE_LATENCY_LOG_FRAMES
+#define ENGINE_LATENCY_LOG_FRAMES (600)
+#endif
+//frame pacing: target refresh rate (60, 90, 120) and quiet frames before going idle (0 never)
+#ifndef ENGINE_TARGET_FPS
+#define ENGINE_TARGET_FPS (60)
+#endif
+#ifndef ENGINE_IDLE_AFTER_FRAMES
+#define ENGINE_IDLE_AFTER_FRAMES (120)
+#endif
+//the terrain scrolls with time, so while it is on screen frames are never quiet
+#ifndef ENGINE_TERRAIN_ANIMATED
+#define ENGINE_TERRAIN_ANIMATED (1)
+#endif
+typedef struct engine_heights_job engine_heights_job;
+struct engine_heights_job
+{
+  terrain *Terrain;
+  terrain_chunk *Chunks;
+  u32 Count;
+  f32 *Heights; //VertexCount per chunk
+  u32 VertexCount;
+};
+// NOTE(MIGUEL): everything EngineRender needs from one update, so the update can go on to the
+//               next frame while this one is drawn (packet.h hands them over). All of it lives in
+//               the packet's arena, the render side also builds its queue there.
+typedef struct engine_frame_packet engine_frame_packet;
+struct engine_frame_packet
+{
+  arena Arena;
+  u64 BeginNs; //EngineBeginFrame stamp
+  v2f Res;
+  f32 Time;
+  draw_bucket Bucket;   //ui quads, written into UIMapped, past that in the arena until submit streams them
+  draw_bucket Bucket3d; //terrain transforms
+  b32 HasTerrain;
+  r2f TerrainPanel; //ui rect the terrain is scissored to
+  mesh_topology TerrainTopology;
+  engine_terrain_heights TerrainHeights;
+  terrain_selection TerrainSelection;
+  f32 *TerrainHeightData; //stream: Mesh.VertexCount heights per selected chunk
+  //texture: rects that scrolled in, each packed Width floats per row
+  heightfield_rect HeightmapRects[HEIGHTFIELD_MAX_CHANGED_RECTS];
+  f32 *HeightmapRectData[HEIGHTFIELD_MAX_CHANGED_RECTS];
+  u32 HeightmapRectCount;
+  b32 IsHeightmapFull; //too big for the arena, render reads the heightfield and update waits on it
+  u64 HeightsNs;       //update side of the heights work
+  u64 *InputTimes;     //os stamps of the input events this frame drained
+  u32 InputCount;
+  //- set by the render side, kept while the packet is refilled
+  quad_attribs *UIMapped; //the slot's mapped ui buffer, NULL when it could not be mapped
+  u32 UIMappedCapacity;   //quads
+  u32 UIBufferId;
+  u32 UIMappedBytes;      //written into UIMapped, to flush
+};
+typedef struct engine_memory engine_memory;
+struct engine_memory
+{
+  arena Permanent;
+};
+typedef struct engine_shader_src engine_shader_src;
+struct engine_shader_src
+{
+  const char *Vert;
+  s32         VertLength;
+  const char *Frag;
+  s32         FragLength;
+};
+// NOTE(MIGUEL): optional, EngineBuildDrawBuckets calls it last, while the packet's buckets are
+//               still open. lets a platform add its own quads or read the packet's stats without
+//               copying the frame sequence EngineUpdate runs.
+struct engine;
+typedef void engine_frame_hook(struct engine *Engine, engine_frame_packet *Packet, void *Data);
 struct engine
 {
-  struct android_app* App;
-  
-  int Active;
-  EGLDisplay Display;
-  EGLSurface Surface;
-  EGLContext Context;
   int32_t Width;
   int32_t Height;
   gfx_ctx GfxCtx;
   gfx_ctx GfxCtx3d;
-  draw_bucket Bucket;
-  draw_bucket Bucket3d;
-  vertex3d Quad3dPlane[QUAD3D_PLANE_QUADCOUNT*ArrayCount(QuadData3d)];
+  gfx_ctx GfxCtx3dHeightmap; //same mesh, heights from a texture
+  engine_memory Memory;
+  job_system *Jobs;
+  engine_frame_packet Packets[PACKET_QUEUE_MAX_COUNT];
+  packet_queue PacketQueue;
+  frame_pacer Pacer; //planned on the update side, fed swap times by the render side
+  terrain Terrain;
+  input_queue InputQueue; //platform input callback -> update
+  //- update side
+  input_state Input;
+  gesture_state Gestures;
+  f32 CameraYaw;         //radians
+  f32 CameraYawVelocity; //radians/s, left by a fling
+  f32 CameraZoom;
+  engine_frame_packet *Packet; //being filled, between EngineBeginFrame and EngineEndFrame
+  terrain_view TerrainView;
+  arena TerrainScratch;       //packet arena carve out for the terrain job
+  job_counter TerrainCounter; //select and scroll, kicked in EngineBeginFrame
+  u64 TerrainScrollNs;
+  mesh_topology TerrainTopology;
+  engine_terrain_heights TerrainHeights;
+  s64 HeightmapScroll;   //what the heightmap texture holds once every published packet is drawn
+  b32 IsHeightmapValid;
+  b32 IsHeightmapFullPending;
+  u64 FrameIndex;
+  engine_frame_hook *FrameHook;
+  void *FrameHookData;
+  u64 UpdateUINs;     //last EngineUpdate's begin frame and ui
+  u64 UpdateBucketNs; //and its draw buckets
+  //- render side, whichever thread has the gl context
+  gfx_ring StreamRing;
+  gfx_mapped_buffer UIBuffers[PACKET_QUEUE_MAX_COUNT]; //one per packet slot
+  render_queue RenderQueue;
+  b32 IsTerrainUploaded; //per gl context
+  engine_terrain_heights_stats HeightsStats[TerrainHeights_Count];
+  latency_histogram Latency[LatencyStage_Count];
+  //last rendered frame's input, waiting for EngineFramePresented
+  u64 PresentInputTimes[INPUT_FRAME_MAX_EVENTS];
+  u32 PresentInputCount;
+  u64 PresentBeginNs;
+  u64 PresentSubmitNs;
+  u64 PresentedCount;
+  ui_elm *UIElements;
+  u32 UIElementCapacity;
+  ui_grid_node *UIGridNodes;
+  ui_grid_span *UIGridSpans;
+  f32 *UIRects;
+  ui_table_entry *UITable;
+  //- update side ui
+  u32 UIItemCount;      //pushed and popped through the buttons
+  u32 UIDashboardCount; //static tiles, load for the ui paths
+  f32 UIDashboardScroll; //px
+  //startup timeline, GetTimeNanos() stamps
+  u64 CreatedAtNs;
+  u64 FirstFrameAtNs;
+  u64 TerrainShownAtNs;
 };
-static int EngineInitDisplay(struct engine* Engine)
-{
-  const EGLint Attribs[] =
-  {
-    EGL_SURFACE_TYPE, EGL_WINDOW_BIT,
-    EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
-    EGL_BLUE_SIZE, 8,
-    EGL_GREEN_SIZE, 8,
-    EGL_RED_SIZE, 8,
-    EGL_NONE,
-  };
-  
-  EGLDisplay Display;
-  if ((Display = eglGetDisplay(EGL_DEFAULT_DISPLAY)) == EGL_NO_DISPLAY)
-  {
-    LOG("error with eglGetDisplay");
-    return -1;
-  }
-  
-  if (!eglInitialize(Display, 0, 0))
-  {
-    LOG("error with eglInitialize");
-    return -1;
-  }
-  
-  EGLConfig Config;
-  EGLint NumConfigs;
-  if (!eglChooseConfig(Display, Attribs, &Config, 1, &NumConfigs))
-  {
-    LOG("error with eglChooseConfig");
-    return -1;
-  }
-  
-  EGLint Format;
-  if (!eglGetConfigAttrib(Display, Config, EGL_NATIVE_VISUAL_ID, &Format))
-  {
-    LOG("error with eglGetConfigAttrib");
-    return -1;
-  }
-  
-  ANativeWindow_setBuffersGeometry(Engine->App->window, 0, 0, Format);
-  
-  EGLSurface Surface;
-  if (!(Surface = eglCreateWindowSurface(Display, Config, Engine->App->window, NULL)))
-  {
-    LOG("error with eglCreateWindowSurface");
-    return -1;
-  }
-  
-  const EGLint CtxAttrib[] = { EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE };
-  EGLContext Context;
-  if (!(Context = eglCreateContext(Display, Config, NULL, CtxAttrib)))
-  {
-    LOG("error with eglCreateContext");
-    return -1;
-  }
-  
-  if (eglMakeCurrent(Display, Surface, Surface, Context) == EGL_FALSE)
-  {
-    LOG("error with eglMakeCurrent");
-    return -1;
-  }
-  
-  LOG("GL_VENDOR = %s", glGetString(GL_VENDOR));
-  LOG("GL_RENDERER = %s", glGetString(GL_RENDERER));
-  LOG("GL_VERSION = %s", glGetString(GL_VERSION));
-  
-  EGLint Width, Height;
-  eglQuerySurface(Display, Surface, EGL_WIDTH, &Width);
-  eglQuerySurface(Display, Surface, EGL_HEIGHT, &Height);
-  
-  Engine->Display = Display;
-  Engine->Context = Context;
-  Engine->Surface = Surface;
+// NOTE(MIGUEL): places the engine at the start of the platform's memory block. Everything that
+//               lives as long as the engine is pushed here, EngineInit can run again on a new
+//               gl context without allocating.
+static struct engine *EngineCreate(void *Memory, u64 MemorySize, u32 UIElementCapacity,
+                                   u32 JobThreadCount)
+{
+  u64 FramesSize = (u64)ENGINE_FRAME_ARENA_SIZE*PACKET_QUEUE_MAX_COUNT;
+  if(MemorySize <= FramesSize) return NULL;
+  engine_memory Arenas;
+  ArenaInit(&Arenas.Permanent, (u8 *)Memory+FramesSize, MemorySize-FramesSize);
+  struct engine *Engine = ArenaPushStruct(&Arenas.Permanent, struct engine);
+  ui_elm *UIElements    = ArenaPushArray(&Arenas.Permanent, ui_elm, UIElementCapacity);
+  ui_grid_node *UIGridNodes = ArenaPushArray(&Arenas.Permanent, ui_grid_node,
+                                             UIElementCapacity*UI_GRID_NODES_PER_ELEMENT);
+  ui_grid_span *UIGridSpans = ArenaPushArray(&Arenas.Permanent, ui_grid_span, UIElementCapacity);
+  f32 *UIRects          = ArenaPushAligned(&Arenas.Permanent, 4*UIRectsCapacity(UIElementCapacity)*sizeof(f32), 16);
+  ui_table_entry *UITable = ArenaPushArray(&Arenas.Permanent, ui_table_entry, UITableCapacity(UIElementCapacity));
+  job_system *Jobs      = ArenaPushAligned(&Arenas.Permanent, sizeof(job_system), JOB_CACHE_LINE);
+  if(!Engine || !UIElements || !UIGridNodes || !UIGridSpans || !UIRects || !UITable || !Jobs) return NULL;
+  MemorySet(0, Engine, sizeof(struct engine));
+  InputStateInit(&Engine->Input);
+  GestureStateInit(&Engine->Gestures);
+  FramePacerInit(&Engine->Pacer, ENGINE_TARGET_FPS, ENGINE_IDLE_AFTER_FRAMES);
+  Engine->CameraZoom = 1.0f;
+  Engine->Memory            = Arenas;
+  Engine->UIElements        = UIElements;
+  Engine->UIElementCapacity = UIElementCapacity;
+  Engine->UIGridNodes       = UIGridNodes;
+  Engine->UIGridSpans       = UIGridSpans;
+  Engine->UIRects           = UIRects;
+  Engine->UITable           = UITable;
+  Engine->Jobs              = Jobs;
+  Engine->TerrainTopology   = MeshTopology_Lines;
+  Engine->TerrainHeights    = ENGINE_TERRAIN_HEIGHTS;
+  Engine->CreatedAtNs       = GetTimeNanos();
+  for(u32 Slot=0; Slot<PACKET_QUEUE_MAX_COUNT; Slot++)
+  {
+    ArenaInit(&Engine->Packets[Slot].Arena, (u8 *)Memory+(u64)Slot*ENGINE_FRAME_ARENA_SIZE,
+              ENGINE_FRAME_ARENA_SIZE);
+  }
+  PacketQueueInit(&Engine->PacketQueue, ENGINE_FRAME_PACKETS);
+  //no gl needed, so the terrain can be underway before there is even a window
+  if(!TerrainBuildBegin(&Engine->Terrain, &Engine->Memory.Permanent,
+                        TERRAIN_CHUNK_QUADS, ENGINE_TERRAIN_ASYNC))
+  {
+    return NULL;
+  }
+  JobSystemInit(Engine->Jobs, JobThreadCount);
+  return Engine;
+}
+// NOTE(MIGUEL): the platform thread that called EngineCreate has to be the one calling this
+static void EngineDestroy(struct engine* Engine)
+{
+  TerrainBuildWait(&Engine->Terrain);
+  JobSystemTerm(Engine->Jobs);
+  PacketQueueTerm(&Engine->PacketQueue);
+  return;
+}
+// NOTE(MIGUEL): 2 or 3, only while nothing is in flight (no render thread running)
+static void EngineSetFramePackets(struct engine* Engine, u32 Count)
+{
+  Engine->PacketQueue.Count = Min(Max(Count, 1), PACKET_QUEUE_MAX_COUNT);
+  PacketQueueOpen(&Engine->PacketQueue);
+  return;
+}
+// NOTE(MIGUEL): uploads the cached terrain mesh the first time a packet has terrain in it, the
+//               update only puts it there once the build is done so the mesh is read only here.
+static void EngineTerrainUpload(struct engine* Engine)
+{
+  if(Engine->IsTerrainUploaded) return;
+  grid_mesh *Mesh = &Engine->Terrain.Mesh;
+  gfx_ctx *GfxCtx3d = &Engine->GfxCtx3d;
+  GfxCtx3d->VBufferId = GfxVertexBufferCreate(Mesh->Verts, sizeof(vertex3d), Mesh->VertexCount);
+  GfxCtx3d->EBufferId = GfxIndexBufferCreate(Mesh->Indices, Mesh->IndexCount);
+  GfxCtx3d->LayoutId  = Gfx3dCtxVertexLayoutCreate(GfxCtx3d);
+  gfx_ctx *Heightmap = &Engine->GfxCtx3dHeightmap;
+  Heightmap->VBufferId = GfxCtx3d->VBufferId;
+  Heightmap->EBufferId = GfxCtx3d->EBufferId;
+  Heightmap->TextureId = GfxHeightmapCreate(Engine->Terrain.Heightfield.Side);
+  Heightmap->LayoutId  = Gfx3dCtxVertexLayoutCreate(Heightmap);
+  Engine->IsTerrainUploaded = 1;
+  return;
+}
+// NOTE(MIGUEL): render side, the slot's packet must not be in the update's hands
+static void EngineMapPacketUIBuffer(struct engine* Engine, u32 Slot)
+{
+  gfx_mapped_buffer *Buffer = &Engine->UIBuffers[Slot];
+  engine_frame_packet *Packet = &Engine->Packets[Slot];
+  Packet->UIMapped         = Buffer->BufferId?GfxMappedBufferMap(Buffer):NULL;
+  Packet->UIMappedCapacity = Packet->UIMapped?Buffer->Size/sizeof(quad_attribs):0;
+  Packet->UIBufferId       = Buffer->BufferId;
+  Packet->UIMappedBytes    = 0;
+  return;
+}
+static int EngineInit(struct engine* Engine, int32_t Width, int32_t Height,
+                      engine_shader_src Shader, engine_shader_src Shader3d)
+{
   Engine->Width = Width;
   Engine->Height = Height;
   GlobalRes.x = Engine->Width;
   GlobalRes.y = Engine->Height;
-  
-  AAsset* VAsset = AAssetManager_open(Engine->App->activity->assetManager, "vertex.glsl", AASSET_MODE_BUFFER);
-  AAsset* FAsset = AAssetManager_open(Engine->App->activity->assetManager, "fragment.glsl", AASSET_MODE_BUFFER);
-  AAsset* VAsset3d = AAssetManager_open(Engine->App->activity->assetManager, "vertex3d.glsl", AASSET_MODE_BUFFER);
-  AAsset* FAsset3d = AAssetManager_open(Engine->App->activity->assetManager, "fragment3d.glsl", AASSET_MODE_BUFFER);
-  if (!VAsset) { LOG("error opening vertex.glsl"); return -1; }
-  if (!FAsset) { LOG("error opening vertex.glsl"); return -1; }
-  if (!VAsset3d) { LOG("error opening vertex3d.glsl"); return -1; }
-  if (!FAsset3d) { LOG("error opening vertex3d.glsl"); return -1; }
-  
-  const char* VertShaderSrc = AAsset_getBuffer(VAsset);
-  const char* FragShaderSrc = AAsset_getBuffer(FAsset);
-  s32         VertShaderSrcLength = AAsset_getLength(VAsset);
-  s32         FragShaderSrcLength = AAsset_getLength(FAsset);
-  
+  //fresh context, nothing the cache remembers is true anymore
+  GfxStateInvalidate();
+
+  GfxRingCreate(&Engine->StreamRing, ENGINE_STREAM_RING_FRAME_SIZE);
+  //no render thread yet, so every slot can be handed its mapped ui buffer from here
+  for(u32 Slot=0; Slot<PACKET_QUEUE_MAX_COUNT; Slot++)
+  {
+    GfxMappedBufferCreate(&Engine->UIBuffers[Slot], Engine->UIElementCapacity*sizeof(quad_attribs));
+    EngineMapPacketUIBuffer(Engine, Slot);
+  }
+
   gfx_ctx GfxCtx   = GfxCtxInit();
   GfxCtx.VBufferId = GfxVertexBufferCreate(QuadData, sizeof(vertex), ArrayCount(QuadData));
-  GfxCtx.IBufferId = GfxInstanceBufferCreate(NULL, sizeof(quad_attribs), DRAW_BUCKET_MAX_COUNT);
-  GfxCtx.ShaderId  = GfxShaderProgramCreate(VertShaderSrc, VertShaderSrcLength,
-                                            FragShaderSrc, FragShaderSrcLength);
+  GfxCtx.IBufferId = GfxInstanceBufferCreate(NULL, sizeof(quad_attribs), GFX_INSTANCE_OVERFLOW_COUNT);
+  GfxCtx.ShaderId  = GfxShaderProgramCreate(Shader.Vert, Shader.VertLength,
+                                            Shader.Frag, Shader.FragLength,
+                                            &GfxCtx.Uniforms);
   GfxCtx.LayoutId  = GfxVertexLayoutCreate(&GfxCtx);
-  AAsset_close(VAsset);
-  AAsset_close(FAsset);
-  
+
   //3d context
-#if 1
-  u32 VCount = ArrayCount(QuadData3d);
-  for(int i=0; i<ArrayCount(Engine->Quad3dPlane); i+=VCount)
-  {
-    vertex3d *Vert = &Engine->Quad3dPlane[i];
-    memcpy(Vert, QuadData3d, sizeof(QuadData3d));
-    u32 id = i/VCount;
-    for(int j=0; j<VCount; j++)
-    {
-      //QuadData3d;
-      f32 s = 1.0f/(f64)QUAD3D_PLANE_QUADCOUNT;
-      f32 OffsetX = fmod  ((f32)id,QUAD3D_PLANE_QUADS_PER_SIDE)*s*2.0f;
-      f32 OffsetZ = floorf((f32)id/QUAD3D_PLANE_QUADS_PER_SIDE)*s*2.0f;
-      Vert[j].Pos.x *= s;
-      Vert[j].Pos.z *= s;
-      Vert[j].Pos.x += OffsetX - QUAD3D_PLANE_QUADS_PER_SIDE*s;
-      Vert[j].Pos.z += OffsetZ - QUAD3D_PLANE_QUADS_PER_SIDE*s;
-      Vert[j].Uv.x += Vert[j].Pos.x;
-      Vert[j].Uv.y += Vert[j].Pos.z;
-      LOG("id: %6.d i: %6.d ofx: %6.3f ofy:%6.3f \n", id, i, OffsetX, OffsetZ);
-    }
-  }
-#endif
   gfx_ctx GfxCtx3d = GfxCtxInit();
-  const char* VertShaderSrc3d = AAsset_getBuffer(VAsset3d);
-  const char* FragShaderSrc3d = AAsset_getBuffer(FAsset3d);
-  s32         VertShaderSrcLength3d = AAsset_getLength(VAsset3d);
-  s32         FragShaderSrcLength3d = AAsset_getLength(FAsset3d);
-  GfxCtx3d.VBufferId = GfxVertexBufferCreate(Engine->Quad3dPlane, sizeof(vertex3d), ArrayCount(Engine->Quad3dPlane));
-  GfxCtx3d.ShaderId  = Gfx3dCtxShaderProgramCreate(VertShaderSrc3d, VertShaderSrcLength3d,
-                                                   FragShaderSrc3d, FragShaderSrcLength3d);
-  GfxCtx3d.LayoutId  = Gfx3dCtxVertexLayoutCreate(&GfxCtx3d);
-  AAsset_close(VAsset3d);
-  AAsset_close(FAsset3d);
-  
+  GfxCtx3d.ShaderId  = Gfx3dCtxShaderProgramCreate(Shader3d.Vert, Shader3d.VertLength,
+                                                   Shader3d.Frag, Shader3d.FragLength,
+                                                   NULL, &GfxCtx3d.Uniforms);
+  //UHeightmap is left at its default of texture unit 0
+  gfx_ctx GfxCtx3dHeightmap = GfxCtxInit();
+  GfxCtx3dHeightmap.ShaderId = Gfx3dCtxShaderProgramCreate(Shader3d.Vert, Shader3d.VertLength,
+                                                           Shader3d.Frag, Shader3d.FragLength,
+                                                           "#define HEIGHTMAP_TEXTURE\n",
+                                                           &GfxCtx3dHeightmap.Uniforms);
+
   Engine->GfxCtx3d = GfxCtx3d;
+  Engine->GfxCtx3dHeightmap = GfxCtx3dHeightmap;
   Engine->GfxCtx   = GfxCtx;
-  
-  UIStateInit(&GlobalUIState);
-  UIStateElementPush(&GlobalUIState, 
-                     UIElementInit(R2f(40.0f, GlobalRes.y-980.0f, (40.0f)+200.0f, (GlobalRes.y-980.0f)+200.0f),
-                                   V4f(0.0f, 1.0f, 1.0f, 1.0f), ELMPUSH_BTN_ELM_ID, UI_Flag_Selectable));
-  UIStateElementPush(&GlobalUIState,
-                     UIElementInit(R2f(40.0f+200.0f, GlobalRes.y-980.0f, (40.0f)+200.0f+200.0f, (GlobalRes.y-980.0f)+200.0f),
-                                   V4f(1.0f, 0.0f, 0.0f, 1.0f), ELMPOP_BTN_ELM_ID, UI_Flag_Selectable));
-  UIStateElementPush(&GlobalUIState,
-                     UIElementInit(R2f(40.0f, 40.0f, GlobalRes.x-40.0f, GlobalRes.y-1000.0f),
-                                   V4f(1.0f, 0.0f, 0.0f, 1.0f), GlobalUIState.ElementCount+1, UI_Flag_None));
+  Engine->IsTerrainUploaded = 0;
+  //the new heightmap texture starts empty. no render thread runs during init, so this is safe
+  //to reset from here and the next packet carries a full upload
+  Engine->IsHeightmapValid = 0;
+
+  //widgets get declared again from the first frame on, rects and selection start over
+  UIStateInit(&GlobalUIState, Engine->UIElements, Engine->UIElementCapacity, Engine->UITable);
+  UIGridInit(&GlobalUIState.Grid, Engine->UIGridNodes, Engine->UIElementCapacity*UI_GRID_NODES_PER_ELEMENT,
+             Engine->UIGridSpans, Engine->UIElementCapacity, GlobalRes);
+  UIRectsInit(&GlobalUIState.Rects, Engine->UIRects, Engine->UIElementCapacity);
   return 0;
 }
-static void EngineUpdate(struct engine* Engine)
+// NOTE(MIGUEL): the terrain panel's rect, EngineUpdateUI declares the panel element with it
+static r2f EngineTerrainPanelRect(void)
+{
+  return R2f(40.0f, 40.0f, GlobalRes.x-40.0f, GlobalRes.y-1000.0f);
+}
+static void EngineUpdateUI(struct engine* Engine)
 {
   // TODO(MIGUEL): make it so that element doesnt move on initial selection
-  // TODO(MIGUEL): make elm hierarchies
-  // TODO(MIGUEL): use attrib stacks
-  
-  //- ui logic begin 
-  // NOTE(MIGUEL): system user input/event/response data should be captured and stored in the ui state struct
-  //               using a UIBegin() call
-  // NOTE(MIGUEL): this using a stack based approach to elm creation for simplicity rather than a hash based approach
-  //               which is the more flexible one.
-  u32 IdGenerator = GlobalUIState.ElementCount; //is just a counter
+
+  //- ui logic begin
+  // NOTE(MIGUEL): every widget is declared again each frame under its key, UIStateEndFrame
+  //               evicts whatever stopped being declared (popped items, a smaller dashboard).
+  ui_state *UI = &GlobalUIState;
   u32 TouchedCount = 0;
   m2f Projection = M2fIdentity();
   m2f Rotate     = M2fIdentity();
   m2f Scale      = M2fScale(1.5f, 1.5f);
   M2fMultiply(&Rotate, &Scale, &Projection);
-  
-  for(ui_elm *Current = GlobalUIState.Elements;
-      ElementIsBeforeLastPushed(&GlobalUIState, Current); Current++)
+  UIStateBeginFrame(UI);
+  // NOTE(MIGUEL): picking happens once up front through the grid, against where things were at
+  //               the end of last frame. a selectable element wins over the panels under it,
+  //               anything else is only hot with no selectable one there.
+  ui_elm *Hot = UIStateHitTest(UI, GlobalTouchPos, UI_Flag_Selectable);
+  if(!Hot) { Hot = UIStateHitTest(UI, GlobalTouchPos, UI_Flag_None); }
+  ui_elm *TapHot = GlobalJustTapped?UIStateHitTest(UI, GlobalTapPos, UI_Flag_Selectable):NULL;
+
+  ui_elm *Toolbar = UIStateDeclareLayout(UI, UIKeyFromString("toolbar"), V2f(40.0f, GlobalRes.y-980.0f),
+                                         UILayout(UI_Axis_X, UISizeFit(), UISizeFit(), 0.0f, 0.0f),
+                                         V4f(0.0f, 0.0f, 0.0f, 0.0f), UI_Flag_Layout);
+  UIStatePushParent(UI, Toolbar);
+  ui_elm *Element = UIStateDeclareLayout(UI, UIKeyFromString("push button"), V2f(0.0f, 0.0f),
+                                         UILayout(UI_Axis_X, UISizeFixed(200.0f), UISizeFixed(200.0f), 0.0f, 0.0f),
+                                         V4f(0.0f, 1.0f, 1.0f, 1.0f), UI_Flag_Selectable);
+  ui_user_sig Signal = UIDoButton(Element, V4f(0.0f, 0.8f, 0.8f, 0.8f), V4f(0.0f, 1.0f, 1.0f, 1.0f), Hot, TapHot);
+  if(Signal.IsTouched && Signal.IsSelected && Signal.IsTapped)
+  {
+    Engine->UIItemCount = Min(Engine->UIItemCount+1, UI->Capacity);
+  }
+  TouchedCount += Signal.IsTouched;
+
+  Element = UIStateDeclareLayout(UI, UIKeyFromString("pop button"), V2f(0.0f, 0.0f),
+                                 UILayout(UI_Axis_X, UISizeFixed(200.0f), UISizeFixed(200.0f), 0.0f, 0.0f),
+                                 V4f(1.0f, 0.0f, 0.0f, 1.0f), UI_Flag_Selectable);
+  Signal = UIDoButton(Element, V4f(0.8f, 0.0f, 0.0f, 0.8f), V4f(1.0f, 0.0f, 0.0f, 1.0f), Hot, TapHot);
+  if(Signal.IsTouched && Signal.IsSelected && Signal.IsTapped && Engine->UIItemCount)
   {
-    ui_elm    *Element = Current;
-    ui_user_sig Signal = UIDoButton(Element);
-    if(Signal.IsTouched && Signal.IsSelected)
+    Engine->UIItemCount--;
+  }
+  TouchedCount += Signal.IsTouched;
+  UIStatePopParent(UI);
+
+  //the terrain panel isnt selectable, pressing on it lets go of the selection
+  Element = UIStateDeclare(UI, UIKeyFromString("terrain panel"), EngineTerrainPanelRect(),
+                           V4f(1.0f, 0.0f, 0.0f, 1.0f), UI_Flag_None);
+  UIDoButton(Element, V4f(0.08f, 0.08f, 0.08f, 0.8f), V4f(0.2f, 0.2f, 0.2f, 1.0f), Hot, TapHot);
+
+  // NOTE(MIGUEL): rows of ENGINE_DASHBOARD_COLUMNS tiles sharing the row's width, the column is
+  //               as tall as its rows. only laid out again when the count changes. it scrolls
+  //               inside the terrain panel: vertical drags there move the offset, the panel clips,
+  //               and the tiles fade while it's moving. none of it touches the layout.
+  if(Engine->UIDashboardCount)
+  {
+    r2f Panel = EngineTerrainPanelRect();
+    ui_key DashboardKey = UIKeyFromString("dashboard");
+    ui_elm *Dashboard = UIStateFindElement(UI, DashboardKey);
+    b32 IsScrolling = 0;
+    for(u32 i=0; i<Engine->Gestures.EventCount; i++)
     {
-      if(Signal.JustPressed && Element->Id==ELMPUSH_BTN_ELM_ID)
-      {
-        u32 Id = IdGenerator++;
-        u32 OffsetY = fmod((Id-3)*100.0f, GlobalRes.y);
-        u32 OffsetX = floorf((Id-3)*100.0f/GlobalRes.x)*4.0f;
-        ui_elm ElementToPush = UIElementInit(R2f(0.0f+OffsetX            , 000.0f+OffsetY,
-                                                 GlobalRes.x*0.5f+OffsetX, 100.0f+OffsetY),
-                                             V4f(1.0f, 0.0f, 0.0f, 1.0f), Id, UI_Flag_Selectable);
-        UIStateElementPush(&GlobalUIState, ElementToPush);
-      }
-      if(Signal.JustPressed && Element->Id==ELMPOP_BTN_ELM_ID)
+      gesture_event *Event = &Engine->Gestures.Events[i];
+      if(Event->Kind != Gesture_Drag || !IsInRect(Panel, Event->Origin) || !ElementNoneSelected(UI)) continue;
+      Engine->UIDashboardScroll -= Event->Vector.y;
+      IsScrolling = 1;
+    }
+    f32 MaxScroll = Dashboard?Max(Dashboard->Measured.y-(Panel.max.y-Panel.min.y), 0.0f):0.0f;
+    Engine->UIDashboardScroll = Min(Max(Engine->UIDashboardScroll, 0.0f), MaxScroll);
+    UIStatePushClip(UI, Panel);
+    UIStatePushOffset(UI, V2f(0.0f, -Engine->UIDashboardScroll));
+    UIStatePushColor(UI, IsScrolling?V4f(1.0f, 1.0f, 1.0f, 0.6f):V4f(1.0f, 1.0f, 1.0f, 1.0f));
+    Dashboard = UIStateDeclareLayout(UI, DashboardKey, V2f(40.0f, 40.0f),
+                                     UILayout(UI_Axis_Y, UISizeFixed(GlobalRes.x-80.0f), UISizeFit(),
+                                              8.0f, 8.0f),
+                                     V4f(0.0f, 0.0f, 0.0f, 0.0f), UI_Flag_Layout);
+    UIStatePushParent(UI, Dashboard);
+    for(u32 Row=0; Row*ENGINE_DASHBOARD_COLUMNS<Engine->UIDashboardCount; Row++)
+    {
+      ui_elm *RowElement = UIStateDeclareLayout(UI, UIKeyCombine(DashboardKey, ~(u64)Row), V2f(0.0f, 0.0f),
+                                                UILayout(UI_Axis_X, UISizeGrow(1.0f), UISizeFixed(80.0f),
+                                                         0.0f, 8.0f),
+                                                V4f(0.0f, 0.0f, 0.0f, 0.0f), UI_Flag_Layout);
+      UIStatePushParent(UI, RowElement);
+      u32 End = Min((Row+1)*ENGINE_DASHBOARD_COLUMNS, Engine->UIDashboardCount);
+      for(u32 i=Row*ENGINE_DASHBOARD_COLUMNS; i<End; i++)
       {
-        if(ElementStorageCount(&GlobalUIState) > 3)
-        {
-          UIStateElementPop(&GlobalUIState);
-          IdGenerator--;
-        }
+        Element = UIStateDeclareLayout(UI, UIKeyCombine(DashboardKey, i), V2f(0.0f, 0.0f),
+                                       UILayout(UI_Axis_X, UISizeGrow(1.0f), UISizeGrow(1.0f), 0.0f, 0.0f),
+                                       V4f(0.5f, 0.5f, 0.5f, 1.0f), UI_Flag_None);
+        UIDoButton(Element, V4f(0.08f, 0.08f, 0.08f, 0.8f), V4f(0.2f, 0.2f, 0.2f, 1.0f), Hot, TapHot);
       }
+      UIStatePopParent(UI);
     }
+    UIStatePopParent(UI);
+    UIStatePopColor(UI);
+    UIStatePopOffset(UI);
+    UIStatePopClip(UI);
+  }
+
+  ui_key ItemsKey = UIKeyFromString("items");
+  for(u32 i=0; i<Engine->UIItemCount; i++)
+  {
+    f32 OffsetY = fmodf(i*100.0f, GlobalRes.y);
+    f32 OffsetX = floorf(i*100.0f/GlobalRes.x)*4.0f;
+    Element = UIStateDeclare(UI, UIKeyCombine(ItemsKey, i),
+                             R2f(OffsetX, OffsetY, GlobalRes.x*0.5f+OffsetX, 100.0f+OffsetY),
+                             V4f(1.0f, 0.0f, 0.0f, 1.0f), UI_Flag_Selectable);
+    Signal = UIDoButton(Element, V4f(0.08f, 0.08f, 0.08f, 0.8f), V4f(0.2f, 0.2f, 0.2f, 1.0f), Hot, TapHot);
     TouchedCount += Signal.IsTouched;
   }
-  // NOTE(MIGUEL): v this type of code that relies on post processe info doen on all ui elm should be 
-  //                 in a UIEnd() function.
   if(TouchedCount==0 && GlobalJustPressed)
   {
-    GlobalUIState.SelectedId = UI_NULL_ELEMENT_ID;
+    UI->SelectedKey = UI_NULL_KEY;
   }
+  UIStateEndFrame(UI);
   //- ui logic end
-  DrawBucketBegin(&Engine->Bucket, NULL, NULL);
-  DrawBucketPushUIElements(&Engine->Bucket,
-                           GlobalUIState.ZList.Bottom,
-                           GlobalUIState.ElementCount);
-  DrawBucketEnd(&Engine->Bucket); //does nothing for now. look at stub def comment for my impl idea
-  
-  
+  return;
+}
+static void EngineHeightsJob(void *Data)
+{
+  engine_heights_job *Job = (engine_heights_job *)Data;
+  for(u32 i=0; i<Job->Count; i++)
+  {
+    TerrainChunkHeights(Job->Terrain, &Job->Chunks[i], Job->Heights+i*Job->VertexCount);
+  }
+  return;
+}
+// NOTE(MIGUEL): every selected chunk's heights gathered into the packet by jobs of
+//               ENGINE_HEIGHTS_JOB_CHUNKS chunks, EngineStreamTerrainHeights copies them into the
+//               ring in one map. the whole selection is dropped if the arena is out of room.
+static void EngineGatherTerrainHeights(struct engine* Engine, engine_frame_packet *Packet)
+{
+  terrain_selection *Selection = &Packet->TerrainSelection;
+  u32 VertexCount = Engine->Terrain.Mesh.VertexCount;
+  u32 JobCount = (Selection->Count+ENGINE_HEIGHTS_JOB_CHUNKS-1)/ENGINE_HEIGHTS_JOB_CHUNKS;
+  f32 *Heights = ArenaPushArray(&Packet->Arena, f32, (u64)Selection->Count*VertexCount);
+  engine_heights_job *HeightsJobs = ArenaPushArray(&Packet->Arena, engine_heights_job, JobCount);
+  if(!Heights || !HeightsJobs)
+  {
+    Selection->DroppedCount += Selection->Count;
+    Selection->Count         = 0;
+    return;
+  }
+  job_counter Counter = {0};
+  for(u32 JobIndex=0; JobIndex<JobCount; JobIndex++)
+  {
+    u32 First = JobIndex*ENGINE_HEIGHTS_JOB_CHUNKS;
+    engine_heights_job *Job = &HeightsJobs[JobIndex];
+    Job->Terrain     = &Engine->Terrain;
+    Job->Chunks      = Selection->Chunks+First;
+    Job->Count       = Min(ENGINE_HEIGHTS_JOB_CHUNKS, Selection->Count-First);
+    Job->Heights     = Heights+First*VertexCount;
+    Job->VertexCount = VertexCount;
+    JobRun(Engine->Jobs, EngineHeightsJob, Job, &Counter);
+  }
+  JobWait(Engine->Jobs, &Counter);
+  Packet->TerrainHeightData = Heights;
+  return;
+}
+// NOTE(MIGUEL): what the heightmap texture is missing, as of the last published packet. rects
+//               are copied into the packet, anything too big for it (a new texture, a long stall)
+//               becomes a full upload that the render side reads straight from the heightfield.
+static void EnginePackTerrainHeightmap(struct engine* Engine, engine_frame_packet *Packet)
+{
+  heightfield *Heightfield = &Engine->Terrain.Heightfield;
+  terrain_selection *Selection = &Packet->TerrainSelection;
+  for(u32 i=0; i<Selection->Count; i++)
+  {
+    Selection->Chunks[i].HeightmapParams = TerrainChunkHeightmapParams(&Engine->Terrain, &Selection->Chunks[i]);
+  }
+  heightfield_rect Rects[HEIGHTFIELD_MAX_CHANGED_RECTS];
+  u32 RectCount = HeightfieldChangedRects(Heightfield, Engine->HeightmapScroll,
+                                          Engine->IsHeightmapValid, Rects);
+  b32 IsFull = !Engine->IsHeightmapValid;
+  for(u32 i=0; i<RectCount && !IsFull; i++)
+  {
+    heightfield_rect Rect = Rects[i];
+    f32 *Data = ArenaPushArray(&Packet->Arena, f32, (u64)Rect.Width*Rect.Height);
+    if(!Data) { IsFull = 1; break; }
+    for(u32 y=0; y<Rect.Height; y++)
+    {
+      memcpy(Data+(u64)y*Rect.Width, Heightfield->Heights+(u64)(Rect.y+y)*Heightfield->Side+Rect.x,
+             Rect.Width*sizeof(f32));
+    }
+    Packet->HeightmapRects[i]    = Rect;
+    Packet->HeightmapRectData[i] = Data;
+    Packet->HeightmapRectCount   = i+1;
+  }
+  if(IsFull)
+  {
+    Packet->HeightmapRectCount     = 0;
+    Packet->IsHeightmapFull        = 1;
+    Engine->IsHeightmapFullPending = 1;
+  }
+  Engine->HeightmapScroll  = Heightfield->Scroll;
+  Engine->IsHeightmapValid = 1;
+  return;
+}
+static void EngineSetTerrainHeights(struct engine* Engine, engine_terrain_heights Heights)
+{
+  Engine->TerrainHeights = Heights;
+  return;
+}
+static void EngineLogTerrainHeights(struct engine* Engine)
+{
+  for(u32 Heights=0; Heights<TerrainHeights_Count; Heights++)
+  {
+    engine_terrain_heights_stats *Stats = &Engine->HeightsStats[Heights];
+    f64 Frames = Stats->FrameCount?(f64)Stats->FrameCount:1.0;
+    LOG("terrain heights| %-7s frames: %llu frame: %.1fus heights: %.1fus bytes/frame: %.0f",
+        EngineTerrainHeightsNames[Heights], (unsigned long long)Stats->FrameCount,
+        Stats->FrameNs/Frames/1000.0, Stats->HeightsNs/Frames/1000.0, Stats->Bytes/Frames);
+  }
+  return;
+}
+// NOTE(MIGUEL): the terrain's frame, lod selection then the heightfield scroll (itself spread
+//               over jobs). reads nothing the ui touches, so it runs while EngineUpdateUI does.
+static void EngineTerrainJob(void *Data)
+{
+  struct engine *Engine = (struct engine *)Data;
+  TerrainSelect(&Engine->Packet->TerrainSelection, &Engine->TerrainView, &Engine->TerrainScratch);
+  u64 ScrollBegin = GetTimeNanos();
+  TerrainScroll(&Engine->Terrain, GlobalTimeElapsed, Engine->Jobs);
+  Engine->TerrainScrollNs = GetTimeNanos()-ScrollBegin;
+  return;
+}
+static void EngineUpdateInput(struct engine* Engine)
+{
+  input_state *Input = &Engine->Input;
+  InputStateUpdate(Input, &Engine->InputQueue);
+  GlobalTouchPos     = Input->PrimaryPos;
+  GlobalTouchDelta   = Input->Delta;
+  GlobalIsPressed    = Input->IsPressed;
+  GlobalJustPressed  = Input->JustPressed;
+  GlobalJustReleased = Input->JustReleased;
+  GestureStateUpdate(&Engine->Gestures, Input);
+  gesture_event Tap;
+  GlobalJustTapped = GestureFind(&Engine->Gestures, Gesture_Tap, &Tap);
+  GlobalTapPos     = GlobalJustTapped?Tap.Pos:GlobalTapPos;
+  return;
+}
+// NOTE(MIGUEL): gestures that start in the terrain panel while no ui element is selected (a
+//               selected element follows the touch) steer the camera. a horizontal drag across the
+//               whole screen is four turns, fling keeps turning and slows down, pinch zooms and
+//               two finger rotate turns.
+#define ENGINE_CAMERA_YAW_PER_SCREEN (3.14f*8.0f)
+#define ENGINE_CAMERA_FLING_DECAY (4.0f) //per second
+#define ENGINE_CAMERA_MIN_ZOOM (0.25f)
+#define ENGINE_CAMERA_MAX_ZOOM (4.0f)
+static void EngineUpdateCamera(struct engine* Engine)
+{
+  gesture_state *Gestures = &Engine->Gestures;
+  r2f Panel = EngineTerrainPanelRect();
+  b32 IsFree = ElementNoneSelected(&GlobalUIState);
+  f32 YawPerPx = ENGINE_CAMERA_YAW_PER_SCREEN/GlobalRes.x;
+  Engine->CameraYaw += Engine->CameraYawVelocity*(f32)GlobalDeltaTime;
+  Engine->CameraYawVelocity *= expf(-ENGINE_CAMERA_FLING_DECAY*(f32)GlobalDeltaTime);
+  for(u32 i=0; i<Gestures->EventCount; i++)
+  {
+    gesture_event *Event = &Gestures->Events[i];
+    if(!IsFree || !IsInRect(Panel, Event->Origin)) continue;
+    switch(Event->Kind)
+    {
+      case Gesture_Drag:
+      {
+        Engine->CameraYaw        += Event->Vector.x*YawPerPx;
+        Engine->CameraYawVelocity = 0.0f;
+      } break;
+      case Gesture_Fling:  { Engine->CameraYawVelocity = Event->Vector.x*YawPerPx; } break;
+      case Gesture_Rotate: { Engine->CameraYaw += Event->Angle; } break;
+      case Gesture_Pinch:
+      {
+        Engine->CameraZoom = Min(Max(Engine->CameraZoom*Event->Scale, ENGINE_CAMERA_MIN_ZOOM),
+                                 ENGINE_CAMERA_MAX_ZOOM);
+      } break;
+      default: break;
+    }
+  }
+  return;
+}
+// NOTE(MIGUEL): takes the next free frame packet, blocking while the render side still has all
+//               of them, and kicks the terrain job. EngineBuildDrawBuckets waits on it and
+//               EngineEndFrame hands the packet over. 0 when there is no one to render
+//               (the packet queue is closed), the frame is skipped.
+static b32 EngineBeginFrame(struct engine* Engine)
+{
+  //a full heightmap upload reads the heightfield on the render side, it can't scroll under it
+  if(Engine->IsHeightmapFullPending)
+  {
+    PacketQueueWaitIdle(&Engine->PacketQueue);
+    Engine->IsHeightmapFullPending = 0;
+  }
+  u32 Slot = 0;
+  if(!PacketQueueBeginWrite(&Engine->PacketQueue, &Slot)) return 0;
+  //drained after the wait for a packet so the frame sees the freshest input
+  EngineUpdateInput(Engine);
+  engine_frame_packet *Packet = &Engine->Packets[Slot];
+  arena Arena = Packet->Arena;
+  ArenaReset(&Arena);
+  quad_attribs *UIMapped = Packet->UIMapped;
+  u32 UIMappedCapacity   = Packet->UIMappedCapacity;
+  u32 UIBufferId         = Packet->UIBufferId;
+  MemorySet(0, Packet, sizeof(engine_frame_packet));
+  Packet->Arena            = Arena;
+  Packet->UIMapped         = UIMapped;
+  Packet->UIMappedCapacity = UIMappedCapacity;
+  Packet->UIBufferId       = UIBufferId;
+  Packet->BeginNs         = GetTimeNanos();
+  Packet->Res             = GlobalRes;
+  Packet->Time            = (f32)GlobalTimeElapsed;
+  Packet->TerrainTopology = Engine->TerrainTopology;
+  Packet->InputTimes      = ArenaPushArray(&Packet->Arena, u64, Engine->Input.EventCount);
+  Packet->InputCount      = Packet->InputTimes?Engine->Input.EventCount:0;
+  for(u32 i=0; i<Packet->InputCount; i++) { Packet->InputTimes[i] = Engine->Input.Events[i].TimeNs; }
+  Engine->Packet = Packet;
+#if ENGINE_TERRAIN_HEIGHTS_SWITCH_FRAMES
+  if(Engine->FrameIndex && (Engine->FrameIndex % ENGINE_TERRAIN_HEIGHTS_SWITCH_FRAMES) == 0)
+  {
+    EngineSetTerrainHeights(Engine, (Engine->TerrainHeights+1) % TerrainHeights_Count);
+    EngineLogTerrainHeights(Engine);
+  }
+#endif
+  Packet->TerrainHeights = Engine->TerrainHeights;
+
   //- 3d logic begin
   // not going to render q quad mesh just as point list
-  
+
   //- 3d logic end
   mat4 P = GLM_MAT4_IDENTITY_INIT;
   mat4 M = GLM_MAT4_IDENTITY_INIT;
-  mat4 V = GLM_MAT4_IDENTITY_INIT;
-  mat4 T = GLM_MAT4_IDENTITY_INIT;
-  
-  // NOTE(MIGUEL): v these are hardcoded copied values based ui elm defined in EngineInitDisplay code
-  f32 ctrlx =GlobalTouchPos.x/GlobalRes.x;
-  f32 ctrly =GlobalTouchPos.y/GlobalRes.y;
-  glm_scale    (M, (vec3){800.0f, 1.0f, 800.0f});
-  glm_rotate   (M, ctrlx*3.14f*8.0f, (vec3){0.0f, 1.0f, 0.0f});
+
+  EngineUpdateCamera(Engine);
+  f32 Scale = 800.0f*Engine->CameraZoom;
+  glm_scale    (M, (vec3){Scale, 1.0f, Scale});
+  glm_rotate   (M, Engine->CameraYaw, (vec3){0.0f, 1.0f, 0.0f});
   glm_translate(M, (vec3){0.0f, 2.0, 10.0f});
   glm_frustum(0.0f, GlobalRes.x, 0.0f, GlobalRes.y, 0.1f, 100.0f, P);
-  DrawBucketBegin(&Engine->Bucket3d, M, P);
-  DrawBucketPushQuad(&Engine->Bucket3d, 1); //does nothing
-  DrawBucketEnd(&Engine->Bucket3d); //does nothing for now. look at stub def comment for my impl idea
+  DrawBucketBegin(&Packet->Bucket3d, NULL, NULL, 0, 0, M, P);
+  // NOTE(MIGUEL): UModel goes up transposed and the shader doesnt apply UProjection, so the
+  //               transposed model is what actually takes the terrain to clip space
+  mat4 ClipFromLocal;
+  glm_mat4_transpose_to(M, ClipFromLocal);
+  TerrainViewInit(&Engine->TerrainView, ClipFromLocal, GlobalRes.x, GlobalRes.y, TERRAIN_LOD_ERROR_PX);
+  Engine->TerrainScrollNs = 0;
+  Packet->HasTerrain   = TerrainIsReady(&Engine->Terrain);
+  Packet->TerrainPanel = EngineTerrainPanelRect();
+  if(Packet->HasTerrain)
+  {
+    Engine->TerrainScratch = ArenaSub(&Packet->Arena,
+                                      TERRAIN_MAX_CHUNKS*sizeof(terrain_chunk)+ARENA_DEFAULT_ALIGNMENT);
+    JobRun(Engine->Jobs, EngineTerrainJob, Engine, &Engine->TerrainCounter);
+  }
+  return 1;
+}
+static void EngineBuildDrawBuckets(struct engine* Engine)
+{
+  engine_frame_packet *Packet = Engine->Packet;
+  //every element fits the mapped buffer, the quads written there are never copied again
+  DrawBucketBegin(&Packet->Bucket, &Packet->Arena, Packet->UIMapped, Packet->UIMappedCapacity,
+                  Packet->UIBufferId, NULL, NULL);
+  //only what overlaps the screen goes in the bucket
+  u32 SlotCount = GlobalUIState.SlotCount;
+  u32 *VisibleBits = ArenaPushArray(&Packet->Arena, u32, UIRectsBitWords(SlotCount));
+  if(VisibleBits)
+  {
+    UIRectsHitTestRect(&GlobalUIState.Rects, SlotCount, R2f(0.0f, 0.0f, Packet->Res.x, Packet->Res.y),
+                       VisibleBits);
+  }
+  DrawBucketPushUIElements(&Packet->Bucket, &GlobalUIState, VisibleBits);
+
+  if(Packet->HasTerrain)
+  {
+    JobWait(Engine->Jobs, &Engine->TerrainCounter);
+    u64 HeightsBegin = GetTimeNanos();
+    switch(Packet->TerrainHeights)
+    {
+      case TerrainHeights_Stream:  { EngineGatherTerrainHeights(Engine, Packet); } break;
+      case TerrainHeights_Texture: { EnginePackTerrainHeightmap(Engine, Packet); } break;
+      default: break;
+    }
+    Packet->HeightsNs = Engine->TerrainScrollNs+GetTimeNanos()-HeightsBegin;
+  }
+  DrawBucketPushQuad(&Packet->Bucket3d, 1); //does nothing
+  if(Engine->FrameHook) { Engine->FrameHook(Engine, Packet, Engine->FrameHookData); }
+  Packet->UIMappedBytes = DrawBucketEnd(&Packet->Bucket);
+  DrawBucketEnd(&Packet->Bucket3d); //does nothing for now. look at stub def comment for my impl idea
   return;
 }
-static void EngineDrawFrame(struct engine* Engine)
+// NOTE(MIGUEL): publishes the packet, from here on it belongs to EngineRender
+static void EngineEndFrame(struct engine* Engine)
 {
-  if (Engine->Display == NULL) { return; }
-  
-  GfxClearScreen(0.1f, 0.1f, 0.12f, 1.0f);
-  
-  GfxCtxDrawBucketInstanced(&Engine->GfxCtx, &Engine->Bucket);
-  GfxCtxDraw(&Engine->GfxCtx3d, &Engine->Bucket3d, Engine->Quad3dPlane, ArrayCount(Engine->Quad3dPlane));
-  eglSwapBuffers(Engine->Display, Engine->Surface);
-  
+  Engine->Packet = NULL;
+  Engine->FrameIndex++;
+  PacketQueueEndWrite(&Engine->PacketQueue);
+  return;
+}
+// NOTE(MIGUEL): whether the frame just updated had anything going on, the pacer idles after
+//               enough frames without. input wakes it, so a frame is never missed for it.
+static b32 EngineIsAnimating(struct engine* Engine)
+{
+  b32 Result = (Engine->Input.EventCount || Engine->Input.PointerCount ||
+                Engine->CameraYawVelocity > 1e-3f || Engine->CameraYawVelocity < -1e-3f ||
+                !TerrainIsReady(&Engine->Terrain) ||
+                ENGINE_TERRAIN_ANIMATED);
+  return Result;
+}
+// NOTE(MIGUEL): the terrain job runs alongside the ui update and bucket build, the platform
+//               thread joins it right before the terrain heights are packed. the packet is
+//               drawn by EngineRender, on the render thread or right after this. 0 when the
+//               frame was skipped (no one to render).
+static b32 EngineUpdate(struct engine* Engine)
+{
+  u64 Begin = GetTimeNanos();
+  if(!EngineBeginFrame(Engine)) return 0;
+  EngineUpdateUI(Engine);
+  u64 UIEnd = GetTimeNanos();
+  EngineBuildDrawBuckets(Engine);
+  Engine->UpdateUINs     = UIEnd-Begin;
+  Engine->UpdateBucketNs = GetTimeNanos()-UIEnd;
+  EngineEndFrame(Engine);
+  return 1;
+}
+static void EngineLogStartup(struct engine* Engine)
+{
+  terrain *Terrain = &Engine->Terrain;
+  f64 Ms = 1.0/1000000.0;
+  if(!Engine->IsTerrainUploaded)
+  {
+    //the builder may still be writing its stats
+    LOG("startup| first frame: %.2fms (terrain still building)",
+        (Engine->FirstFrameAtNs-Engine->CreatedAtNs)*Ms);
+    return;
+  }
+  LOG("startup| first frame: %.2fms terrain built in %.2fms (%s), ready at %.2fms, drawn at %.2fms",
+      (Engine->FirstFrameAtNs-Engine->CreatedAtNs)*Ms, Terrain->BuildNs*Ms,
+      ENGINE_TERRAIN_ASYNC?"worker":"inline",
+      (Terrain->ReadyAtNs-Engine->CreatedAtNs)*Ms,
+      (Engine->TerrainShownAtNs-Engine->CreatedAtNs)*Ms);
+  return;
+}
+//~ RENDER SIDE
+// NOTE(MIGUEL): the packet's gathered heights go into the ring in one map. chunks past the
+//               segment's room are dropped for the frame.
+static void EngineStreamTerrainHeights(struct engine* Engine, engine_frame_packet *Packet)
+{
+  terrain_selection *Selection = &Packet->TerrainSelection;
+  u32 VertexCount = Engine->Terrain.Mesh.VertexCount;
+  u32 ChunkSize   = VertexCount*sizeof(f32);
+  u32 FitCount    = Min(Selection->Count, GfxRingRoom(&Engine->StreamRing)/ChunkSize);
+  u32 Offset = 0;
+  f32 *Heights = FitCount?GfxRingMap(&Engine->StreamRing, FitCount*ChunkSize, &Offset):NULL;
+  if(!Heights) { FitCount = 0; }
+  if(FitCount) { memcpy(Heights, Packet->TerrainHeightData, FitCount*ChunkSize); }
+  for(u32 i=0; i<FitCount; i++) { Selection->Chunks[i].HeightsOffset = Offset+i*ChunkSize; }
+  GfxRingUnmap(&Engine->StreamRing, FitCount*ChunkSize);
+  Selection->DroppedCount += Selection->Count-FitCount;
+  Selection->Count         = FitCount;
+  return;
+}
+static void EngineUploadTerrainHeightmap(struct engine* Engine, engine_frame_packet *Packet)
+{
+  GLuint TextureId = Engine->GfxCtx3dHeightmap.TextureId;
+  if(Packet->IsHeightmapFull)
+  {
+    heightfield *Heightfield = &Engine->Terrain.Heightfield;
+    GfxHeightmapUpload(TextureId, Heightfield->Heights, Heightfield->Side,
+                       0, 0, Heightfield->Side, Heightfield->Side);
+  }
+  for(u32 i=0; i<Packet->HeightmapRectCount; i++)
+  {
+    heightfield_rect Rect = Packet->HeightmapRects[i];
+    GfxHeightmapUpload(TextureId, Packet->HeightmapRectData[i], Rect.Width,
+                       Rect.x, Rect.y, Rect.Width, Rect.Height);
+  }
   return;
 }
-static void EngineTermDisplay(struct engine* Engine)
+// NOTE(MIGUEL): draws the oldest published packet. Wait blocks for one (render thread), without
+//               it this returns 0 straight away when there is nothing to draw. also 0 once the
+//               packet queue is closed.
+static b32 EngineRender(struct engine* Engine, b32 Wait)
 {
-  if (Engine->Display != EGL_NO_DISPLAY)
+  u32 Slot = 0;
+  if(!PacketQueueBeginRead(&Engine->PacketQueue, Wait, &Slot)) return 0;
+  engine_frame_packet *Packet = &Engine->Packets[Slot];
+  GfxFrameBegin();
+  GfxRingFrameBegin(&Engine->StreamRing);
+  //a buffer cant be drawn from while it is mapped
+  GfxMappedBufferUnmap(&Engine->UIBuffers[Slot], Packet->UIMappedBytes);
+  if(Packet->HasTerrain)
   {
-    glDeleteProgram(Engine->GfxCtx.ShaderId);
-    glDeleteBuffers(1, &Engine->GfxCtx.VBufferId);
-    
-    eglMakeCurrent(Engine->Display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
-    if (Engine->Context != EGL_NO_CONTEXT)
+    EngineTerrainUpload(Engine);
+    u64 HeightsBegin = GetTimeNanos();
+    u32 BytesBegin   = GlobalGfxFrameStats.StreamBytes+GlobalGfxFrameStats.TextureBytes;
+    switch(Packet->TerrainHeights)
     {
-      eglDestroyContext(Engine->Display, Engine->Context);
+      case TerrainHeights_Stream:  { EngineStreamTerrainHeights(Engine, Packet); } break;
+      case TerrainHeights_Texture: { EngineUploadTerrainHeightmap(Engine, Packet); } break;
+      default: break;
     }
-    if (Engine->Surface != EGL_NO_SURFACE)
+    engine_terrain_heights_stats *Stats = &Engine->HeightsStats[Packet->TerrainHeights];
+    Stats->HeightsNs += Packet->HeightsNs+GetTimeNanos()-HeightsBegin;
+    Stats->Bytes     += GlobalGfxFrameStats.StreamBytes+GlobalGfxFrameStats.TextureBytes-BytesBegin;
+  }
+
+  render_queue *Queue = &Engine->RenderQueue;
+  RenderQueueBegin(Queue, &Packet->Arena, RENDER_QUEUE_MAX_COUNT);
+  Queue->Res  = Packet->Res;
+  Queue->Time = Packet->Time;
+  Queue->ClipRect = Packet->TerrainPanel;
+  GfxCtxPushQuads(Queue, RenderLayer_UI, &Engine->GfxCtx, &Packet->Bucket);
+  if(Packet->HasTerrain)
+  {
+    mesh_topology Topology = Packet->TerrainTopology;
+    grid_mesh *Mesh = &Engine->Terrain.Mesh;
+    terrain_selection *Selection = &Packet->TerrainSelection;
+    b32 IsTexture = (Packet->TerrainHeights == TerrainHeights_Texture);
+    gfx_ctx *Ctx = IsTexture?&Engine->GfxCtx3dHeightmap:&Engine->GfxCtx3d;
+    for(u32 i=0; i<Selection->Count; i++)
     {
-      eglDestroySurface(Engine->Display, Engine->Surface);
+      terrain_chunk *Chunk = &Selection->Chunks[i];
+      GfxCtxPushMesh(Queue, RenderLayer_World, Ctx, &Packet->Bucket3d,
+                     (Topology==MeshTopology_Lines)?GL_LINES:GL_TRIANGLES,
+                     Mesh->IndexOffset[Topology], Mesh->IndexCountOf[Topology],
+                     Chunk->Params, Chunk->HeightsOffset, Chunk->HeightmapParams);
     }
-    eglTerminate(Engine->Display);
   }
-  Engine->Active = 0;
-  Engine->Display = EGL_NO_DISPLAY;
-  Engine->Context = EGL_NO_CONTEXT;
-  Engine->Surface = EGL_NO_SURFACE;
+  RenderQueueSort(Queue, &Packet->Arena);
+
+  GfxViewport(0, 0, Engine->Width, Engine->Height);
+  GfxClearScreen(0.1f, 0.1f, 0.12f, 1.0f);
+  GfxSubmitQueue(Queue, &Engine->StreamRing);
+  GfxRingFrameEnd(&Engine->StreamRing);
+  //the draws are in, the next update of this slot writes into fresh storage
+  EngineMapPacketUIBuffer(Engine, Slot);
+  GfxFrameEnd();
+
+  u64 Now = GetTimeNanos();
+  if(Packet->HasTerrain)
+  {
+    engine_terrain_heights_stats *Stats = &Engine->HeightsStats[Packet->TerrainHeights];
+    Stats->FrameCount++;
+    Stats->FrameNs += Now-Packet->BeginNs;
+  }
+  b32 IsFirstFrame = (Engine->FirstFrameAtNs == 0);
+  if(IsFirstFrame) { Engine->FirstFrameAtNs = Now; }
+  if(Packet->HasTerrain && Engine->TerrainShownAtNs == 0)
+  {
+    Engine->TerrainShownAtNs = Now;
+    if(!IsFirstFrame) { EngineLogStartup(Engine); }
+  }
+  if(IsFirstFrame) { EngineLogStartup(Engine); }
+  //the packet is given back before the swap, keep what latency needs
+  Engine->PresentInputCount = Packet->InputCount;
+  Engine->PresentBeginNs    = Packet->BeginNs;
+  Engine->PresentSubmitNs   = Now;
+  memcpy(Engine->PresentInputTimes, Packet->InputTimes, Packet->InputCount*sizeof(u64));
+  PacketQueueEndRead(&Engine->PacketQueue);
+  return 1;
+}
+static void EngineLogLatency(struct engine* Engine)
+{
+  for(u32 Stage=0; Stage<LatencyStage_Count; Stage++)
+  {
+    latency_histogram *Histogram = &Engine->Latency[Stage];
+    LOG("input latency| %-7s events: %llu p50: %.2fms p90: %.2fms p99: %.2fms max: %.2fms",
+        EngineLatencyStageNames[Stage], (unsigned long long)Histogram->TotalCount,
+        LatencyHistogramPercentile(Histogram, 0.50)/1000000.0,
+        LatencyHistogramPercentile(Histogram, 0.90)/1000000.0,
+        LatencyHistogramPercentile(Histogram, 0.99)/1000000.0,
+        Histogram->MaxNs/1000000.0);
+  }
   return;
 }
-static int32_t EngineHandleInput(struct android_app* App, AInputEvent* Event)
-{
-  // NOTE(MIGUEL): do i even need to take input in this function?????
-  if((AInputEvent_getSource(Event) == AINPUT_SOURCE_TOUCHSCREEN) &&
-     (AInputEvent_getType  (Event) == AINPUT_EVENT_TYPE_MOTION))
-  {
-    u32 Action   = AMotionEvent_getAction(Event);
-    u32 PtrIndex = ((Action >>  AMOTION_EVENT_ACTION_POINTER_INDEX_SHIFT));
-    //touch pos taking into account offset from stuff like nav bar
-    GlobalTouchPos.x = AMotionEvent_getRawX(Event,PtrIndex) + AMotionEvent_getXOffset(Event);
-    GlobalTouchPos.y = AMotionEvent_getRawY(Event,PtrIndex) + AMotionEvent_getYOffset(Event);
-    //GlobalTouchDelta.x = GlobalTouchPos.x-AMotionEvent_getHistoricalX(Event, PtrIndex, 1);
-    //GlobalTouchDelta.y = GlobalTouchPos.y-AMotionEvent_getHistoricalY(Event, PtrIndex, 1);
-    
-    LOG("Input| x: %f, y: %f", GlobalTouchPos.x, GlobalTouchPos.y);
-    switch(Action)
+// NOTE(MIGUEL): the platform calls this on the render side once the swap for the frame
+//               EngineRender just drew returns, PresentNs a GetTimeNanos() stamp
+static void EngineFramePresented(struct engine* Engine, u64 PresentNs)
+{
+  u64 Stamps[LatencyStage_Count] = { Engine->PresentBeginNs, Engine->PresentSubmitNs, PresentNs };
+  for(u32 i=0; i<Engine->PresentInputCount; i++)
+  {
+    u64 EventNs = Engine->PresentInputTimes[i];
+    for(u32 Stage=0; Stage<LatencyStage_Count; Stage++)
     {
-      case AMOTION_EVENT_ACTION_POINTER_DOWN:
-      {
-        //GlobalTouchPos.x = AMotionEvent_getRawX(Event, PtrIndex);
-        //GlobalTouchPos.y = AMotionEvent_getRawY(Event, PtrIndex);
-        
-      } break;
-      case AMOTION_EVENT_ACTION_DOWN:
-      {
-        GlobalJustPressed = GlobalIsPressed?0:1;
-        GlobalIsPressed = 1;
-      } break;
-      case AMOTION_EVENT_ACTION_UP:
-      {
-        GlobalIsPressed = 0;
-      } break;
-      default:
-      {
-        
-      } break;
+      //a clock the stamp came from that runs ahead would make this wrap
+      LatencyHistogramAdd(&Engine->Latency[Stage], (Stamps[Stage]>EventNs)?(Stamps[Stage]-EventNs):0);
     }
   }
-  return 0;
+  Engine->PresentInputCount = 0;
+  Engine->PresentedCount++;
+  FramePacerPresented(&Engine->Pacer, PresentNs-Engine->PresentBeginNs);
+#if ENGINE_LATENCY_LOG_FRAMES
+  if((Engine->PresentedCount % ENGINE_LATENCY_LOG_FRAMES) == 0) { EngineLogLatency(Engine); }
+#endif
+  return;
 }
-static void EngineHandleCmd(struct android_app* App, int32_t Cmd)
+static void EngineLogMemory(struct engine* Engine)
 {
-  struct engine* Engine = (struct engine*)App->userData;
-  switch (Cmd)
+  arena *Permanent = &Engine->Memory.Permanent;
+  u64 HighWater = 0;
+  u32 FailedPushCount = Permanent->FailedPushCount;
+  for(u32 Slot=0; Slot<PACKET_QUEUE_MAX_COUNT; Slot++)
   {
-    case APP_CMD_INIT_WINDOW:
-    if (Engine->App->window != NULL)
-    {
-      EngineInitDisplay(Engine);
-      EngineDrawFrame(Engine);
-    }
-    break;
-    case APP_CMD_TERM_WINDOW:
-    EngineTermDisplay(Engine);
-    break;
-    case APP_CMD_GAINED_FOCUS:
-    Engine->Active = 1;
-    break;
-    case APP_CMD_LOST_FOCUS:
-    Engine->Active = 0;
-    EngineDrawFrame(Engine);
-    break;
+    HighWater        = Max(HighWater, Engine->Packets[Slot].Arena.HighWater);
+    FailedPushCount += Engine->Packets[Slot].Arena.FailedPushCount;
   }
+  LOG("memory| permanent: %llu/%llu bytes frame high water: %llu/%llu bytes failed pushes: %u",
+      (unsigned long long)Permanent->Used, (unsigned long long)Permanent->Size,
+      (unsigned long long)HighWater, (unsigned long long)ENGINE_FRAME_ARENA_SIZE, FailedPushCount);
+  LOG("frame packets| %u in flight max, update waited %.2fms, render waited %.2fms",
+      Engine->PacketQueue.Count, Engine->PacketQueue.ProducerWaitNs/1000000.0,
+      Engine->PacketQueue.ConsumerWaitNs/1000000.0);
+  return;
+}
+static void EngineTerm(struct engine* Engine)
+{
+  GfxDeleteProgram(Engine->GfxCtx.ShaderId);
+  GfxDeleteVertexArray(Engine->GfxCtx.LayoutId);
+  GfxDeleteBuffer(Engine->GfxCtx.VBufferId);
+  GfxDeleteBuffer(Engine->GfxCtx.IBufferId);
+  GfxDeleteProgram(Engine->GfxCtx3d.ShaderId);
+  //the layouts only exist once the terrain was uploaded, gl ignores 0
+  GfxDeleteVertexArray(Engine->GfxCtx3d.LayoutId);
+  GfxDeleteBuffer(Engine->GfxCtx3d.VBufferId);
+  GfxDeleteBuffer(Engine->GfxCtx3d.EBufferId);
+  GfxDeleteVertexArray(Engine->GfxCtx3dHeightmap.LayoutId);
+  GfxDeleteTexture(Engine->GfxCtx3dHeightmap.TextureId);
+  GfxDeleteProgram(Engine->GfxCtx3dHeightmap.ShaderId);
+  //the mesh stays cached, the next context just uploads it again
+  Engine->IsTerrainUploaded = 0;
+  GfxRingDestroy(&Engine->StreamRing);
+  for(u32 Slot=0; Slot<PACKET_QUEUE_MAX_COUNT; Slot++)
+  {
+    GfxMappedBufferDestroy(&Engine->UIBuffers[Slot]);
+    EngineMapPacketUIBuffer(Engine, Slot);
+  }
+  GfxStateInvalidate();
+  return;
 }
 
 #endif //ENGINE_H
@@ -0,0 +1,295 @@
+#ifndef GESTURE_H
+#define GESTURE_H
+
+// NOTE(MIGUEL): Gesture recognition over the frame's input events (input.h). Every pointer that
+//               is down keeps its last GESTURE_SAMPLE_COUNT samples in a fixed ring, velocity is a
+//               least squares line through the ones inside GESTURE_VELOCITY_WINDOW_NS. Out comes
+//               a short list of gesture events per frame:
+//                 tap    - one pointer down and up quickly without leaving the slop
+//                 drag   - one pointer past the slop, Vector is this frame's movement
+//                 pinch  - two pointers, Scale is this frame's change in their distance
+//                 rotate - two pointers, Angle is this frame's change in their angle (radians)
+//                 fling  - a drag released fast, Vector is the velocity in px/s
+//               drag, pinch and rotate are summed into one event each per frame. Origin is where
+//               the gesture started, so consumers can tell whose it is.
+#define GESTURE_SAMPLE_COUNT (16) //power of 2
+#define GESTURE_VELOCITY_WINDOW_NS (100000000ULL)
+#define GESTURE_TAP_MAX_NS (300000000ULL)
+#define GESTURE_TOUCH_SLOP_PX (24.0f)
+#define GESTURE_FLING_MIN_SPEED (1000.0f) //px/s
+#define GESTURE_FRAME_MAX_EVENTS (16)
+typedef enum gesture_kind gesture_kind;
+enum gesture_kind
+{
+  Gesture_Tap,
+  Gesture_Drag,
+  Gesture_Pinch,
+  Gesture_Rotate,
+  Gesture_Fling,
+  Gesture_Count,
+};
+typedef struct gesture_event gesture_event;
+struct gesture_event
+{
+  gesture_kind Kind;
+  v2f Origin; //where the first pointer of the gesture went down
+  v2f Pos;    //latest position, the pair's midpoint for pinch and rotate
+  v2f Vector; //drag: movement, fling: velocity
+  f32 Scale;  //pinch
+  f32 Angle;  //rotate
+};
+typedef struct gesture_sample gesture_sample;
+struct gesture_sample
+{
+  u64 TimeNs;
+  v2f Pos;
+};
+typedef struct gesture_pointer gesture_pointer;
+struct gesture_pointer
+{
+  s32 Id;
+  u64 DownTimeNs;
+  v2f DownPos;
+  f32 Travel; //furthest it got from DownPos
+  gesture_sample Samples[GESTURE_SAMPLE_COUNT];
+  u32 SampleCount; //ever pushed, the ring holds the last GESTURE_SAMPLE_COUNT
+};
+typedef struct gesture_state gesture_state;
+struct gesture_state
+{
+  gesture_pointer Pointers[INPUT_MAX_POINTERS];
+  u32 PointerCount;
+  //- since the first pointer went down
+  v2f Origin;
+  u32 MaxPointerCount;
+  b32 IsDragging;
+  //- two pointer baseline, reset whenever the pair changes
+  s32 PairIds[2];
+  f32 PairDistance;
+  f32 PairAngle;
+  //- this frame
+  gesture_event Events[GESTURE_FRAME_MAX_EVENTS];
+  u32 EventCount;
+};
+void GestureStateInit(gesture_state *State)
+{
+  MemorySet(0, State, sizeof(gesture_state));
+  State->PairIds[0] = INPUT_NULL_POINTER_ID;
+  State->PairIds[1] = INPUT_NULL_POINTER_ID;
+  return;
+}
+gesture_pointer *GestureFindPointer(gesture_state *State, s32 PointerId)
+{
+  for(u32 i=0; i<State->PointerCount; i++)
+  {
+    if(State->Pointers[i].Id == PointerId) return &State->Pointers[i];
+  }
+  return NULL;
+}
+void GesturePointerPushSample(gesture_pointer *Pointer, u64 TimeNs, v2f Pos)
+{
+  gesture_sample *Sample = &Pointer->Samples[Pointer->SampleCount++&(GESTURE_SAMPLE_COUNT-1)];
+  Sample->TimeNs = TimeNs;
+  Sample->Pos    = Pos;
+  f32 dx = Pos.x-Pointer->DownPos.x;
+  f32 dy = Pos.y-Pointer->DownPos.y;
+  Pointer->Travel = Max(Pointer->Travel, sqrtf(dx*dx+dy*dy));
+  return;
+}
+v2f GesturePointerPos(gesture_pointer *Pointer)
+{
+  return Pointer->Samples[(Pointer->SampleCount-1)&(GESTURE_SAMPLE_COUNT-1)].Pos;
+}
+// NOTE(MIGUEL): px/s, slope of the least squares line through the recent samples per axis.
+//               time is taken relative to the newest sample so the sums stay small.
+v2f GesturePointerVelocity(gesture_pointer *Pointer)
+{
+  v2f Result = V2f(0.0f, 0.0f);
+  u32 Count = Min(Pointer->SampleCount, GESTURE_SAMPLE_COUNT);
+  if(Count < 2) return Result;
+  u64 Newest = Pointer->Samples[(Pointer->SampleCount-1)&(GESTURE_SAMPLE_COUNT-1)].TimeNs;
+  f64 St = 0, Stt = 0, Sx = 0, Sy = 0, Stx = 0, Sty = 0;
+  u32 n = 0;
+  for(u32 i=0; i<Count; i++)
+  {
+    gesture_sample *Sample = &Pointer->Samples[(Pointer->SampleCount-1-i)&(GESTURE_SAMPLE_COUNT-1)];
+    if(Newest-Sample->TimeNs > GESTURE_VELOCITY_WINDOW_NS) break;
+    f64 t = -(f64)(Newest-Sample->TimeNs)/1000000000.0;
+    St  += t;
+    Stt += t*t;
+    Sx  += Sample->Pos.x;
+    Sy  += Sample->Pos.y;
+    Stx += t*Sample->Pos.x;
+    Sty += t*Sample->Pos.y;
+    n++;
+  }
+  f64 Denom = n*Stt-St*St;
+  if(n < 2 || Denom < 1e-12) return Result;
+  Result.x = (f32)((n*Stx-St*Sx)/Denom);
+  Result.y = (f32)((n*Sty-St*Sy)/Denom);
+  return Result;
+}
+// NOTE(MIGUEL): drag, pinch and rotate add into the frame's event of their kind
+void GestureEmit(gesture_state *State, gesture_event Event)
+{
+  b32 IsSummed = (Event.Kind == Gesture_Drag || Event.Kind == Gesture_Pinch || Event.Kind == Gesture_Rotate);
+  for(u32 i=0; IsSummed && i<State->EventCount; i++)
+  {
+    gesture_event *Sum = &State->Events[i];
+    if(Sum->Kind != Event.Kind) continue;
+    Sum->Pos       = Event.Pos;
+    Sum->Vector.x += Event.Vector.x;
+    Sum->Vector.y += Event.Vector.y;
+    Sum->Scale    *= Event.Scale;
+    Sum->Angle    += Event.Angle;
+    return;
+  }
+  if(State->EventCount < GESTURE_FRAME_MAX_EVENTS) { State->Events[State->EventCount++] = Event; }
+  return;
+}
+gesture_event GestureEvent(gesture_state *State, gesture_kind Kind, v2f Pos)
+{
+  gesture_event Result = {0};
+  Result.Kind   = Kind;
+  Result.Origin = State->Origin;
+  Result.Pos    = Pos;
+  Result.Scale  = 1.0f;
+  return Result;
+}
+// NOTE(MIGUEL): the first two pointers form the pair. their distance and angle become the new
+//               baseline whenever the pair is a different one than last time.
+void GestureUpdatePair(gesture_state *State)
+{
+  if(State->PointerCount < 2)
+  {
+    State->PairIds[0] = INPUT_NULL_POINTER_ID;
+    State->PairIds[1] = INPUT_NULL_POINTER_ID;
+    return;
+  }
+  gesture_pointer *a = &State->Pointers[0];
+  gesture_pointer *b = &State->Pointers[1];
+  v2f PosA = GesturePointerPos(a);
+  v2f PosB = GesturePointerPos(b);
+  f32 dx = PosB.x-PosA.x;
+  f32 dy = PosB.y-PosA.y;
+  f32 Distance = sqrtf(dx*dx+dy*dy);
+  f32 Angle    = atan2f(dy, dx);
+  b32 IsSamePair = (State->PairIds[0] == a->Id && State->PairIds[1] == b->Id);
+  if(IsSamePair)
+  {
+    v2f Mid = V2f((PosA.x+PosB.x)*0.5f, (PosA.y+PosB.y)*0.5f);
+    f32 Turn = Angle-State->PairAngle;
+    if(Turn >  3.14159265f) { Turn -= 2.0f*3.14159265f; }
+    if(Turn < -3.14159265f) { Turn += 2.0f*3.14159265f; }
+    if(State->PairDistance > 0.0f && Distance != State->PairDistance)
+    {
+      gesture_event Pinch = GestureEvent(State, Gesture_Pinch, Mid);
+      Pinch.Scale = Distance/State->PairDistance;
+      GestureEmit(State, Pinch);
+    }
+    if(Turn != 0.0f)
+    {
+      gesture_event Rotate = GestureEvent(State, Gesture_Rotate, Mid);
+      Rotate.Angle = Turn;
+      GestureEmit(State, Rotate);
+    }
+  }
+  State->PairIds[0]   = a->Id;
+  State->PairIds[1]   = b->Id;
+  State->PairDistance = Distance;
+  State->PairAngle    = Angle;
+  return;
+}
+void GestureStateApply(gesture_state *State, input_event *Event)
+{
+  gesture_pointer *Pointer = GestureFindPointer(State, Event->PointerId);
+  switch(Event->Kind)
+  {
+    case InputEvent_Down:
+    {
+      if(Pointer || State->PointerCount >= INPUT_MAX_POINTERS) break;
+      if(State->PointerCount == 0)
+      {
+        State->Origin          = Event->Pos;
+        State->MaxPointerCount = 0;
+        State->IsDragging      = 0;
+      }
+      Pointer = &State->Pointers[State->PointerCount++];
+      MemorySet(0, Pointer, sizeof(gesture_pointer));
+      Pointer->Id         = Event->PointerId;
+      Pointer->DownTimeNs = Event->TimeNs;
+      Pointer->DownPos    = Event->Pos;
+      GesturePointerPushSample(Pointer, Event->TimeNs, Event->Pos);
+      State->MaxPointerCount = Max(State->MaxPointerCount, State->PointerCount);
+      GestureUpdatePair(State);
+    } break;
+    case InputEvent_Move:
+    {
+      if(!Pointer) break;
+      v2f Last = GesturePointerPos(Pointer);
+      GesturePointerPushSample(Pointer, Event->TimeNs, Event->Pos);
+      if(State->MaxPointerCount == 1)
+      {
+        b32 IsFirstDrag = (!State->IsDragging && Pointer->Travel > GESTURE_TOUCH_SLOP_PX);
+        if(IsFirstDrag) { State->IsDragging = 1; }
+        if(State->IsDragging)
+        {
+          //the slop is not held back, the drag starts from where the pointer went down
+          v2f From = IsFirstDrag?Pointer->DownPos:Last;
+          gesture_event Drag = GestureEvent(State, Gesture_Drag, Event->Pos);
+          Drag.Vector = V2f(Event->Pos.x-From.x, Event->Pos.y-From.y);
+          GestureEmit(State, Drag);
+        }
+      }
+      else
+      {
+        GestureUpdatePair(State);
+      }
+    } break;
+    case InputEvent_Up:
+    case InputEvent_Cancel:
+    {
+      b32 IsCancel = (Event->Kind == InputEvent_Cancel);
+      if(Pointer && !IsCancel && State->MaxPointerCount == 1)
+      {
+        GesturePointerPushSample(Pointer, Event->TimeNs, Event->Pos);
+        v2f Velocity = GesturePointerVelocity(Pointer);
+        f32 Speed = sqrtf(Velocity.x*Velocity.x+Velocity.y*Velocity.y);
+        if(!State->IsDragging && Pointer->Travel <= GESTURE_TOUCH_SLOP_PX &&
+           Event->TimeNs-Pointer->DownTimeNs <= GESTURE_TAP_MAX_NS)
+        {
+          GestureEmit(State, GestureEvent(State, Gesture_Tap, Event->Pos));
+        }
+        else if(State->IsDragging && Speed >= GESTURE_FLING_MIN_SPEED)
+        {
+          gesture_event Fling = GestureEvent(State, Gesture_Fling, Event->Pos);
+          Fling.Vector = Velocity;
+          GestureEmit(State, Fling);
+        }
+      }
+      if(IsCancel)        { State->PointerCount = 0; }
+      else if(Pointer)    { *Pointer = State->Pointers[--State->PointerCount]; }
+      GestureUpdatePair(State);
+    } break;
+  }
+  return;
+}
+// NOTE(MIGUEL): after InputStateUpdate, runs the frame's events through the recognizers
+void GestureStateUpdate(gesture_state *State, input_state *Input)
+{
+  State->EventCount = 0;
+  for(u32 i=0; i<Input->EventCount; i++) { GestureStateApply(State, &Input->Events[i]); }
+  return;
+}
+b32 GestureFind(gesture_state *State, gesture_kind Kind, gesture_event *Event)
+{
+  for(u32 i=0; i<State->EventCount; i++)
+  {
+    if(State->Events[i].Kind != Kind) continue;
+    *Event = State->Events[i];
+    return 1;
+  }
+  return 0;
+}
+
+#endif //GESTURE_H
@@ -1,8 +1,17 @@
 #ifndef GFX_H
 #define GFX_H
 
-#include <EGL/egl.h>
+// NOTE(MIGUEL): GFX_BACKEND_NULL swaps the driver for a cpu-only stand-in so the engine core
+//               can run headless (see linux_main.c). Everything below is backend agnostic.
+#if defined(GFX_BACKEND_NULL)
+#include "gfx_null.h"
+#else
 #include <GLES3/gl31.h>
+#endif
+// NOTE(MIGUEL): GFX_BACKEND_RECORD layers a command recorder over either driver (see gfx_record.h)
+#if defined(GFX_BACKEND_RECORD)
+#include "gfx_record.h"
+#endif
 
 // NOTE(MIGUEL): Canonical Vertex.. for now
 //-TYPES
@@ -14,6 +23,63 @@ struct vertex3d
 { v3f Pos; v2f Uv; };
 //-TYPES
 
+// NOTE(MIGUEL): Uniforms the engine knows how to feed. Locations/types are resolved once when the
+//               program is created and each slot remembers a hash of the last value it uploaded,
+//               so per draw we only pay for uniforms whose value actually changed.
+typedef enum gfx_uniform_id gfx_uniform_id;
+enum gfx_uniform_id
+{
+  GfxUniform_WinRes,
+  GfxUniform_Time,
+  GfxUniform_Model,
+  GfxUniform_Projection,
+  GfxUniform_Chunk,
+  GfxUniform_HeightmapChunk,
+  GfxUniform_Count,
+};
+const char *GfxUniformNames[GfxUniform_Count] =
+{
+  "UWinRes",
+  "UTime",
+  "UModel",
+  "UProjection",
+  "UChunk",
+  "UHeightmapChunk",
+};
+typedef struct gfx_uniform gfx_uniform;
+struct gfx_uniform
+{
+  const char *Name;
+  GLint  Location; //-1 when the program doesnt use it
+  GLenum Type;
+  u32    Size;     //bytes
+  u64    Hash;     //of the last uploaded value
+  b32    IsUploaded;
+};
+typedef struct gfx_uniform_table gfx_uniform_table;
+struct gfx_uniform_table
+{
+  GLuint ProgramId;
+  gfx_uniform Uniforms[GfxUniform_Count];
+};
+typedef struct gfx_frame_stats gfx_frame_stats;
+struct gfx_frame_stats
+{
+  u32 UniformUploads;
+  u32 UniformSkips;
+  u32 StateCalls; //state changes that reached the driver
+  u32 StateSkips; //redundant ones the state cache filtered out
+  u32 StreamBytes;  //written into the stream ring
+  u32 MappedBytes;  //written in place into mapped packet buffers, never copied
+  u32 StreamStalls; //times the cpu had to wait on the gpu for a ring segment
+  u32 OverflowDraws; //instanced draws that had to go through the orphaned overflow buffer
+  u32 RenderCmds;  //commands submitted from the render queue
+  u32 DrawCalls;   //draws they turned into
+  u32 MergedDraws; //draws saved by folding adjacent instance ranges
+  u32 TextureBytes; //handed to glTexSubImage2D
+};
+gfx_frame_stats GlobalGfxFrameStats = {0};
+
 typedef struct gfx_ctx gfx_ctx;
 struct gfx_ctx
 {
@@ -22,14 +88,268 @@ struct gfx_ctx
   u32 IStride;
   GLuint VBufferId;
   GLuint IBufferId;
+  GLuint EBufferId; //16 bit indices, part of the layout's vao state
   GLuint SBufferId;
   GLuint ShaderId;
+  GLuint TextureId; //bound to unit 0. mesh draws sample heights from it instead of the ring
+  gfx_uniform_table Uniforms;
 };
 gfx_ctx GfxCtxInit(void)
 {
   gfx_ctx Result = {0};
   return Result;
 }
+//~ UNIFORMS
+u64 GfxHashBytes(const void *Data, u32 Size)
+{
+  //fnv-1a
+  const u8 *Bytes = Data;
+  u64 Hash = 0xcbf29ce484222325ULL;
+  for(u32 i=0; i<Size; i++)
+  {
+    Hash ^= Bytes[i];
+    Hash *= 0x100000001b3ULL;
+  }
+  return Hash;
+}
+u32 GfxUniformTypeSize(GLenum Type)
+{
+  u32 Result = ((Type==GL_FLOAT     )?sizeof(f32)*1:
+                (Type==GL_FLOAT_VEC2)?sizeof(f32)*2:
+                (Type==GL_FLOAT_VEC3)?sizeof(f32)*3:
+                (Type==GL_FLOAT_VEC4)?sizeof(f32)*4:
+                (Type==GL_FLOAT_MAT4)?sizeof(f32)*16: 0);
+  return Result;
+}
+void GfxUniformTableBuild(gfx_uniform_table *Table, GLuint ProgramId)
+{
+  Table->ProgramId = ProgramId;
+  for(u32 Id=0; Id<GfxUniform_Count; Id++)
+  {
+    gfx_uniform *Uniform = &Table->Uniforms[Id];
+    Uniform->Name       = GfxUniformNames[Id];
+    Uniform->Location   = -1;
+    Uniform->Type       = 0;
+    Uniform->Size       = 0;
+    Uniform->Hash       = 0;
+    Uniform->IsUploaded = 0;
+  }
+  GLint ActiveCount = 0;
+  glGetProgramiv(ProgramId, GL_ACTIVE_UNIFORMS, &ActiveCount);
+  for(GLint Index=0; Index<ActiveCount; Index++)
+  {
+    GLchar Name[64];
+    GLsizei NameLength = 0;
+    GLint   ArraySize = 0;
+    GLenum  Type = 0;
+    glGetActiveUniform(ProgramId, Index, sizeof(Name), &NameLength, &ArraySize, &Type, Name);
+    for(u32 Id=0; Id<GfxUniform_Count; Id++)
+    {
+      gfx_uniform *Uniform = &Table->Uniforms[Id];
+      if(strcmp(Uniform->Name, Name) != 0) continue;
+      Uniform->Location = glGetUniformLocation(ProgramId, Name);
+      Uniform->Type     = Type;
+      Uniform->Size     = GfxUniformTypeSize(Type);
+      break;
+    }
+  }
+  return;
+}
+// NOTE(MIGUEL): Value has to point at Size bytes for the uniform's type. The program that owns the
+//               table must be bound.
+void GfxUniformSet(gfx_uniform_table *Table, gfx_uniform_id Id, const void *Value)
+{
+  gfx_uniform *Uniform = &Table->Uniforms[Id];
+  if(Uniform->Location < 0 || Uniform->Size == 0) return;
+  u64 Hash = GfxHashBytes(Value, Uniform->Size);
+  if(Uniform->IsUploaded && Uniform->Hash == Hash)
+  {
+    GlobalGfxFrameStats.UniformSkips++;
+    return;
+  }
+  switch(Uniform->Type)
+  {
+    case GL_FLOAT:      { glUniform1fv(Uniform->Location, 1, Value); } break;
+    case GL_FLOAT_VEC2: { glUniform2fv(Uniform->Location, 1, Value); } break;
+    case GL_FLOAT_VEC3: { glUniform3fv(Uniform->Location, 1, Value); } break;
+    case GL_FLOAT_VEC4: { glUniform4fv(Uniform->Location, 1, Value); } break;
+    case GL_FLOAT_MAT4: { glUniformMatrix4fv(Uniform->Location, 1, 1, Value); } break;
+    default: return;
+  }
+  Uniform->Hash       = Hash;
+  Uniform->IsUploaded = 1;
+  GlobalGfxFrameStats.UniformUploads++;
+  return;
+}
+//~ STATE CACHE
+// NOTE(MIGUEL): Shadow copy of the gl state the engine touches. Every bind/enable in the gfx code
+//               goes through here and is dropped when it wouldnt change anything. Draws set the
+//               state they need instead of restoring it after themselves.
+//               Anything not marked Known is re-sent on the next set, so invalidate whenever
+//               the context is (re)created or state is changed behind the cache's back.
+typedef enum gfx_state_flags gfx_state_flags;
+enum gfx_state_flags
+{
+  GfxState_Program       = (1<<0),
+  GfxState_VertexArray   = (1<<1),
+  GfxState_ArrayBuffer   = (1<<2),
+  GfxState_ElementBuffer = (1<<3),
+  GfxState_Blend         = (1<<4),
+  GfxState_BlendFunc     = (1<<5),
+  GfxState_ScissorTest   = (1<<6),
+  GfxState_Scissor       = (1<<7),
+  GfxState_Viewport      = (1<<8),
+  GfxState_Texture       = (1<<9),
+};
+typedef struct gfx_state gfx_state;
+struct gfx_state
+{
+  u32    Known; //gfx_state_flags
+  GLuint Program;
+  GLuint VertexArray;
+  GLuint ArrayBuffer;
+  GLuint ElementBuffer;
+  b32    Blend;
+  GLenum BlendSrc;
+  GLenum BlendDst;
+  b32    ScissorTest;
+  GLint  Scissor[4];
+  GLint  Viewport[4];
+  GLuint Texture; //GL_TEXTURE_2D on unit 0, the only unit the engine uses
+};
+gfx_state GlobalGfxState = {0};
+
+void GfxStateInvalidate(void)
+{
+  GlobalGfxState.Known = 0;
+  return;
+}
+// NOTE(MIGUEL): returns whether the caller has to forward the change to gl
+b32 GfxStateCheck(u32 Flag, b32 IsSame)
+{
+  b32 Result = !((GlobalGfxState.Known & Flag) && IsSame);
+  GlobalGfxState.Known |= Flag;
+  if(Result) { GlobalGfxFrameStats.StateCalls++; }
+  else       { GlobalGfxFrameStats.StateSkips++; }
+  return Result;
+}
+void GfxUseProgram(GLuint Program)
+{
+  if(GfxStateCheck(GfxState_Program, GlobalGfxState.Program==Program))
+  {
+    GlobalGfxState.Program = Program;
+    glUseProgram(Program);
+  }
+  return;
+}
+void GfxBindVertexArray(GLuint VertexArray)
+{
+  if(GfxStateCheck(GfxState_VertexArray, GlobalGfxState.VertexArray==VertexArray))
+  {
+    GlobalGfxState.VertexArray = VertexArray;
+    glBindVertexArray(VertexArray);
+    //element buffer binding is vao state
+    GlobalGfxState.Known &= ~GfxState_ElementBuffer;
+  }
+  return;
+}
+void GfxBindBuffer(GLenum Target, GLuint Buffer)
+{
+  b32 IsArray = (Target==GL_ARRAY_BUFFER);
+  b32 IsElement = (Target==GL_ELEMENT_ARRAY_BUFFER);
+  if(!IsArray && !IsElement) { glBindBuffer(Target, Buffer); return; }
+  GLuint *Bound = IsArray?&GlobalGfxState.ArrayBuffer:&GlobalGfxState.ElementBuffer;
+  if(GfxStateCheck(IsArray?GfxState_ArrayBuffer:GfxState_ElementBuffer, *Bound==Buffer))
+  {
+    *Bound = Buffer;
+    glBindBuffer(Target, Buffer);
+  }
+  return;
+}
+void GfxSetBlend(b32 Enable)
+{
+  if(GfxStateCheck(GfxState_Blend, GlobalGfxState.Blend==Enable))
+  {
+    GlobalGfxState.Blend = Enable;
+    if(Enable) glEnable(GL_BLEND); else glDisable(GL_BLEND);
+  }
+  return;
+}
+void GfxBlendFunc(GLenum Src, GLenum Dst)
+{
+  if(GfxStateCheck(GfxState_BlendFunc, GlobalGfxState.BlendSrc==Src && GlobalGfxState.BlendDst==Dst))
+  {
+    GlobalGfxState.BlendSrc = Src;
+    GlobalGfxState.BlendDst = Dst;
+    glBlendFunc(Src, Dst);
+  }
+  return;
+}
+void GfxSetScissorTest(b32 Enable)
+{
+  if(GfxStateCheck(GfxState_ScissorTest, GlobalGfxState.ScissorTest==Enable))
+  {
+    GlobalGfxState.ScissorTest = Enable;
+    if(Enable) glEnable(GL_SCISSOR_TEST); else glDisable(GL_SCISSOR_TEST);
+  }
+  return;
+}
+void GfxScissor(GLint x, GLint y, GLint Width, GLint Height)
+{
+  GLint *Rect = GlobalGfxState.Scissor;
+  if(GfxStateCheck(GfxState_Scissor, (Rect[0]==x && Rect[1]==y && Rect[2]==Width && Rect[3]==Height)))
+  {
+    Rect[0] = x; Rect[1] = y; Rect[2] = Width; Rect[3] = Height;
+    glScissor(x, y, Width, Height);
+  }
+  return;
+}
+void GfxViewport(GLint x, GLint y, GLint Width, GLint Height)
+{
+  GLint *Rect = GlobalGfxState.Viewport;
+  if(GfxStateCheck(GfxState_Viewport, (Rect[0]==x && Rect[1]==y && Rect[2]==Width && Rect[3]==Height)))
+  {
+    Rect[0] = x; Rect[1] = y; Rect[2] = Width; Rect[3] = Height;
+    glViewport(x, y, Width, Height);
+  }
+  return;
+}
+void GfxBindTexture(GLuint Texture)
+{
+  if(GfxStateCheck(GfxState_Texture, GlobalGfxState.Texture==Texture))
+  {
+    GlobalGfxState.Texture = Texture;
+    glBindTexture(GL_TEXTURE_2D, Texture);
+  }
+  return;
+}
+void GfxDeleteProgram(GLuint Program)
+{
+  //gl falls back to program 0 if the bound one goes away
+  if(GlobalGfxState.Program == Program) { GlobalGfxState.Known &= ~GfxState_Program; }
+  glDeleteProgram(Program);
+  return;
+}
+void GfxDeleteBuffer(GLuint Buffer)
+{
+  if(GlobalGfxState.ArrayBuffer   == Buffer) { GlobalGfxState.Known &= ~GfxState_ArrayBuffer; }
+  if(GlobalGfxState.ElementBuffer == Buffer) { GlobalGfxState.Known &= ~GfxState_ElementBuffer; }
+  glDeleteBuffers(1, &Buffer);
+  return;
+}
+void GfxDeleteVertexArray(GLuint VertexArray)
+{
+  //gl falls back to vao 0 if the bound one goes away
+  if(GlobalGfxState.VertexArray == VertexArray) { GlobalGfxState.Known &= ~GfxState_VertexArray; }
+  glDeleteVertexArrays(1, &VertexArray);
+  return;
+}
+void GfxDeleteTexture(GLuint Texture)
+{
+  if(GlobalGfxState.Texture == Texture) { GlobalGfxState.Known &= ~GfxState_Texture; }
+  glDeleteTextures(1, &Texture);
+  return;
+}
 void GLClearErrors(void)
 {
   while(GL_NO_ERROR != glGetError());
@@ -103,73 +423,429 @@ void GLLogBufferState()
       MapOffset, MapLength, Size);
   return;
 }
-void GfxCtxDraw(gfx_ctx *Ctx, draw_bucket *Bucket, vertex3d *Verts, u32 Count)
-{
-#if 1
-  v4f Color = V4f(0.1f,0.18f, 0.1f,1.0f);
-  //GLClearErrors();
-  glBindVertexArray(Ctx->LayoutId);
-  glUseProgram(Ctx->ShaderId);
-  f32 Time = (f32)GlobalTimeElapsed;
-  glUniform2fv      (glGetUniformLocation(Ctx->ShaderId, "UWinRes"), 1, GlobalRes.comp);
-  glUniform1fv      (glGetUniformLocation(Ctx->ShaderId, "UTime"), 1, &Time);
-  glUniformMatrix4fv(glGetUniformLocation(Ctx->ShaderId, "UModel"), 1, 1, (f32 *)Bucket->Model);
-  glUniformMatrix4fv(glGetUniformLocation(Ctx->ShaderId, "UProjection"), 1, 1, (f32 *)Bucket->Projection);
-  //Give gl buffer id and deffine the attirbutes of the vbuffer (stride, offeset)
-  glEnable(GL_SCISSOR_TEST);
-  glEnable(GL_BLEND);
-  glScissor(40.0f, 1000.0f, GlobalRes.x-40.0f*2.0f, GlobalRes.y-1000.0f-40.0);
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-  glDrawArrays(GL_LINES, 0, Count);
-  //GLPrintLastError(ThisFuncionAsString(), "test: ");
-  glDisable(GL_SCISSOR_TEST);
+//~ STREAM RING
+// NOTE(MIGUEL): One buffer split into a segment per frame in flight. A frame only writes its own
+//               segment, sub-ranges get mapped unsynchronized (no orphaning, no implicit driver
+//               sync) and a fence at the end of the frame guards the segment until the gpu is done
+//               with it. Every per-frame stream (instance data etc) allocates out of the same ring.
+#define GFX_RING_FRAMES_IN_FLIGHT (3)
+#define GFX_RING_ALIGNMENT (64)
+#define GFX_RING_WAIT_TIMEOUT_NS (1000000) //1ms per poll
+//quads per draw when the ring is full and the ctx's own inst buffer takes over
+#define GFX_INSTANCE_OVERFLOW_COUNT (DRAW_BATCH_CHUNK_COUNT)
+typedef struct gfx_ring gfx_ring;
+struct gfx_ring
+{
+  GLuint BufferId;
+  u32    FrameSize;
+  u32    Size;
+  u32    Frame;     //segment being written
+  u32    Head;      //next free byte in the buffer
+  u32    End;       //one past the current segment
+  u32    MapOffset; //start of the open map
+  u32    MapSize;
+  b32    IsMapped;
+  GLsync Fences[GFX_RING_FRAMES_IN_FLIGHT];
+};
+u32 GfxAlignUp(u32 Value, u32 Alignment)
+{
+  return (Value + Alignment-1) & ~(Alignment-1);
+}
+void GfxRingCreate(gfx_ring *Ring, u32 FrameSize)
+{
+  MemorySet(0, Ring, sizeof(gfx_ring));
+  Ring->FrameSize = GfxAlignUp(FrameSize, GFX_RING_ALIGNMENT);
+  Ring->Size      = Ring->FrameSize*GFX_RING_FRAMES_IN_FLIGHT;
+  glGenBuffers(1, &Ring->BufferId);
+  GfxBindBuffer(GL_ARRAY_BUFFER, Ring->BufferId);
+  glBufferData(GL_ARRAY_BUFFER, Ring->Size, NULL, GL_STREAM_DRAW);
+  return;
+}
+void GfxRingDestroy(gfx_ring *Ring)
+{
+  for(u32 Frame=0; Frame<GFX_RING_FRAMES_IN_FLIGHT; Frame++)
+  {
+    if(Ring->Fences[Frame]) { glDeleteSync(Ring->Fences[Frame]); }
+  }
+  GfxDeleteBuffer(Ring->BufferId);
+  MemorySet(0, Ring, sizeof(gfx_ring));
+  return;
+}
+void GfxRingFrameBegin(gfx_ring *Ring)
+{
+  Ring->Frame = (Ring->Frame+1)%GFX_RING_FRAMES_IN_FLIGHT;
+  GLsync Fence = Ring->Fences[Ring->Frame];
+  if(Fence)
+  {
+    GLenum WaitResult = glClientWaitSync(Fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    if(WaitResult == GL_TIMEOUT_EXPIRED)
+    {
+      GlobalGfxFrameStats.StreamStalls++;
+      do
+      {
+        WaitResult = glClientWaitSync(Fence, GL_SYNC_FLUSH_COMMANDS_BIT, GFX_RING_WAIT_TIMEOUT_NS);
+      } while(WaitResult == GL_TIMEOUT_EXPIRED);
+    }
+    if(WaitResult == GL_WAIT_FAILED) { GLPrintLastError(ThisFuncionAsString(), "fence wait"); }
+    glDeleteSync(Fence);
+    Ring->Fences[Ring->Frame] = 0;
+  }
+  Ring->Head = Ring->Frame*Ring->FrameSize;
+  Ring->End  = Ring->Head+Ring->FrameSize;
+  return;
+}
+void GfxRingFrameEnd(gfx_ring *Ring)
+{
+  Ring->Fences[Ring->Frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  return;
+}
+u32 GfxRingRoom(gfx_ring *Ring)
+{
+  u32 Start = GfxAlignUp(Ring->Head, GFX_RING_ALIGNMENT);
+  return (Start<Ring->End)?(Ring->End-Start):0;
+}
+// NOTE(MIGUEL): maps Size bytes of this frame's segment. NULL when the segment is out of room.
+//               Only one map can be open at a time, close it with GfxRingUnmap.
+void *GfxRingMap(gfx_ring *Ring, u32 Size, u32 *Offset)
+{
+  u32 Start = GfxAlignUp(Ring->Head, GFX_RING_ALIGNMENT);
+  if(Ring->IsMapped || Size == 0 || Start+Size > Ring->End) return NULL;
+  GfxBindBuffer(GL_ARRAY_BUFFER, Ring->BufferId);
+  void *Result = glMapBufferRange(GL_ARRAY_BUFFER, Start, Size,
+                                  (GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT |
+                                   GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_FLUSH_EXPLICIT_BIT));
+  if(!Result)
+  {
+    GLPrintLastError(ThisFuncionAsString(), "ring mapping");
+    return NULL;
+  }
+  Ring->IsMapped  = 1;
+  Ring->MapOffset = Start;
+  Ring->MapSize   = Size;
+  *Offset = Start;
+  return Result;
+}
+// NOTE(MIGUEL): only the Written bytes get flushed and consumed, the rest of the map goes back
+//               to the segment.
+void GfxRingUnmap(gfx_ring *Ring, u32 Written)
+{
+  if(!Ring->IsMapped) return;
+  if(Written > Ring->MapSize) { Written = Ring->MapSize; }
+  GfxBindBuffer(GL_ARRAY_BUFFER, Ring->BufferId);
+  if(Written) { glFlushMappedBufferRange(GL_ARRAY_BUFFER, 0, Written); }
+  if(!glUnmapBuffer(GL_ARRAY_BUFFER)) { GLPrintLastError(ThisFuncionAsString(), "ring unmap"); }
+  Ring->Head     = Ring->MapOffset+Written;
+  Ring->IsMapped = 0;
+  GlobalGfxFrameStats.StreamBytes += Written;
+  return;
+}
+// NOTE(MIGUEL): zero copy buckets. one buffer per frame packet that stays mapped while the
+//               update fills that packet, so its bucket is written straight into gpu memory. the
+//               render side unmaps it (flushing only what was written) to draw the packet and maps
+//               it again before handing the packet back. the map orphans the old storage, so the
+//               gpu can still be reading last time's quads and nothing has to be fenced.
+typedef struct gfx_mapped_buffer gfx_mapped_buffer;
+struct gfx_mapped_buffer
+{
+  GLuint BufferId;
+  u32    Size;
+  void  *Mapped; //NULL while unmapped or if the map failed
+};
+void GfxMappedBufferCreate(gfx_mapped_buffer *Buffer, u32 Size)
+{
+  MemorySet(0, Buffer, sizeof(gfx_mapped_buffer));
+  Buffer->Size = Size;
+  glGenBuffers(1, &Buffer->BufferId);
+  GfxBindBuffer(GL_ARRAY_BUFFER, Buffer->BufferId);
+  glBufferData(GL_ARRAY_BUFFER, Size, NULL, GL_STREAM_DRAW);
+  return;
+}
+void *GfxMappedBufferMap(gfx_mapped_buffer *Buffer)
+{
+  if(Buffer->Mapped || !Buffer->Size) return Buffer->Mapped;
+  GfxBindBuffer(GL_ARRAY_BUFFER, Buffer->BufferId);
+  Buffer->Mapped = glMapBufferRange(GL_ARRAY_BUFFER, 0, Buffer->Size,
+                                    (GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT |
+                                     GL_MAP_FLUSH_EXPLICIT_BIT));
+  if(!Buffer->Mapped) { GLPrintLastError(ThisFuncionAsString(), "mapped buffer mapping"); }
+  return Buffer->Mapped;
+}
+void GfxMappedBufferUnmap(gfx_mapped_buffer *Buffer, u32 Written)
+{
+  if(!Buffer->Mapped) return;
+  if(Written > Buffer->Size) { Written = Buffer->Size; }
+  GfxBindBuffer(GL_ARRAY_BUFFER, Buffer->BufferId);
+  if(Written) { glFlushMappedBufferRange(GL_ARRAY_BUFFER, 0, Written); }
+  if(!glUnmapBuffer(GL_ARRAY_BUFFER)) { GLPrintLastError(ThisFuncionAsString(), "mapped buffer unmap"); }
+  Buffer->Mapped = NULL;
+  GlobalGfxFrameStats.MappedBytes += Written;
+  return;
+}
+void GfxMappedBufferDestroy(gfx_mapped_buffer *Buffer)
+{
+  GfxMappedBufferUnmap(Buffer, 0);
+  GfxDeleteBuffer(Buffer->BufferId);
+  MemorySet(0, Buffer, sizeof(gfx_mapped_buffer));
+  return;
+}
+void GfxFrameBegin(void)
+{
+  gfx_frame_stats ZeroStats = {0};
+  GlobalGfxFrameStats = ZeroStats;
+#if defined(GFX_BACKEND_RECORD)
+  GfxRecordFrameBegin();
 #endif
   return;
 }
-void GfxCtxDrawBucketInstanced(gfx_ctx *Ctx, draw_bucket *Bucket)
+void GfxFrameEnd(void)
 {
-  //map data to inst buffer
-  glBindBuffer(GL_ARRAY_BUFFER, Ctx->IBufferId);
-  struct ui_attribs *GLIBuffer = glMapBufferRange(GL_ARRAY_BUFFER, 0,
-                                                  Bucket->Count*sizeof(quad_attribs),
-                                                  GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
-  if(GLIBuffer)
+#if defined(GFX_BACKEND_RECORD)
+  GfxRecordFrameEnd();
+#endif
+  return;
+}
+//~ SUBMISSION
+// NOTE(MIGUEL): frame wide values come from the queue, the update thread owns the globals
+void GfxCtxApplyQuadsState(render_queue *Queue, gfx_ctx *Ctx)
+{
+  GfxBindVertexArray(Ctx->LayoutId);
+  GfxUseProgram(Ctx->ShaderId);
+  GfxUniformSet(&Ctx->Uniforms, GfxUniform_WinRes, Queue->Res.comp);
+  GfxSetScissorTest(0);
+  GfxSetBlend(1);
+  GfxBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  return;
+}
+void GfxCtxApplyMeshState(render_queue *Queue, gfx_ctx *Ctx, draw_bucket *Bucket)
+{
+  GfxBindVertexArray(Ctx->LayoutId);
+  GfxUseProgram(Ctx->ShaderId);
+  GfxUniformSet(&Ctx->Uniforms, GfxUniform_WinRes, Queue->Res.comp);
+  GfxUniformSet(&Ctx->Uniforms, GfxUniform_Time, &Queue->Time);
+  GfxUniformSet(&Ctx->Uniforms, GfxUniform_Model, Bucket->Model);
+  GfxUniformSet(&Ctx->Uniforms, GfxUniform_Projection, Bucket->Projection);
+  if(Ctx->TextureId) { GfxBindTexture(Ctx->TextureId); }
+  GfxSetScissorTest(1);
+  GfxSetBlend(1);
+  //ui rects grow down from the top, the gl scissor up from the bottom
+  r2f Clip = Queue->ClipRect;
+  GfxScissor((GLint)Clip.min.x, (GLint)(Queue->Res.y-Clip.max.y),
+             (GLint)(Clip.max.x-Clip.min.x), (GLint)(Clip.max.y-Clip.min.y));
+  GfxBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  return;
+}
+void GfxCtxDrawInstances(gfx_ctx *Ctx, GLuint BufferId, u32 Offset, u32 Count)
+{
+  //inst bindings follow the stream offset (vao state, a no op bind unless a run changed ctx)
+  GfxBindVertexArray(Ctx->LayoutId);
+  glBindVertexBuffer(2, BufferId, Offset, sizeof(quad_attribs));
+  glBindVertexBuffer(3, BufferId, Offset+offsetof(quad_attribs, Color), sizeof(quad_attribs));
+  glDrawArraysInstanced(GL_TRIANGLES, 0, 6, Count);
+  GlobalGfxFrameStats.DrawCalls++;
+  return;
+}
+// NOTE(MIGUEL): last resort when the ring segment is full. the ctx's own inst buffer gets
+//               orphaned per chunk, which lets the driver sync for us.
+void GfxCtxDrawInstancesOverflow(gfx_ctx *Ctx, quad_attribs *QuadAttribs, u32 Count)
+{
+  while(Count)
   {
-    memcpy(GLIBuffer, Bucket->QuadAttribs, Bucket->Count*sizeof(quad_attribs));
-  }else
+    u32 ChunkCount = Min(Count, GFX_INSTANCE_OVERFLOW_COUNT);
+    u32 Size = ChunkCount*sizeof(quad_attribs);
+    GfxBindBuffer(GL_ARRAY_BUFFER, Ctx->IBufferId);
+    quad_attribs *GLIBuffer = glMapBufferRange(GL_ARRAY_BUFFER, 0, Size,
+                                               GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if(!GLIBuffer)
+    {
+      GLPrintLastError(ThisFuncionAsString(), "overflow mapping");
+      return;
+    }
+    memcpy(GLIBuffer, QuadAttribs, Size);
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+    GfxCtxDrawInstances(Ctx, Ctx->IBufferId, 0, ChunkCount);
+    GlobalGfxFrameStats.OverflowDraws++;
+    QuadAttribs += ChunkCount;
+    Count       -= ChunkCount;
+  }
+  return;
+}
+// NOTE(MIGUEL): instances waiting to be drawn. quad commands that land right after each other
+//               in the same buffer get folded into one draw.
+typedef struct gfx_instance_run gfx_instance_run;
+struct gfx_instance_run
+{
+  gfx_ctx *Ctx;
+  GLuint BufferId;
+  u32 Offset;
+  u32 Count;
+};
+void GfxInstanceRunFlush(gfx_instance_run *Run)
+{
+  if(Run->Count) { GfxCtxDrawInstances(Run->Ctx, Run->BufferId, Run->Offset, Run->Count); }
+  Run->Count = 0;
+  return;
+}
+void GfxInstanceRunAppend(gfx_instance_run *Run, gfx_ctx *Ctx, GLuint BufferId, u32 Offset, u32 Count)
+{
+  if(Run->Count && Run->Ctx == Ctx && Run->BufferId == BufferId &&
+     Run->Offset+Run->Count*sizeof(quad_attribs) == Offset)
   {
-    GLPrintLastError(ThisFuncionAsString(), "buffer mapping");
+    Run->Count += Count;
+    GlobalGfxFrameStats.MergedDraws++;
+    return;
   }
-  glUnmapBuffer(GL_ARRAY_BUFFER);
-  //bind layout and buffers
-  glBindVertexArray(Ctx->LayoutId);
-  glUseProgram(Ctx->ShaderId);
-  //uniforms
-  glUniform2fv(glGetUniformLocation(Ctx->ShaderId, "UWinRes"), 1, GlobalRes.comp);
-  //post draw effects
-  glEnable(GL_BLEND);
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); 
-  glDrawArraysInstanced(GL_TRIANGLES, 0, 6, Bucket->Count);
+  GfxInstanceRunFlush(Run);
+  Run->Ctx      = Ctx;
+  Run->BufferId = BufferId;
+  Run->Offset   = Offset;
+  Run->Count    = Count;
+  return;
+}
+// NOTE(MIGUEL): mapped batches are drawn from where the update wrote them, arena batches get
+//               streamed in as many pieces as the ring segment has room for.
+void GfxSubmitQuads(gfx_instance_run *Run, gfx_ring *Ring, gfx_ctx *Ctx, draw_batch *Batch)
+{
+  if(Batch->IsMapped)
+  {
+    GfxInstanceRunAppend(Run, Ctx, Batch->BufferId, 0, Batch->Count);
+    return;
+  }
+  quad_attribs *QuadAttribs = Batch->QuadAttribs;
+  u32 Count = Batch->Count;
+  while(Count)
+  {
+    u32 ChunkCount = Min(Count, GfxRingRoom(Ring)/sizeof(quad_attribs));
+    if(ChunkCount == 0)
+    {
+      GfxInstanceRunFlush(Run);
+      GfxCtxDrawInstancesOverflow(Ctx, QuadAttribs, Count);
+      return;
+    }
+    u32 Offset = 0;
+    u32 Size   = ChunkCount*sizeof(quad_attribs);
+    quad_attribs *GLIBuffer = GfxRingMap(Ring, Size, &Offset);
+    if(!GLIBuffer) return;
+    memcpy(GLIBuffer, QuadAttribs, Size);
+    GfxRingUnmap(Ring, Size);
+    GfxInstanceRunAppend(Run, Ctx, Ring->BufferId, Offset, ChunkCount);
+    QuadAttribs += ChunkCount;
+    Count       -= ChunkCount;
+  }
+  return;
+}
+// NOTE(MIGUEL): one command per draw batch, they share a key so only the first one changes state
+void GfxCtxPushQuads(render_queue *Queue, render_layer Layer, gfx_ctx *Ctx, draw_bucket *Bucket)
+{
+  u64 Key = RenderKey(Layer, Ctx->ShaderId, Ctx->LayoutId, 0, 0);
+  for(draw_batch *Batch = Bucket->First; Batch!=NULL; Batch = Batch->Next)
+  {
+    if(Batch->Count == 0) continue;
+    render_cmd *Cmd = RenderQueuePush(Queue, Key);
+    if(!Cmd) return;
+    Cmd->Kind   = RenderCmd_Quads;
+    Cmd->Ctx    = Ctx;
+    Cmd->Bucket = Bucket;
+    Cmd->Batch  = Batch;
+  }
+  return;
+}
+void GfxCtxPushMesh(render_queue *Queue, render_layer Layer, gfx_ctx *Ctx, draw_bucket *Bucket,
+                    GLenum Mode, u32 IndexOffset, u32 IndexCount, v4f MeshParams,
+                    u32 StreamOffset, v4f HeightmapParams)
+{
+  u64 Key = RenderKey(Layer, Ctx->ShaderId, Ctx->LayoutId, Ctx->TextureId, 0);
+  render_cmd *Cmd = RenderQueuePush(Queue, Key);
+  if(!Cmd) return;
+  Cmd->Kind         = RenderCmd_Mesh;
+  Cmd->Ctx          = Ctx;
+  Cmd->Bucket       = Bucket;
+  Cmd->Mode         = Mode;
+  Cmd->IndexOffset  = IndexOffset;
+  Cmd->IndexCount   = IndexCount;
+  Cmd->MeshParams   = MeshParams;
+  Cmd->StreamOffset = StreamOffset;
+  Cmd->HeightmapParams = HeightmapParams;
+  return;
+}
+// NOTE(MIGUEL): the one place draws get issued. walks the sorted queue and only rebinds when
+//               the state part of the key (or the ctx/transforms it stands for) changes.
+void GfxSubmitQueue(render_queue *Queue, gfx_ring *Ring)
+{
+  gfx_instance_run Run = {0};
+  render_cmd *Last = NULL;
+  for(u32 i=0; i<Queue->Count; i++)
+  {
+    render_cmd *Cmd = &Queue->Cmds[Queue->Sorted[i].Index];
+    b32 StateChanged = (!Last || Last->Kind != Cmd->Kind || Last->Ctx != Cmd->Ctx ||
+                        (Last->Key&RENDER_KEY_STATE_MASK) != (Cmd->Key&RENDER_KEY_STATE_MASK) ||
+                        (Cmd->Kind == RenderCmd_Mesh && Last->Bucket != Cmd->Bucket));
+    if(StateChanged)
+    {
+      GfxInstanceRunFlush(&Run);
+      switch(Cmd->Kind)
+      {
+        case RenderCmd_Quads: { GfxCtxApplyQuadsState(Queue, Cmd->Ctx); } break;
+        case RenderCmd_Mesh:  { GfxCtxApplyMeshState(Queue, Cmd->Ctx, Cmd->Bucket); } break;
+      }
+    }
+    switch(Cmd->Kind)
+    {
+      case RenderCmd_Quads:
+      {
+        GfxSubmitQuads(&Run, Ring, Cmd->Ctx, Cmd->Batch);
+      } break;
+      case RenderCmd_Mesh:
+      {
+        GfxUniformSet(&Cmd->Ctx->Uniforms, GfxUniform_Chunk, Cmd->MeshParams.comp);
+        if(Cmd->Ctx->TextureId)
+        {
+          GfxUniformSet(&Cmd->Ctx->Uniforms, GfxUniform_HeightmapChunk, Cmd->HeightmapParams.comp);
+        }
+        else
+        {
+          glBindVertexBuffer(2, Ring->BufferId, Cmd->StreamOffset, sizeof(f32));
+        }
+        glDrawElements(Cmd->Mode, Cmd->IndexCount, GL_UNSIGNED_SHORT,
+                       (const void *)(uintptr_t)(Cmd->IndexOffset*sizeof(u16)));
+        GlobalGfxFrameStats.DrawCalls++;
+      } break;
+    }
+    Last = Cmd;
+  }
+  GfxInstanceRunFlush(&Run);
+  GlobalGfxFrameStats.RenderCmds += Queue->Count;
   return;
 }
 u32 GfxVertexBufferCreate(void *Data, u32 Size, u32 Count)
 {
   GLuint VertBufferId;
   glGenBuffers(1, &VertBufferId);
-  glBindBuffer(GL_ARRAY_BUFFER, VertBufferId);
+  GfxBindBuffer(GL_ARRAY_BUFFER, VertBufferId);
   glBufferData(GL_ARRAY_BUFFER, Size*Count, Data, GL_STATIC_DRAW);
   return VertBufferId;
 }
+// NOTE(MIGUEL): unbinds the vao first, the element buffer binding is vao state and would
+//               otherwise end up in whatever layout happened to be bound
+u32 GfxIndexBufferCreate(u16 *Indices, u32 Count)
+{
+  GLuint IndexBufferId;
+  GfxBindVertexArray(0);
+  glGenBuffers(1, &IndexBufferId);
+  GfxBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IndexBufferId);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, Count*sizeof(u16), Indices, GL_STATIC_DRAW);
+  return IndexBufferId;
+}
 u32 GfxInstanceBufferCreate(void *Data, u32 Size, u32 Count)
 {
   GLuint InstanceBufferId;
   glGenBuffers(1, &InstanceBufferId);
-  glBindBuffer(GL_ARRAY_BUFFER, InstanceBufferId);
+  GfxBindBuffer(GL_ARRAY_BUFFER, InstanceBufferId);
   glBufferData(GL_ARRAY_BUFFER, Size*Count, Data, GL_DYNAMIC_DRAW);
   return InstanceBufferId;
 }
 u32 GfxShaderProgramCreate(const char *VertShaderSrc, s32 VertShaderSrcLength,
-                           const char *FragShaderSrc, s32 FragShaderSrcLength)
+                           const char *FragShaderSrc, s32 FragShaderSrcLength,
+                           gfx_uniform_table *Uniforms)
 {
   //Vert Compilation
   GLuint VertShader = glCreateShader(GL_VERTEX_SHADER);
@@ -189,6 +865,7 @@ u32 GfxShaderProgramCreate(const char *VertShaderSrc, s32 VertShaderSrcLength,
   glBindAttribLocation(ShaderProgramId, 2, "AUIRect");
   glBindAttribLocation(ShaderProgramId, 3, "AUIColor");
   glLinkProgram(ShaderProgramId);
+  GfxUniformTableBuild(Uniforms, ShaderProgramId);
   //cleanup
   glDeleteShader(VertShader);
   glDeleteShader(FragShader);
@@ -202,7 +879,7 @@ u32 GfxVertexLayoutCreate(gfx_ctx *Ctx)
   u32 IStride = sizeof(quad_attribs);
   //vertex attrib array
   glGenVertexArrays(1, &LayoutId);
-  glBindVertexArray(LayoutId);
+  GfxBindVertexArray(LayoutId);
   //enable attibutes
   glEnableVertexAttribArray(0);
   glEnableVertexAttribArray(1);
@@ -233,16 +910,21 @@ u32 GfxVertexLayoutCreate(gfx_ctx *Ctx)
   glBindVertexBuffer(1, Ctx->VBufferId, b, VStride);
   glBindVertexBuffer(2, Ctx->IBufferId, 0, IStride);
   glBindVertexBuffer(3, Ctx->IBufferId, d, IStride);
-  glBindVertexArray(0);
+  GfxBindVertexArray(0);
   return LayoutId;
 }
 //- 3D ctx 
+// NOTE(MIGUEL): Defines (can be NULL) goes in front of the vertex source, for building variants
+//               of one shader file. the sources have no #version line so that's legal.
 u32 Gfx3dCtxShaderProgramCreate(const char *VertShaderSrc, s32 VertShaderSrcLength,
-                                const char *FragShaderSrc, s32 FragShaderSrcLength)
+                                const char *FragShaderSrc, s32 FragShaderSrcLength,
+                                const char *Defines, gfx_uniform_table *Uniforms)
 {
   //Vert Compilationd
   GLuint VertShader = glCreateShader(GL_VERTEX_SHADER);
-  glShaderSource(VertShader, 1, (const GLchar **)&VertShaderSrc, &VertShaderSrcLength);
+  const GLchar *VertSrcs[2] = { Defines?Defines:"", VertShaderSrc };
+  GLint VertSrcLengths[2] = { Defines?(GLint)strlen(Defines):0, VertShaderSrcLength };
+  glShaderSource(VertShader, 2, VertSrcs, VertSrcLengths);
   glCompileShader(VertShader);
   //Frag Compilation
   GLuint FragShader = glCreateShader(GL_FRAGMENT_SHADER);
@@ -255,7 +937,9 @@ u32 Gfx3dCtxShaderProgramCreate(const char *VertShaderSrc, s32 VertShaderSrcLeng
   //input assembler per vertex/instance data
   glBindAttribLocation(ShaderProgramId, 0, "APosition");
   glBindAttribLocation(ShaderProgramId, 1, "AUV");
+  glBindAttribLocation(ShaderProgramId, 2, "AHeight");
   glLinkProgram(ShaderProgramId);
+  GfxUniformTableBuild(Uniforms, ShaderProgramId);
   //cleanup
   glDeleteShader(VertShader);
   glDeleteShader(FragShader);
@@ -267,7 +951,7 @@ u32 Gfx3dCtxVertexLayoutCreate(gfx_ctx *Ctx)
   u32 VStride = sizeof(vertex3d);
   //vertex attrib array
   glGenVertexArrays(1, &LayoutId);
-  glBindVertexArray(LayoutId);
+  GfxBindVertexArray(LayoutId);
   //enable attibutes
   glEnableVertexAttribArray(0);
   glEnableVertexAttribArray(1);
@@ -281,14 +965,52 @@ u32 Gfx3dCtxVertexLayoutCreate(gfx_ctx *Ctx)
   glVertexAttribFormat (1, 2, GL_FLOAT, GL_FALSE, b); 
   glVertexAttribBinding(1, 1);
   glVertexAttribDivisor(1, 0);
+  //height: streamed per chunk, the buffer gets bound at draw time. ctxs with a heightmap
+  //texture sample it in the vertex shader instead
+  if(!Ctx->TextureId)
+  {
+    glEnableVertexAttribArray(2);
+    glVertexAttribFormat (2, 1, GL_FLOAT, GL_FALSE, 0);
+    glVertexAttribBinding(2, 2);
+    glVertexAttribDivisor(2, 0);
+  }
   //vbind
   glBindVertexBuffer(0, Ctx->VBufferId, 0, VStride);
   glBindVertexBuffer(1, Ctx->VBufferId, b, VStride);
-  glBindVertexArray(0);
+  if(Ctx->EBufferId) { GfxBindBuffer(GL_ELEMENT_ARRAY_BUFFER, Ctx->EBufferId); }
+  GfxBindVertexArray(0);
   return LayoutId;
 }
+// NOTE(MIGUEL): Side x Side single channel heights. nearest + repeat so the vertex shader can
+//               address it with toroidal coordinates the same way heightfield.h stores them.
+GLuint GfxHeightmapCreate(u32 Side)
+{
+  GLuint TextureId = 0;
+  glGenTextures(1, &TextureId);
+  GfxBindTexture(TextureId);
+  glTexStorage2D(GL_TEXTURE_2D, 1, GL_R16F, Side, Side);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+  return TextureId;
+}
+// NOTE(MIGUEL): uploads Width x Height f32s, RowLength apart, to the rect at x y. the driver
+//               converts to half floats
+void GfxHeightmapUpload(GLuint TextureId, const f32 *Heights, u32 RowLength,
+                        u32 x, u32 y, u32 Width, u32 Height)
+{
+  GfxBindTexture(TextureId);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, RowLength);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, Width, Height, GL_RED, GL_FLOAT, Heights);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+  GlobalGfxFrameStats.TextureBytes += Width*Height*sizeof(f32);
+  return;
+}
 void GfxClearScreen(f32 r, f32 g, f32 b, f32 a)
 {
+  //clears are clipped by the scissor test
+  GfxSetScissorTest(0);
   glClearColor(r,g,b,a);
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
   return;
@@ -0,0 +1,415 @@
+#ifndef GFX_NULL_H
+#define GFX_NULL_H
+
+// NOTE(MIGUEL): Null GLES 3.1 driver. Only the entry points the engine actually calls are here.
+//               Buffers get real cpu backing so map/copy paths cost what they would on a device
+//               (minus the driver), everything else is a no-op that hands out ids.
+#include <stdlib.h>
+#include <string.h>
+
+//-TYPES
+typedef unsigned int   GLenum;
+typedef unsigned int   GLuint;
+typedef int            GLint;
+typedef int            GLsizei;
+typedef unsigned int   GLbitfield;
+typedef unsigned char  GLboolean;
+typedef unsigned char  GLubyte;
+typedef float          GLfloat;
+typedef char           GLchar;
+typedef long           GLintptr;
+typedef long           GLsizeiptr;
+typedef uint64_t       GLuint64;
+typedef struct __GLsync *GLsync;
+//-TYPES
+
+//-ENUMS
+#define GL_FALSE                         0
+#define GL_TRUE                          1
+#define GL_NO_ERROR                      0
+#define GL_INVALID_ENUM                  0x0500
+#define GL_INVALID_VALUE                 0x0501
+#define GL_INVALID_OPERATION             0x0502
+#define GL_OUT_OF_MEMORY                 0x0505
+#define GL_INVALID_FRAMEBUFFER_OPERATION 0x0506
+#define GL_LINES                         0x0001
+#define GL_TRIANGLES                     0x0004
+#define GL_UNSIGNED_SHORT                0x1403
+#define GL_SRC_ALPHA                     0x0302
+#define GL_ONE_MINUS_SRC_ALPHA           0x0303
+#define GL_BLEND                         0x0BE2
+#define GL_SCISSOR_TEST                  0x0C11
+#define GL_FLOAT                         0x1406
+#define GL_FLOAT_VEC2                    0x8B50
+#define GL_FLOAT_VEC3                    0x8B51
+#define GL_FLOAT_VEC4                    0x8B52
+#define GL_FLOAT_MAT4                    0x8B5C
+#define GL_SAMPLER_2D                    0x8B5E
+#define GL_ACTIVE_UNIFORMS               0x8B86
+#define GL_DEPTH_BUFFER_BIT              0x00000100
+#define GL_COLOR_BUFFER_BIT              0x00004000
+#define GL_ARRAY_BUFFER                  0x8892
+#define GL_ELEMENT_ARRAY_BUFFER          0x8893
+#define GL_BUFFER_SIZE                   0x8764
+#define GL_BUFFER_USAGE                  0x8765
+#define GL_BUFFER_MAPPED                 0x88BC
+#define GL_STREAM_DRAW                   0x88E0
+#define GL_STREAM_READ                   0x88E1
+#define GL_STREAM_COPY                   0x88E2
+#define GL_STATIC_DRAW                   0x88E4
+#define GL_STATIC_READ                   0x88E5
+#define GL_STATIC_COPY                   0x88E6
+#define GL_DYNAMIC_DRAW                  0x88E8
+#define GL_DYNAMIC_READ                  0x88E9
+#define GL_DYNAMIC_COPY                  0x88EA
+#define GL_FRAGMENT_SHADER               0x8B30
+#define GL_VERTEX_SHADER                 0x8B31
+#define GL_BUFFER_ACCESS_FLAGS           0x911F
+#define GL_BUFFER_MAP_LENGTH             0x9120
+#define GL_BUFFER_MAP_OFFSET             0x9121
+#define GL_MAP_READ_BIT                  0x0001
+#define GL_MAP_WRITE_BIT                 0x0002
+#define GL_MAP_INVALIDATE_RANGE_BIT      0x0004
+#define GL_MAP_INVALIDATE_BUFFER_BIT     0x0008
+#define GL_MAP_FLUSH_EXPLICIT_BIT        0x0010
+#define GL_MAP_UNSYNCHRONIZED_BIT        0x0020
+#define GL_SYNC_FLUSH_COMMANDS_BIT       0x00000001
+#define GL_SYNC_GPU_COMMANDS_COMPLETE    0x9117
+#define GL_ALREADY_SIGNALED              0x911A
+#define GL_TIMEOUT_EXPIRED               0x911B
+#define GL_CONDITION_SATISFIED           0x911C
+#define GL_WAIT_FAILED                   0x911D
+#define GL_TEXTURE_2D                    0x0DE1
+#define GL_TEXTURE0                      0x84C0
+#define GL_RED                           0x1903
+#define GL_R16F                          0x822D
+#define GL_TEXTURE_MAG_FILTER            0x2800
+#define GL_TEXTURE_MIN_FILTER            0x2801
+#define GL_TEXTURE_WRAP_S                0x2802
+#define GL_TEXTURE_WRAP_T                0x2803
+#define GL_NEAREST                       0x2600
+#define GL_REPEAT                        0x2901
+#define GL_UNPACK_ROW_LENGTH             0x0CF2
+#define GL_UNPACK_ALIGNMENT              0x0CF5
+//-ENUMS
+
+// NOTE(MIGUEL): shaders/programs keep just enough around for uniform reflection: linking scans the
+//               attached sources for `uniform <type> <name>;` declarations.
+#define GFX_NULL_MAX_OBJECTS  (64)
+#define GFX_NULL_MAX_UNIFORMS (16)
+typedef struct gfx_null_uniform gfx_null_uniform;
+struct gfx_null_uniform
+{
+  GLchar Name[64];
+  GLenum Type;
+};
+typedef struct gfx_null_object gfx_null_object;
+struct gfx_null_object
+{
+  char  *Source; //shaders
+  GLuint Attached[2]; //programs
+  gfx_null_uniform Uniforms[GFX_NULL_MAX_UNIFORMS];
+  GLint  UniformCount;
+};
+#define GFX_NULL_MAX_BUFFERS (64)
+typedef struct gfx_null_buffer gfx_null_buffer;
+struct gfx_null_buffer
+{
+  u8    *Data;
+  GLint  Size;
+  GLenum Usage;
+  GLint  IsMapped;
+  GLint  MapOffset;
+  GLint  MapLength;
+  GLbitfield Access;
+};
+typedef struct gfx_null_state gfx_null_state;
+struct gfx_null_state
+{
+  gfx_null_buffer Buffers[GFX_NULL_MAX_BUFFERS];
+  gfx_null_object Objects[GFX_NULL_MAX_OBJECTS];
+  GLuint NextBufferId;
+  GLuint NextObjectId;
+  GLuint BoundArrayBuffer;
+  GLuint BoundElementBuffer;
+};
+gfx_null_state GlobalGfxNull = {0};
+
+gfx_null_buffer *GfxNullGetBuffer(GLenum Target)
+{
+  GLuint Id = ((Target==GL_ARRAY_BUFFER        )?GlobalGfxNull.BoundArrayBuffer:
+               (Target==GL_ELEMENT_ARRAY_BUFFER)?GlobalGfxNull.BoundElementBuffer: 0);
+  gfx_null_buffer *Result = (Id && Id<GFX_NULL_MAX_BUFFERS)?&GlobalGfxNull.Buffers[Id]:NULL;
+  return Result;
+}
+gfx_null_object *GfxNullGetObject(GLuint Id)
+{
+  gfx_null_object *Result = (Id && Id<GFX_NULL_MAX_OBJECTS)?&GlobalGfxNull.Objects[Id]:NULL;
+  return Result;
+}
+GLuint GfxNullNewObject(void)
+{
+  GLuint Id = ++GlobalGfxNull.NextObjectId;
+  gfx_null_object *Object = GfxNullGetObject(Id);
+  if(Object) { MemorySet(0, Object, sizeof(gfx_null_object)); }
+  return Id;
+}
+const char *GfxNullSkipSpace(const char *At)
+{
+  while(*At==' ' || *At=='\t' || *At=='\n' || *At=='\r') At++;
+  return At;
+}
+const char *GfxNullReadWord(const char *At, char *Word, u32 WordSize)
+{
+  u32 Length = 0;
+  At = GfxNullSkipSpace(At);
+  while(*At && *At!=' ' && *At!='\t' && *At!='\n' && *At!='\r' && *At!=';' && *At!='[')
+  {
+    if(Length+1<WordSize) Word[Length++] = *At;
+    At++;
+  }
+  Word[Length] = 0;
+  return At;
+}
+void GfxNullReflectUniforms(gfx_null_object *Program, const char *Source)
+{
+  const char *At = Source;
+  while(At && (At = strstr(At, "uniform")))
+  {
+    b32 IsLineStart = (At==Source) || (At[-1]=='\n') || (At[-1]==' ') || (At[-1]=='\t');
+    At += sizeof("uniform")-1;
+    if(!IsLineStart || (*At!=' ' && *At!='\t')) continue;
+    char Type[32];
+    char Name[64];
+    At = GfxNullReadWord(At, Type, sizeof(Type));
+    if(!strcmp(Type, "lowp") || !strcmp(Type, "mediump") || !strcmp(Type, "highp"))
+    {
+      At = GfxNullReadWord(At, Type, sizeof(Type));
+    }
+    At = GfxNullReadWord(At, Name, sizeof(Name));
+    GLenum GLType = ((!strcmp(Type, "float"))?GL_FLOAT:
+                     (!strcmp(Type, "vec2" ))?GL_FLOAT_VEC2:
+                     (!strcmp(Type, "vec3" ))?GL_FLOAT_VEC3:
+                     (!strcmp(Type, "vec4" ))?GL_FLOAT_VEC4:
+                     (!strcmp(Type, "mat4" ))?GL_FLOAT_MAT4:
+                     (!strcmp(Type, "sampler2D"))?GL_SAMPLER_2D: 0);
+    if(!GLType || !Name[0]) continue;
+    b32 IsDuplicate = 0;
+    for(GLint i=0; i<Program->UniformCount; i++)
+    {
+      IsDuplicate |= !strcmp(Program->Uniforms[i].Name, Name);
+    }
+    if(IsDuplicate || Program->UniformCount>=GFX_NULL_MAX_UNIFORMS) continue;
+    gfx_null_uniform *Uniform = &Program->Uniforms[Program->UniformCount++];
+    memcpy(Uniform->Name, Name, sizeof(Name));
+    Uniform->Type = GLType;
+  }
+  return;
+}
+//~ STATE
+GLenum glGetError(void) { return GL_NO_ERROR; }
+void glEnable(GLenum Cap) { return; }
+void glDisable(GLenum Cap) { return; }
+void glScissor(GLint x, GLint y, GLsizei Width, GLsizei Height) { return; }
+void glViewport(GLint x, GLint y, GLsizei Width, GLsizei Height) { return; }
+void glBlendFunc(GLenum SFactor, GLenum DFactor) { return; }
+void glClearColor(GLfloat r, GLfloat g, GLfloat b, GLfloat a) { return; }
+void glClear(GLbitfield Mask) { return; }
+//~ BUFFERS
+void glGenBuffers(GLsizei Count, GLuint *Buffers)
+{
+  for(GLsizei i=0; i<Count; i++)
+  {
+    // NOTE(MIGUEL): id 0 is reserved as the null buffer just like the real thing
+    Buffers[i] = (GlobalGfxNull.NextBufferId+1<GFX_NULL_MAX_BUFFERS)?++GlobalGfxNull.NextBufferId:0;
+  }
+  return;
+}
+void glDeleteBuffers(GLsizei Count, const GLuint *Buffers)
+{
+  for(GLsizei i=0; i<Count; i++)
+  {
+    if(!Buffers[i] || Buffers[i]>=GFX_NULL_MAX_BUFFERS) continue;
+    gfx_null_buffer *Buffer = &GlobalGfxNull.Buffers[Buffers[i]];
+    free(Buffer->Data);
+    MemorySet(0, Buffer, sizeof(gfx_null_buffer));
+  }
+  return;
+}
+void glBindBuffer(GLenum Target, GLuint Buffer)
+{
+  if(Target==GL_ARRAY_BUFFER        ) GlobalGfxNull.BoundArrayBuffer   = Buffer;
+  if(Target==GL_ELEMENT_ARRAY_BUFFER) GlobalGfxNull.BoundElementBuffer = Buffer;
+  return;
+}
+void glBufferData(GLenum Target, GLsizeiptr Size, const void *Data, GLenum Usage)
+{
+  gfx_null_buffer *Buffer = GfxNullGetBuffer(Target);
+  if(!Buffer) return;
+  Buffer->Data  = realloc(Buffer->Data, Size);
+  Buffer->Size  = (GLint)Size;
+  Buffer->Usage = Usage;
+  if(Data && Buffer->Data) { memcpy(Buffer->Data, Data, Size); }
+  return;
+}
+void *glMapBufferRange(GLenum Target, GLintptr Offset, GLsizeiptr Length, GLbitfield Access)
+{
+  gfx_null_buffer *Buffer = GfxNullGetBuffer(Target);
+  if(!Buffer || !Buffer->Data || Buffer->IsMapped || Offset+Length>Buffer->Size) return NULL;
+  Buffer->IsMapped  = 1;
+  Buffer->MapOffset = (GLint)Offset;
+  Buffer->MapLength = (GLint)Length;
+  Buffer->Access    = Access;
+  return Buffer->Data+Offset;
+}
+GLboolean glUnmapBuffer(GLenum Target)
+{
+  gfx_null_buffer *Buffer = GfxNullGetBuffer(Target);
+  if(!Buffer || !Buffer->IsMapped) return GL_FALSE;
+  Buffer->IsMapped  = 0;
+  Buffer->MapOffset = 0;
+  Buffer->MapLength = 0;
+  Buffer->Access    = 0;
+  return GL_TRUE;
+}
+void glFlushMappedBufferRange(GLenum Target, GLintptr Offset, GLsizeiptr Length) { return; }
+void glGetBufferParameteriv(GLenum Target, GLenum Name, GLint *Params)
+{
+  gfx_null_buffer *Buffer = GfxNullGetBuffer(Target);
+  if(!Buffer) return;
+  *Params = ((Name==GL_BUFFER_ACCESS_FLAGS)?(GLint)Buffer->Access:
+             (Name==GL_BUFFER_USAGE       )?(GLint)Buffer->Usage:
+             (Name==GL_BUFFER_MAPPED      )?Buffer->IsMapped:
+             (Name==GL_BUFFER_MAP_OFFSET  )?Buffer->MapOffset:
+             (Name==GL_BUFFER_MAP_LENGTH  )?Buffer->MapLength:
+             (Name==GL_BUFFER_SIZE        )?Buffer->Size: 0);
+  return;
+}
+//~ SYNC
+// NOTE(MIGUEL): there is no gpu to wait on, every fence is signaled as soon as it is created
+GLsync glFenceSync(GLenum Condition, GLbitfield Flags) { return (GLsync)(uintptr_t)1; }
+GLenum glClientWaitSync(GLsync Sync, GLbitfield Flags, GLuint64 Timeout) { return GL_ALREADY_SIGNALED; }
+void glDeleteSync(GLsync Sync) { return; }
+//~ SHADERS
+GLuint glCreateShader(GLenum Type) { return GfxNullNewObject(); }
+void glShaderSource(GLuint Shader, GLsizei Count, const GLchar *const*Src, const GLint *Length)
+{
+  gfx_null_object *Object = GfxNullGetObject(Shader);
+  if(!Object) return;
+  size_t Total = 0;
+  for(GLsizei i=0; i<Count; i++) { Total += Length?(size_t)Length[i]:strlen(Src[i]); }
+  free(Object->Source);
+  Object->Source = malloc(Total+1);
+  size_t At = 0;
+  for(GLsizei i=0; i<Count; i++)
+  {
+    size_t Size = Length?(size_t)Length[i]:strlen(Src[i]);
+    memcpy(Object->Source+At, Src[i], Size);
+    At += Size;
+  }
+  Object->Source[At] = 0;
+  return;
+}
+void glCompileShader(GLuint Shader) { return; }
+void glDeleteShader(GLuint Shader)
+{
+  gfx_null_object *Object = GfxNullGetObject(Shader);
+  if(!Object) return;
+  free(Object->Source);
+  Object->Source = NULL;
+  return;
+}
+GLuint glCreateProgram(void) { return GfxNullNewObject(); }
+void glAttachShader(GLuint Program, GLuint Shader)
+{
+  gfx_null_object *Object = GfxNullGetObject(Program);
+  if(!Object) return;
+  Object->Attached[Object->Attached[0]?1:0] = Shader;
+  return;
+}
+void glBindAttribLocation(GLuint Program, GLuint Index, const GLchar *Name) { return; }
+void glLinkProgram(GLuint Program)
+{
+  gfx_null_object *Object = GfxNullGetObject(Program);
+  if(!Object) return;
+  Object->UniformCount = 0;
+  for(u32 i=0; i<ArrayCount(Object->Attached); i++)
+  {
+    gfx_null_object *Shader = GfxNullGetObject(Object->Attached[i]);
+    if(Shader && Shader->Source) { GfxNullReflectUniforms(Object, Shader->Source); }
+  }
+  return;
+}
+void glUseProgram(GLuint Program) { return; }
+void glDeleteProgram(GLuint Program) { return; }
+void glGetProgramiv(GLuint Program, GLenum Name, GLint *Params)
+{
+  gfx_null_object *Object = GfxNullGetObject(Program);
+  *Params = (Object && Name==GL_ACTIVE_UNIFORMS)?Object->UniformCount:0;
+  return;
+}
+void glGetActiveUniform(GLuint Program, GLuint Index, GLsizei BufSize, GLsizei *Length,
+                        GLint *Size, GLenum *Type, GLchar *Name)
+{
+  gfx_null_object *Object = GfxNullGetObject(Program);
+  if(!Object || Index>=(GLuint)Object->UniformCount || BufSize<=0) return;
+  gfx_null_uniform *Uniform = &Object->Uniforms[Index];
+  GLsizei NameLength = (GLsizei)strlen(Uniform->Name);
+  if(NameLength>BufSize-1) NameLength = BufSize-1;
+  memcpy(Name, Uniform->Name, NameLength);
+  Name[NameLength] = 0;
+  if(Length) *Length = NameLength;
+  *Size = 1;
+  *Type = Uniform->Type;
+  return;
+}
+// NOTE(MIGUEL): locations are just the reflection index
+GLint glGetUniformLocation(GLuint Program, const GLchar *Name)
+{
+  gfx_null_object *Object = GfxNullGetObject(Program);
+  if(!Object) return -1;
+  for(GLint i=0; i<Object->UniformCount; i++)
+  {
+    if(!strcmp(Object->Uniforms[i].Name, Name)) return i;
+  }
+  return -1;
+}
+void glUniform1fv(GLint Location, GLsizei Count, const GLfloat *Value) { return; }
+void glUniform2fv(GLint Location, GLsizei Count, const GLfloat *Value) { return; }
+void glUniform3fv(GLint Location, GLsizei Count, const GLfloat *Value) { return; }
+void glUniform4fv(GLint Location, GLsizei Count, const GLfloat *Value) { return; }
+void glUniformMatrix4fv(GLint Location, GLsizei Count, GLboolean Transpose, const GLfloat *Value) { return; }
+//~ VERTEX LAYOUT
+void glGenVertexArrays(GLsizei Count, GLuint *Arrays)
+{
+  for(GLsizei i=0; i<Count; i++) { Arrays[i] = GfxNullNewObject(); }
+  return;
+}
+void glBindVertexArray(GLuint Array) { return; }
+void glDeleteVertexArrays(GLsizei Count, const GLuint *Arrays) { return; }
+void glEnableVertexAttribArray(GLuint Index) { return; }
+void glVertexAttribFormat(GLuint Index, GLint Size, GLenum Type, GLboolean Normalized, GLuint RelativeOffset) { return; }
+void glVertexAttribBinding(GLuint Index, GLuint BindingIndex) { return; }
+void glVertexAttribDivisor(GLuint Index, GLuint Divisor) { return; }
+void glBindVertexBuffer(GLuint BindingIndex, GLuint Buffer, GLintptr Offset, GLsizei Stride) { return; }
+//~ TEXTURES
+// NOTE(MIGUEL): no storage, uploads only cost what the caller spent getting the data ready
+void glGenTextures(GLsizei Count, GLuint *Textures)
+{
+  for(GLsizei i=0; i<Count; i++) { Textures[i] = GfxNullNewObject(); }
+  return;
+}
+void glDeleteTextures(GLsizei Count, const GLuint *Textures) { return; }
+void glActiveTexture(GLenum Texture) { return; }
+void glBindTexture(GLenum Target, GLuint Texture) { return; }
+void glTexParameteri(GLenum Target, GLenum Name, GLint Param) { return; }
+void glTexStorage2D(GLenum Target, GLsizei Levels, GLenum InternalFormat, GLsizei Width, GLsizei Height) { return; }
+void glTexSubImage2D(GLenum Target, GLint Level, GLint x, GLint y, GLsizei Width, GLsizei Height,
+                     GLenum Format, GLenum Type, const void *Pixels) { return; }
+void glPixelStorei(GLenum Name, GLint Param) { return; }
+//~ DRAWS
+void glDrawArrays(GLenum Mode, GLint First, GLsizei Count) { return; }
+void glDrawArraysInstanced(GLenum Mode, GLint First, GLsizei Count, GLsizei InstanceCount) { return; }
+void glDrawElements(GLenum Mode, GLsizei Count, GLenum Type, const void *Indices) { return; }
+
+#endif //GFX_NULL_H
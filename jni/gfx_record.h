@@ -0,0 +1,547 @@
+#ifndef GFX_RECORD_H
+#define GFX_RECORD_H
+
+// NOTE(MIGUEL): Recording backend. Sits on top of whatever driver gfx.h picked (GLES or null),
+//               logs every gl call the engine makes into a compact per-frame command log and
+//               then forwards it. Enabled with GFX_BACKEND_RECORD, the engine code doesnt change:
+//               the gl entry points are redefined at the bottom of this file.
+
+#define GFX_RECORD_CALLS(X) \
+X(glGetError) \
+X(glEnable) \
+X(glDisable) \
+X(glScissor) \
+X(glViewport) \
+X(glBlendFunc) \
+X(glClearColor) \
+X(glClear) \
+X(glGenBuffers) \
+X(glDeleteBuffers) \
+X(glBindBuffer) \
+X(glBufferData) \
+X(glMapBufferRange) \
+X(glUnmapBuffer) \
+X(glFlushMappedBufferRange) \
+X(glFenceSync) \
+X(glClientWaitSync) \
+X(glDeleteSync) \
+X(glGetBufferParameteriv) \
+X(glCreateShader) \
+X(glShaderSource) \
+X(glCompileShader) \
+X(glDeleteShader) \
+X(glCreateProgram) \
+X(glAttachShader) \
+X(glBindAttribLocation) \
+X(glLinkProgram) \
+X(glUseProgram) \
+X(glDeleteProgram) \
+X(glGetProgramiv) \
+X(glGetActiveUniform) \
+X(glGetUniformLocation) \
+X(glUniform1fv) \
+X(glUniform2fv) \
+X(glUniform3fv) \
+X(glUniform4fv) \
+X(glUniformMatrix4fv) \
+X(glGenVertexArrays) \
+X(glBindVertexArray) \
+X(glDeleteVertexArrays) \
+X(glEnableVertexAttribArray) \
+X(glVertexAttribFormat) \
+X(glVertexAttribBinding) \
+X(glVertexAttribDivisor) \
+X(glBindVertexBuffer) \
+X(glGenTextures) \
+X(glDeleteTextures) \
+X(glActiveTexture) \
+X(glBindTexture) \
+X(glTexParameteri) \
+X(glTexStorage2D) \
+X(glTexSubImage2D) \
+X(glPixelStorei) \
+X(glDrawArrays) \
+X(glDrawArraysInstanced) \
+X(glDrawElements)
+
+#define GFX_RECORD_CALL_ENUM(Name) GfxCall_##Name,
+#define GFX_RECORD_CALL_NAME(Name) #Name,
+typedef enum gfx_call gfx_call;
+enum gfx_call
+{
+  GFX_RECORD_CALLS(GFX_RECORD_CALL_ENUM)
+  GfxCall_Count,
+};
+const char *GfxCallNames[GfxCall_Count] = { GFX_RECORD_CALLS(GFX_RECORD_CALL_NAME) };
+
+typedef struct gfx_cmd gfx_cmd;
+struct gfx_cmd
+{
+  u16 Call;
+  u16 ArgCount;
+  u32 Bytes; //bytes handed to the driver by this call
+  u32 Args[4];
+};
+typedef struct gfx_record_stats gfx_record_stats;
+struct gfx_record_stats
+{
+  u32 Calls[GfxCall_Count];
+  u64 Bytes[GfxCall_Count];
+  u32 TotalCalls;
+  u64 TotalBytes;
+};
+#define GFX_RECORD_MAX_CMDS (8192)
+#define GFX_RECORD_LOG_INTERVAL (300) //frames between stat logs, 0 to disable
+typedef struct gfx_record gfx_record;
+struct gfx_record
+{
+  gfx_cmd Cmds[GFX_RECORD_MAX_CMDS];
+  u32 CmdCount;
+  u32 DroppedCount;
+  u32 FrameCount;
+  gfx_record_stats Frame;     //in flight
+  gfx_record_stats LastFrame; //last completed frame
+  gfx_record_stats Total;     //every completed frame
+};
+gfx_record GlobalGfxRecord = {0};
+
+u32 GfxRecordF32(f32 Value)
+{
+  union { f32 f; u32 u; } Bits = { .f = Value };
+  return Bits.u;
+}
+void GfxRecordPush(gfx_call Call, u32 Bytes, u32 ArgCount, u32 a, u32 b, u32 c, u32 d)
+{
+  gfx_record *Record = &GlobalGfxRecord;
+  Record->Frame.Calls[Call]++;
+  Record->Frame.Bytes[Call] += Bytes;
+  Record->Frame.TotalCalls++;
+  Record->Frame.TotalBytes += Bytes;
+  if(Record->CmdCount >= GFX_RECORD_MAX_CMDS) { Record->DroppedCount++; return; }
+  gfx_cmd *Cmd = &Record->Cmds[Record->CmdCount++];
+  Cmd->Call     = (u16)Call;
+  Cmd->ArgCount = (u16)ArgCount;
+  Cmd->Bytes    = Bytes;
+  Cmd->Args[0] = a; Cmd->Args[1] = b; Cmd->Args[2] = c; Cmd->Args[3] = d;
+  return;
+}
+void GfxRecordStatsAccumulate(gfx_record_stats *Dest, gfx_record_stats *Src)
+{
+  for(u32 Call=0; Call<GfxCall_Count; Call++)
+  {
+    Dest->Calls[Call] += Src->Calls[Call];
+    Dest->Bytes[Call] += Src->Bytes[Call];
+  }
+  Dest->TotalCalls += Src->TotalCalls;
+  Dest->TotalBytes += Src->TotalBytes;
+  return;
+}
+void GfxRecordLogStats(gfx_record_stats *Stats, u32 FrameCount)
+{
+  f64 Frames = FrameCount?(f64)FrameCount:1.0;
+  LOG("gl calls/frame: %.1f  bytes/frame: %.1f", Stats->TotalCalls/Frames, Stats->TotalBytes/Frames);
+  for(u32 Call=0; Call<GfxCall_Count; Call++)
+  {
+    if(!Stats->Calls[Call]) continue;
+    LOG("  %-26s calls: %8.1f  bytes: %10.1f", GfxCallNames[Call],
+        Stats->Calls[Call]/Frames, Stats->Bytes[Call]/Frames);
+  }
+  return;
+}
+void GfxRecordLogCmds(void)
+{
+  gfx_record *Record = &GlobalGfxRecord;
+  for(u32 i=0; i<Record->CmdCount; i++)
+  {
+    gfx_cmd *Cmd = &Record->Cmds[i];
+    LOG("%5u %-26s [%u %u %u %u] %u bytes", i, GfxCallNames[Cmd->Call],
+        Cmd->Args[0], Cmd->Args[1], Cmd->Args[2], Cmd->Args[3], Cmd->Bytes);
+  }
+  if(Record->DroppedCount) { LOG("%u commands dropped (log full)", Record->DroppedCount); }
+  return;
+}
+// NOTE(MIGUEL): anything recorded outside a frame (init, teardown) is dropped from the frame
+//               stats on the next begin but the calls still went through.
+void GfxRecordFrameBegin(void)
+{
+  gfx_record *Record = &GlobalGfxRecord;
+  gfx_record_stats Zero = {0};
+  Record->Frame    = Zero;
+  Record->CmdCount = 0;
+  Record->DroppedCount = 0;
+  return;
+}
+void GfxRecordFrameEnd(void)
+{
+  gfx_record *Record = &GlobalGfxRecord;
+  Record->LastFrame = Record->Frame;
+  GfxRecordStatsAccumulate(&Record->Total, &Record->Frame);
+  Record->FrameCount++;
+#if GFX_RECORD_LOG_INTERVAL
+  if((Record->FrameCount % GFX_RECORD_LOG_INTERVAL) == 0)
+  {
+    GfxRecordLogStats(&Record->Total, Record->FrameCount);
+  }
+#endif
+  return;
+}
+
+//~ WRAPPERS
+#define GFX_RECORD_UNIFORM_BYTES(Count, Size) ((u32)(Count)*(u32)(Size)*(u32)sizeof(GLfloat))
+GLenum GfxRec_glGetError(void)
+{
+  GfxRecordPush(GfxCall_glGetError, 0, 0, 0, 0, 0, 0);
+  return glGetError();
+}
+void GfxRec_glEnable(GLenum Cap)
+{
+  GfxRecordPush(GfxCall_glEnable, 0, 1, Cap, 0, 0, 0);
+  glEnable(Cap);
+}
+void GfxRec_glDisable(GLenum Cap)
+{
+  GfxRecordPush(GfxCall_glDisable, 0, 1, Cap, 0, 0, 0);
+  glDisable(Cap);
+}
+void GfxRec_glScissor(GLint x, GLint y, GLsizei Width, GLsizei Height)
+{
+  GfxRecordPush(GfxCall_glScissor, 0, 4, x, y, Width, Height);
+  glScissor(x, y, Width, Height);
+}
+void GfxRec_glViewport(GLint x, GLint y, GLsizei Width, GLsizei Height)
+{
+  GfxRecordPush(GfxCall_glViewport, 0, 4, x, y, Width, Height);
+  glViewport(x, y, Width, Height);
+}
+void GfxRec_glBlendFunc(GLenum SFactor, GLenum DFactor)
+{
+  GfxRecordPush(GfxCall_glBlendFunc, 0, 2, SFactor, DFactor, 0, 0);
+  glBlendFunc(SFactor, DFactor);
+}
+void GfxRec_glClearColor(GLfloat r, GLfloat g, GLfloat b, GLfloat a)
+{
+  GfxRecordPush(GfxCall_glClearColor, 0, 4,
+                GfxRecordF32(r), GfxRecordF32(g), GfxRecordF32(b), GfxRecordF32(a));
+  glClearColor(r, g, b, a);
+}
+void GfxRec_glClear(GLbitfield Mask)
+{
+  GfxRecordPush(GfxCall_glClear, 0, 1, Mask, 0, 0, 0);
+  glClear(Mask);
+}
+void GfxRec_glGenBuffers(GLsizei Count, GLuint *Buffers)
+{
+  glGenBuffers(Count, Buffers);
+  GfxRecordPush(GfxCall_glGenBuffers, 0, 2, Count, Count?Buffers[0]:0, 0, 0);
+}
+void GfxRec_glDeleteBuffers(GLsizei Count, const GLuint *Buffers)
+{
+  GfxRecordPush(GfxCall_glDeleteBuffers, 0, 2, Count, Count?Buffers[0]:0, 0, 0);
+  glDeleteBuffers(Count, Buffers);
+}
+void GfxRec_glBindBuffer(GLenum Target, GLuint Buffer)
+{
+  GfxRecordPush(GfxCall_glBindBuffer, 0, 2, Target, Buffer, 0, 0);
+  glBindBuffer(Target, Buffer);
+}
+void GfxRec_glBufferData(GLenum Target, GLsizeiptr Size, const void *Data, GLenum Usage)
+{
+  GfxRecordPush(GfxCall_glBufferData, Data?(u32)Size:0, 3, Target, (u32)Size, Usage, 0);
+  glBufferData(Target, Size, Data, Usage);
+}
+void *GfxRec_glMapBufferRange(GLenum Target, GLintptr Offset, GLsizeiptr Length, GLbitfield Access)
+{
+  // NOTE(MIGUEL): writable maps are charged their full length up front, explicitly flushed maps
+  //               are charged as they flush.
+  b32 ChargeOnMap = (Access & GL_MAP_WRITE_BIT) && !(Access & GL_MAP_FLUSH_EXPLICIT_BIT);
+  GfxRecordPush(GfxCall_glMapBufferRange, ChargeOnMap?(u32)Length:0, 4,
+                Target, (u32)Offset, (u32)Length, Access);
+  return glMapBufferRange(Target, Offset, Length, Access);
+}
+GLboolean GfxRec_glUnmapBuffer(GLenum Target)
+{
+  GfxRecordPush(GfxCall_glUnmapBuffer, 0, 1, Target, 0, 0, 0);
+  return glUnmapBuffer(Target);
+}
+void GfxRec_glFlushMappedBufferRange(GLenum Target, GLintptr Offset, GLsizeiptr Length)
+{
+  GfxRecordPush(GfxCall_glFlushMappedBufferRange, (u32)Length, 3, Target, (u32)Offset, (u32)Length, 0);
+  glFlushMappedBufferRange(Target, Offset, Length);
+}
+GLsync GfxRec_glFenceSync(GLenum Condition, GLbitfield Flags)
+{
+  GfxRecordPush(GfxCall_glFenceSync, 0, 2, Condition, Flags, 0, 0);
+  return glFenceSync(Condition, Flags);
+}
+GLenum GfxRec_glClientWaitSync(GLsync Sync, GLbitfield Flags, GLuint64 Timeout)
+{
+  GLenum Result = glClientWaitSync(Sync, Flags, Timeout);
+  GfxRecordPush(GfxCall_glClientWaitSync, 0, 3, Flags, (u32)Timeout, Result, 0);
+  return Result;
+}
+void GfxRec_glDeleteSync(GLsync Sync)
+{
+  GfxRecordPush(GfxCall_glDeleteSync, 0, 0, 0, 0, 0, 0);
+  glDeleteSync(Sync);
+}
+void GfxRec_glGetBufferParameteriv(GLenum Target, GLenum Name, GLint *Params)
+{
+  GfxRecordPush(GfxCall_glGetBufferParameteriv, 0, 2, Target, Name, 0, 0);
+  glGetBufferParameteriv(Target, Name, Params);
+}
+GLuint GfxRec_glCreateShader(GLenum Type)
+{
+  GLuint Result = glCreateShader(Type);
+  GfxRecordPush(GfxCall_glCreateShader, 0, 2, Type, Result, 0, 0);
+  return Result;
+}
+void GfxRec_glShaderSource(GLuint Shader, GLsizei Count, const GLchar *const*Src, const GLint *Length)
+{
+  u32 Bytes = 0;
+  for(GLsizei i=0; i<Count; i++) { Bytes += Length?(u32)Length[i]:(u32)strlen(Src[i]); }
+  GfxRecordPush(GfxCall_glShaderSource, Bytes, 2, Shader, Count, 0, 0);
+  glShaderSource(Shader, Count, Src, Length);
+}
+void GfxRec_glCompileShader(GLuint Shader)
+{
+  GfxRecordPush(GfxCall_glCompileShader, 0, 1, Shader, 0, 0, 0);
+  glCompileShader(Shader);
+}
+void GfxRec_glDeleteShader(GLuint Shader)
+{
+  GfxRecordPush(GfxCall_glDeleteShader, 0, 1, Shader, 0, 0, 0);
+  glDeleteShader(Shader);
+}
+GLuint GfxRec_glCreateProgram(void)
+{
+  GLuint Result = glCreateProgram();
+  GfxRecordPush(GfxCall_glCreateProgram, 0, 1, Result, 0, 0, 0);
+  return Result;
+}
+void GfxRec_glAttachShader(GLuint Program, GLuint Shader)
+{
+  GfxRecordPush(GfxCall_glAttachShader, 0, 2, Program, Shader, 0, 0);
+  glAttachShader(Program, Shader);
+}
+void GfxRec_glBindAttribLocation(GLuint Program, GLuint Index, const GLchar *Name)
+{
+  GfxRecordPush(GfxCall_glBindAttribLocation, 0, 2, Program, Index, 0, 0);
+  glBindAttribLocation(Program, Index, Name);
+}
+void GfxRec_glLinkProgram(GLuint Program)
+{
+  GfxRecordPush(GfxCall_glLinkProgram, 0, 1, Program, 0, 0, 0);
+  glLinkProgram(Program);
+}
+void GfxRec_glUseProgram(GLuint Program)
+{
+  GfxRecordPush(GfxCall_glUseProgram, 0, 1, Program, 0, 0, 0);
+  glUseProgram(Program);
+}
+void GfxRec_glDeleteProgram(GLuint Program)
+{
+  GfxRecordPush(GfxCall_glDeleteProgram, 0, 1, Program, 0, 0, 0);
+  glDeleteProgram(Program);
+}
+void GfxRec_glGetProgramiv(GLuint Program, GLenum Name, GLint *Params)
+{
+  GfxRecordPush(GfxCall_glGetProgramiv, 0, 2, Program, Name, 0, 0);
+  glGetProgramiv(Program, Name, Params);
+}
+void GfxRec_glGetActiveUniform(GLuint Program, GLuint Index, GLsizei BufSize, GLsizei *Length,
+                               GLint *Size, GLenum *Type, GLchar *Name)
+{
+  GfxRecordPush(GfxCall_glGetActiveUniform, 0, 2, Program, Index, 0, 0);
+  glGetActiveUniform(Program, Index, BufSize, Length, Size, Type, Name);
+}
+GLint GfxRec_glGetUniformLocation(GLuint Program, const GLchar *Name)
+{
+  GLint Result = glGetUniformLocation(Program, Name);
+  GfxRecordPush(GfxCall_glGetUniformLocation, 0, 2, Program, (u32)Result, 0, 0);
+  return Result;
+}
+void GfxRec_glUniform1fv(GLint Location, GLsizei Count, const GLfloat *Value)
+{
+  GfxRecordPush(GfxCall_glUniform1fv, GFX_RECORD_UNIFORM_BYTES(Count, 1), 2, Location, Count, 0, 0);
+  glUniform1fv(Location, Count, Value);
+}
+void GfxRec_glUniform2fv(GLint Location, GLsizei Count, const GLfloat *Value)
+{
+  GfxRecordPush(GfxCall_glUniform2fv, GFX_RECORD_UNIFORM_BYTES(Count, 2), 2, Location, Count, 0, 0);
+  glUniform2fv(Location, Count, Value);
+}
+void GfxRec_glUniform3fv(GLint Location, GLsizei Count, const GLfloat *Value)
+{
+  GfxRecordPush(GfxCall_glUniform3fv, GFX_RECORD_UNIFORM_BYTES(Count, 3), 2, Location, Count, 0, 0);
+  glUniform3fv(Location, Count, Value);
+}
+void GfxRec_glUniform4fv(GLint Location, GLsizei Count, const GLfloat *Value)
+{
+  GfxRecordPush(GfxCall_glUniform4fv, GFX_RECORD_UNIFORM_BYTES(Count, 4), 2, Location, Count, 0, 0);
+  glUniform4fv(Location, Count, Value);
+}
+void GfxRec_glUniformMatrix4fv(GLint Location, GLsizei Count, GLboolean Transpose, const GLfloat *Value)
+{
+  GfxRecordPush(GfxCall_glUniformMatrix4fv, GFX_RECORD_UNIFORM_BYTES(Count, 16), 3,
+                Location, Count, Transpose, 0);
+  glUniformMatrix4fv(Location, Count, Transpose, Value);
+}
+void GfxRec_glGenVertexArrays(GLsizei Count, GLuint *Arrays)
+{
+  glGenVertexArrays(Count, Arrays);
+  GfxRecordPush(GfxCall_glGenVertexArrays, 0, 2, Count, Count?Arrays[0]:0, 0, 0);
+}
+void GfxRec_glBindVertexArray(GLuint Array)
+{
+  GfxRecordPush(GfxCall_glBindVertexArray, 0, 1, Array, 0, 0, 0);
+  glBindVertexArray(Array);
+}
+void GfxRec_glDeleteVertexArrays(GLsizei Count, const GLuint *Arrays)
+{
+  GfxRecordPush(GfxCall_glDeleteVertexArrays, 0, 2, Count, Count?Arrays[0]:0, 0, 0);
+  glDeleteVertexArrays(Count, Arrays);
+}
+void GfxRec_glEnableVertexAttribArray(GLuint Index)
+{
+  GfxRecordPush(GfxCall_glEnableVertexAttribArray, 0, 1, Index, 0, 0, 0);
+  glEnableVertexAttribArray(Index);
+}
+void GfxRec_glVertexAttribFormat(GLuint Index, GLint Size, GLenum Type, GLboolean Normalized, GLuint RelativeOffset)
+{
+  GfxRecordPush(GfxCall_glVertexAttribFormat, 0, 4, Index, Size, Type, RelativeOffset);
+  glVertexAttribFormat(Index, Size, Type, Normalized, RelativeOffset);
+}
+void GfxRec_glVertexAttribBinding(GLuint Index, GLuint BindingIndex)
+{
+  GfxRecordPush(GfxCall_glVertexAttribBinding, 0, 2, Index, BindingIndex, 0, 0);
+  glVertexAttribBinding(Index, BindingIndex);
+}
+void GfxRec_glVertexAttribDivisor(GLuint Index, GLuint Divisor)
+{
+  GfxRecordPush(GfxCall_glVertexAttribDivisor, 0, 2, Index, Divisor, 0, 0);
+  glVertexAttribDivisor(Index, Divisor);
+}
+void GfxRec_glBindVertexBuffer(GLuint BindingIndex, GLuint Buffer, GLintptr Offset, GLsizei Stride)
+{
+  GfxRecordPush(GfxCall_glBindVertexBuffer, 0, 4, BindingIndex, Buffer, (u32)Offset, Stride);
+  glBindVertexBuffer(BindingIndex, Buffer, Offset, Stride);
+}
+void GfxRec_glGenTextures(GLsizei Count, GLuint *Textures)
+{
+  glGenTextures(Count, Textures);
+  GfxRecordPush(GfxCall_glGenTextures, 0, 2, Count, Count?Textures[0]:0, 0, 0);
+}
+void GfxRec_glDeleteTextures(GLsizei Count, const GLuint *Textures)
+{
+  GfxRecordPush(GfxCall_glDeleteTextures, 0, 2, Count, Count?Textures[0]:0, 0, 0);
+  glDeleteTextures(Count, Textures);
+}
+void GfxRec_glActiveTexture(GLenum Texture)
+{
+  GfxRecordPush(GfxCall_glActiveTexture, 0, 1, Texture, 0, 0, 0);
+  glActiveTexture(Texture);
+}
+void GfxRec_glBindTexture(GLenum Target, GLuint Texture)
+{
+  GfxRecordPush(GfxCall_glBindTexture, 0, 2, Target, Texture, 0, 0);
+  glBindTexture(Target, Texture);
+}
+void GfxRec_glTexParameteri(GLenum Target, GLenum Name, GLint Param)
+{
+  GfxRecordPush(GfxCall_glTexParameteri, 0, 3, Target, Name, Param, 0);
+  glTexParameteri(Target, Name, Param);
+}
+void GfxRec_glTexStorage2D(GLenum Target, GLsizei Levels, GLenum InternalFormat, GLsizei Width, GLsizei Height)
+{
+  GfxRecordPush(GfxCall_glTexStorage2D, 0, 4, Levels, InternalFormat, Width, Height);
+  glTexStorage2D(Target, Levels, InternalFormat, Width, Height);
+}
+// NOTE(MIGUEL): charged what gets read from client memory, only the formats the engine uploads
+void GfxRec_glTexSubImage2D(GLenum Target, GLint Level, GLint x, GLint y, GLsizei Width, GLsizei Height,
+                            GLenum Format, GLenum Type, const void *Pixels)
+{
+  u32 TexelSize = (Type==GL_FLOAT)?sizeof(GLfloat):1;
+  GfxRecordPush(GfxCall_glTexSubImage2D, (u32)(Width*Height)*TexelSize, 4, x, y, Width, Height);
+  glTexSubImage2D(Target, Level, x, y, Width, Height, Format, Type, Pixels);
+}
+void GfxRec_glPixelStorei(GLenum Name, GLint Param)
+{
+  GfxRecordPush(GfxCall_glPixelStorei, 0, 2, Name, Param, 0, 0);
+  glPixelStorei(Name, Param);
+}
+void GfxRec_glDrawArrays(GLenum Mode, GLint First, GLsizei Count)
+{
+  GfxRecordPush(GfxCall_glDrawArrays, 0, 3, Mode, First, Count, 0);
+  glDrawArrays(Mode, First, Count);
+}
+void GfxRec_glDrawElements(GLenum Mode, GLsizei Count, GLenum Type, const void *Indices)
+{
+  GfxRecordPush(GfxCall_glDrawElements, 0, 4, Mode, Count, Type, (u32)(uintptr_t)Indices);
+  glDrawElements(Mode, Count, Type, Indices);
+}
+void GfxRec_glDrawArraysInstanced(GLenum Mode, GLint First, GLsizei Count, GLsizei InstanceCount)
+{
+  GfxRecordPush(GfxCall_glDrawArraysInstanced, 0, 4, Mode, First, Count, InstanceCount);
+  glDrawArraysInstanced(Mode, First, Count, InstanceCount);
+}
+
+// NOTE(MIGUEL): from here on every gl call in the engine goes through the recorder
+#define GFX_RECORD_CALL_REDIRECT(Name) GfxRec_##Name
+#define glGetError                GFX_RECORD_CALL_REDIRECT(glGetError)
+#define glEnable                  GFX_RECORD_CALL_REDIRECT(glEnable)
+#define glDisable                 GFX_RECORD_CALL_REDIRECT(glDisable)
+#define glScissor                 GFX_RECORD_CALL_REDIRECT(glScissor)
+#define glViewport                GFX_RECORD_CALL_REDIRECT(glViewport)
+#define glBlendFunc               GFX_RECORD_CALL_REDIRECT(glBlendFunc)
+#define glClearColor              GFX_RECORD_CALL_REDIRECT(glClearColor)
+#define glClear                   GFX_RECORD_CALL_REDIRECT(glClear)
+#define glGenBuffers              GFX_RECORD_CALL_REDIRECT(glGenBuffers)
+#define glDeleteBuffers           GFX_RECORD_CALL_REDIRECT(glDeleteBuffers)
+#define glBindBuffer              GFX_RECORD_CALL_REDIRECT(glBindBuffer)
+#define glBufferData              GFX_RECORD_CALL_REDIRECT(glBufferData)
+#define glMapBufferRange          GFX_RECORD_CALL_REDIRECT(glMapBufferRange)
+#define glUnmapBuffer             GFX_RECORD_CALL_REDIRECT(glUnmapBuffer)
+#define glFlushMappedBufferRange  GFX_RECORD_CALL_REDIRECT(glFlushMappedBufferRange)
+#define glFenceSync               GFX_RECORD_CALL_REDIRECT(glFenceSync)
+#define glClientWaitSync          GFX_RECORD_CALL_REDIRECT(glClientWaitSync)
+#define glDeleteSync              GFX_RECORD_CALL_REDIRECT(glDeleteSync)
+#define glGetBufferParameteriv    GFX_RECORD_CALL_REDIRECT(glGetBufferParameteriv)
+#define glCreateShader            GFX_RECORD_CALL_REDIRECT(glCreateShader)
+#define glShaderSource            GFX_RECORD_CALL_REDIRECT(glShaderSource)
+#define glCompileShader           GFX_RECORD_CALL_REDIRECT(glCompileShader)
+#define glDeleteShader            GFX_RECORD_CALL_REDIRECT(glDeleteShader)
+#define glCreateProgram           GFX_RECORD_CALL_REDIRECT(glCreateProgram)
+#define glAttachShader            GFX_RECORD_CALL_REDIRECT(glAttachShader)
+#define glBindAttribLocation      GFX_RECORD_CALL_REDIRECT(glBindAttribLocation)
+#define glLinkProgram             GFX_RECORD_CALL_REDIRECT(glLinkProgram)
+#define glUseProgram              GFX_RECORD_CALL_REDIRECT(glUseProgram)
+#define glDeleteProgram           GFX_RECORD_CALL_REDIRECT(glDeleteProgram)
+#define glGetProgramiv            GFX_RECORD_CALL_REDIRECT(glGetProgramiv)
+#define glGetActiveUniform        GFX_RECORD_CALL_REDIRECT(glGetActiveUniform)
+#define glGetUniformLocation      GFX_RECORD_CALL_REDIRECT(glGetUniformLocation)
+#define glUniform1fv              GFX_RECORD_CALL_REDIRECT(glUniform1fv)
+#define glUniform2fv              GFX_RECORD_CALL_REDIRECT(glUniform2fv)
+#define glUniform3fv              GFX_RECORD_CALL_REDIRECT(glUniform3fv)
+#define glUniform4fv              GFX_RECORD_CALL_REDIRECT(glUniform4fv)
+#define glUniformMatrix4fv        GFX_RECORD_CALL_REDIRECT(glUniformMatrix4fv)
+#define glGenVertexArrays         GFX_RECORD_CALL_REDIRECT(glGenVertexArrays)
+#define glBindVertexArray         GFX_RECORD_CALL_REDIRECT(glBindVertexArray)
+#define glDeleteVertexArrays      GFX_RECORD_CALL_REDIRECT(glDeleteVertexArrays)
+#define glEnableVertexAttribArray GFX_RECORD_CALL_REDIRECT(glEnableVertexAttribArray)
+#define glVertexAttribFormat      GFX_RECORD_CALL_REDIRECT(glVertexAttribFormat)
+#define glVertexAttribBinding     GFX_RECORD_CALL_REDIRECT(glVertexAttribBinding)
+#define glVertexAttribDivisor     GFX_RECORD_CALL_REDIRECT(glVertexAttribDivisor)
+#define glBindVertexBuffer        GFX_RECORD_CALL_REDIRECT(glBindVertexBuffer)
+#define glGenTextures             GFX_RECORD_CALL_REDIRECT(glGenTextures)
+#define glDeleteTextures          GFX_RECORD_CALL_REDIRECT(glDeleteTextures)
+#define glActiveTexture           GFX_RECORD_CALL_REDIRECT(glActiveTexture)
+#define glBindTexture             GFX_RECORD_CALL_REDIRECT(glBindTexture)
+#define glTexParameteri           GFX_RECORD_CALL_REDIRECT(glTexParameteri)
+#define glTexStorage2D            GFX_RECORD_CALL_REDIRECT(glTexStorage2D)
+#define glTexSubImage2D           GFX_RECORD_CALL_REDIRECT(glTexSubImage2D)
+#define glPixelStorei             GFX_RECORD_CALL_REDIRECT(glPixelStorei)
+#define glDrawArrays              GFX_RECORD_CALL_REDIRECT(glDrawArrays)
+#define glDrawArraysInstanced     GFX_RECORD_CALL_REDIRECT(glDrawArraysInstanced)
+#define glDrawElements            GFX_RECORD_CALL_REDIRECT(glDrawElements)
+
+#endif //GFX_RECORD_H
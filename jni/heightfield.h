@@ -0,0 +1,214 @@
+#ifndef HEIGHTFIELD_H
+#define HEIGHTFIELD_H
+
+// NOTE(MIGUEL): CPU side copy of the simplex noise vertex3d.glsl used to run per vertex every
+//               frame. Samples sit on a lattice Spacing apart in noise space and Side x Side of
+//               them are cached, starting at lattice index (Scroll, Scroll). The terrain scrolls
+//               the same amount along both axes, so a new Scroll only needs the rows and columns
+//               that came into view. Storage is toroidal (lattice index mod Side) so nothing
+//               already cached ever moves.
+typedef struct heightfield heightfield;
+struct heightfield
+{
+  f32 *Heights;    //Side*Side, row major by z
+  u32 Side;
+  f32 Origin;      //noise space coordinate of lattice index 0, same on both axes
+  f32 Spacing;     //noise space distance between samples
+  f32 Amplitude;
+  s64 Scroll;      //lattice index of the first cached row and column
+  b32 IsValid;
+  u32 SampleCount; //samples evaluated by the last update
+};
+typedef struct heightfield_rect heightfield_rect;
+struct heightfield_rect
+{
+  u32 x;
+  u32 y;
+  u32 Width;
+  u32 Height;
+};
+#define HEIGHTFIELD_MAX_CHANGED_RECTS (4)
+// NOTE(MIGUEL): -1 + 2*fract(sin(p)*43758.5453) from the shader, for both hash components
+inline void HeightfieldHash4(f32x4 ix, f32x4 iz, f32x4 *hx, f32x4 *hz)
+{
+  f32x4 One    = F32x4Set1(1.0f);
+  f32x4 Two    = F32x4Set1(2.0f);
+  f32x4 Spread = F32x4Set1(43758.5453123f);
+  f32x4 px = F32x4Add(F32x4Mul(ix, F32x4Set1(127.1f)), F32x4Mul(iz, F32x4Set1(311.7f)));
+  f32x4 pz = F32x4Add(F32x4Mul(ix, F32x4Set1(269.5f)), F32x4Mul(iz, F32x4Set1(183.3f)));
+  *hx = F32x4Sub(F32x4Mul(Two, F32x4Fract(F32x4Mul(F32x4Sin(px), Spread))), One);
+  *hz = F32x4Sub(F32x4Mul(Two, F32x4Fract(F32x4Mul(F32x4Sin(pz), Spread))), One);
+  return;
+}
+// NOTE(MIGUEL): contribution of one simplex corner, h^4 * dot(d, hash(corner))
+inline f32x4 HeightfieldCorner4(f32x4 dx, f32x4 dz, f32x4 cx, f32x4 cz)
+{
+  f32x4 h = F32x4Max(F32x4Sub(F32x4Set1(0.5f), F32x4Add(F32x4Mul(dx, dx), F32x4Mul(dz, dz))),
+                     F32x4Set1(0.0f));
+  h = F32x4Mul(h, h);
+  h = F32x4Mul(h, h);
+  f32x4 hx, hz;
+  HeightfieldHash4(cx, cz, &hx, &hz);
+  return F32x4Mul(h, F32x4Add(F32x4Mul(dx, hx), F32x4Mul(dz, hz)));
+}
+// NOTE(MIGUEL): noise() from vertex3d.glsl, 4 points at a time
+inline f32x4 HeightfieldNoise4(f32x4 px, f32x4 pz)
+{
+  f32x4 K1   = F32x4Set1(0.366025404f); //(sqrt(3)-1)/2
+  f32x4 K2   = F32x4Set1(0.211324865f); //(3-sqrt(3))/6
+  f32x4 One  = F32x4Set1(1.0f);
+  f32x4 Zero = F32x4Set1(0.0f);
+  f32x4 Skew = F32x4Mul(F32x4Add(px, pz), K1);
+  f32x4 ix = F32x4Floor(F32x4Add(px, Skew));
+  f32x4 iz = F32x4Floor(F32x4Add(pz, Skew));
+  f32x4 Unskew = F32x4Mul(F32x4Add(ix, iz), K2);
+  f32x4 ax = F32x4Add(F32x4Sub(px, ix), Unskew);
+  f32x4 az = F32x4Add(F32x4Sub(pz, iz), Unskew);
+  f32x4_mask m = F32x4GreaterEqual(ax, az);
+  f32x4 ox = F32x4Select(m, One, Zero);
+  f32x4 oz = F32x4Select(m, Zero, One);
+  f32x4 bx = F32x4Add(F32x4Sub(ax, ox), K2);
+  f32x4 bz = F32x4Add(F32x4Sub(az, oz), K2);
+  f32x4 TwoK2MinusOne = F32x4Set1(2.0f*0.211324865f-1.0f);
+  f32x4 cx = F32x4Add(ax, TwoK2MinusOne);
+  f32x4 cz = F32x4Add(az, TwoK2MinusOne);
+  f32x4 n = HeightfieldCorner4(ax, az, ix, iz);
+  n = F32x4Add(n, HeightfieldCorner4(bx, bz, F32x4Add(ix, ox), F32x4Add(iz, oz)));
+  n = F32x4Add(n, HeightfieldCorner4(cx, cz, F32x4Add(ix, One), F32x4Add(iz, One)));
+  return F32x4Mul(n, F32x4Set1(70.0f));
+}
+b32 HeightfieldAlloc(heightfield *Heightfield, arena *Arena, u32 Side,
+                     f32 Origin, f32 Spacing, f32 Amplitude)
+{
+  MemorySet(0, Heightfield, sizeof(heightfield));
+  Heightfield->Heights   = ArenaPushArray(Arena, f32, Side*Side);
+  Heightfield->Side      = Side;
+  Heightfield->Origin    = Origin;
+  Heightfield->Spacing   = Spacing;
+  Heightfield->Amplitude = Amplitude;
+  return Heightfield->Heights != NULL;
+}
+u32 HeightfieldWrap(heightfield *Heightfield, s64 Index)
+{
+  s64 Result = Index%(s64)Heightfield->Side;
+  return (u32)((Result<0)?(Result+Heightfield->Side):Result);
+}
+// NOTE(MIGUEL): lattice index whose samples line up with a noise space offset of Offset. the
+//               terrain snaps its scroll to this so the cached samples stay exact.
+s64 HeightfieldScrollFor(heightfield *Heightfield, f64 Offset)
+{
+  return (s64)floor(Offset/(f64)Heightfield->Spacing);
+}
+// NOTE(MIGUEL): evaluates lattice columns [Col, Col+Count) of lattice row Row. Count <= Side.
+void HeightfieldFillRow(heightfield *Heightfield, s64 Row, s64 Col, u32 Count)
+{
+  f32 *RowHeights = Heightfield->Heights + (u64)HeightfieldWrap(Heightfield, Row)*Heightfield->Side;
+  f32x4 Step4     = F32x4Set1(4.0f*Heightfield->Spacing);
+  f32x4 Amplitude = F32x4Set1(Heightfield->Amplitude);
+  f32x4 pz = F32x4Set1(Heightfield->Origin + (f32)Row*Heightfield->Spacing);
+  //at most two runs of storage, split where the column index wraps
+  while(Count)
+  {
+    u32 Start = HeightfieldWrap(Heightfield, Col);
+    u32 RunCount = Min(Count, Heightfield->Side-Start);
+    f32 *Dest = RowHeights+Start;
+    f32 x0 = Heightfield->Origin + (f32)Col*Heightfield->Spacing;
+    f32 dx = Heightfield->Spacing;
+    f32x4 px = F32x4Set(x0, x0+dx, x0+2.0f*dx, x0+3.0f*dx);
+    u32 i = 0;
+    for(; i+4<=RunCount; i+=4)
+    {
+      F32x4Store(Dest+i, F32x4Mul(HeightfieldNoise4(px, pz), Amplitude));
+      px = F32x4Add(px, Step4);
+    }
+    if(i<RunCount)
+    {
+      f32 Tail[4];
+      F32x4Store(Tail, F32x4Mul(HeightfieldNoise4(px, pz), Amplitude));
+      for(u32 j=0; i<RunCount; i++, j++) { Dest[i] = Tail[j]; }
+    }
+    Col   += RunCount;
+    Count -= RunCount;
+  }
+  return;
+}
+// NOTE(MIGUEL): moving the cached window to start at Scroll. rows that are new get filled
+//               whole, rows that stay only get the columns that came in. Split in three so the
+//               rows can be spread over jobs: rows never share storage and nothing but the
+//               samples is written until HeightfieldUpdateEnd.
+b32 HeightfieldNeedsUpdate(heightfield *Heightfield, s64 Scroll)
+{
+  return !(Heightfield->IsValid && Scroll == Heightfield->Scroll);
+}
+//rows [RowBegin, RowEnd) of the window at Scroll, returns how many samples it evaluated
+u32 HeightfieldUpdateRows(heightfield *Heightfield, s64 Scroll, u32 RowBegin, u32 RowEnd)
+{
+  s64 Side = Heightfield->Side;
+  s64 Old  = Heightfield->Scroll;
+  b32 IsRefill = (!Heightfield->IsValid || Scroll >= Old+Side || Scroll+Side <= Old);
+  s64 NewCol   = (Scroll > Old)?(Old+Side):Scroll;
+  u32 NewCount = (u32)((Scroll > Old)?(Scroll-Old):(Old-Scroll));
+  u32 SampleCount = 0;
+  for(s64 Row=Scroll+RowBegin; Row<Scroll+RowEnd; Row++)
+  {
+    b32 IsOldRow = (Row >= Old && Row < Old+Side);
+    if(IsRefill || !IsOldRow)
+    {
+      HeightfieldFillRow(Heightfield, Row, Scroll, (u32)Side);
+      SampleCount += (u32)Side;
+    }
+    else
+    {
+      HeightfieldFillRow(Heightfield, Row, NewCol, NewCount);
+      SampleCount += NewCount;
+    }
+  }
+  return SampleCount;
+}
+void HeightfieldUpdateEnd(heightfield *Heightfield, s64 Scroll, u32 SampleCount)
+{
+  Heightfield->Scroll      = Scroll;
+  Heightfield->IsValid     = 1;
+  Heightfield->SampleCount = SampleCount;
+  return;
+}
+void HeightfieldUpdate(heightfield *Heightfield, s64 Scroll)
+{
+  Heightfield->SampleCount = 0;
+  if(!HeightfieldNeedsUpdate(Heightfield, Scroll)) return;
+  u32 SampleCount = HeightfieldUpdateRows(Heightfield, Scroll, 0, Heightfield->Side);
+  HeightfieldUpdateEnd(Heightfield, Scroll, SampleCount);
+  return;
+}
+// NOTE(MIGUEL): storage rects a copy of the heightfield taken at scroll From (a gpu texture)
+//               has to refresh to match it again. new rows and new columns, each split where
+//               the storage wraps. Rects needs HEIGHTFIELD_MAX_CHANGED_RECTS entries.
+u32 HeightfieldChangedRects(heightfield *Heightfield, s64 From, b32 IsFromValid, heightfield_rect *Rects)
+{
+  u32 Side = Heightfield->Side;
+  s64 Scroll = Heightfield->Scroll;
+  if(!Heightfield->IsValid) return 0;
+  if(!IsFromValid || Scroll >= From+Side || Scroll+Side <= From)
+  {
+    heightfield_rect All = { 0, 0, Side, Side };
+    Rects[0] = All;
+    return 1;
+  }
+  if(Scroll == From) return 0;
+  s64 First = (Scroll > From)?(From+Side):Scroll;
+  u32 Count = (u32)((Scroll > From)?(Scroll-From):(From-Scroll));
+  u32 Start = HeightfieldWrap(Heightfield, First);
+  u32 Runs[2][2] = { { Start, Min(Count, Side-Start) }, { 0, Count-Min(Count, Side-Start) } };
+  u32 RectCount = 0;
+  for(u32 Run=0; Run<2; Run++)
+  {
+    if(!Runs[Run][1]) continue;
+    heightfield_rect Rows = { 0, Runs[Run][0], Side, Runs[Run][1] };
+    heightfield_rect Cols = { Runs[Run][0], 0, Runs[Run][1], Side };
+    Rects[RectCount++] = Rows;
+    Rects[RectCount++] = Cols;
+  }
+  return RectCount;
+}
+
+#endif //HEIGHTFIELD_H
@@ -0,0 +1,179 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+// NOTE(MIGUEL): Input events from the platform to the engine. The platform's input callback is
+//               the one producer and EngineUpdate the one consumer, so the queue is a plain
+//               single producer single consumer ring: each side owns one index and only reads the
+//               other's. Every pointer and every historical sample is its own event, stamped with
+//               the time the os says it happened (CLOCK_MONOTONIC, same clock as GetTimeNanos),
+//               so nothing between two frames gets overwritten. A full queue drops the newest
+//               event and counts it.
+#define INPUT_QUEUE_CAPACITY (1024) //power of 2
+#define INPUT_FRAME_MAX_EVENTS (256) //drained per frame, the rest waits for the next one
+#define INPUT_MAX_POINTERS (10)
+#define INPUT_NULL_POINTER_ID (-1)
+typedef enum input_event_kind input_event_kind;
+enum input_event_kind
+{
+  InputEvent_Down,
+  InputEvent_Move,
+  InputEvent_Up,
+  InputEvent_Cancel, //the os took the gesture away, every pointer is up
+};
+typedef struct input_event input_event;
+struct input_event
+{
+  u64 TimeNs;
+  input_event_kind Kind;
+  s32 PointerId;
+  v2f Pos;
+};
+typedef struct input_queue input_queue;
+struct input_queue
+{
+  u64 Written; //only the producer writes this
+  u8  WrittenPad[64-sizeof(u64)];
+  u64 Read;    //only the consumer writes this
+  u8  ReadPad[64-sizeof(u64)];
+  u32 DroppedCount; //producer side
+  input_event Events[INPUT_QUEUE_CAPACITY];
+};
+typedef struct input_pointer input_pointer;
+struct input_pointer
+{
+  s32 Id;
+  v2f Pos;
+};
+// NOTE(MIGUEL): what the events drained this frame add up to. The primary pointer is the one
+//               that went down first with nothing else down, it is what the ui follows. A press
+//               and release inside one frame shows up as JustPressed and JustReleased both set.
+typedef struct input_state input_state;
+struct input_state
+{
+  input_pointer Pointers[INPUT_MAX_POINTERS]; //down right now
+  u32 PointerCount;
+  s32 PrimaryId;
+  v2f PrimaryPos; //stays where it was last seen after the release
+  b32 IsPressed;
+  b32 JustPressed;
+  b32 JustReleased;
+  v2f Delta;      //primary pointer movement this frame
+  //this frame's events in order, for anything that needs more than the summary
+  input_event Events[INPUT_FRAME_MAX_EVENTS];
+  u32 EventCount;
+};
+//- queue
+b32 InputQueuePush(input_queue *Queue, input_event Event)
+{
+  u64 Read = __atomic_load_n(&Queue->Read, __ATOMIC_ACQUIRE);
+  if(Queue->Written-Read >= INPUT_QUEUE_CAPACITY)
+  {
+    Queue->DroppedCount++;
+    return 0;
+  }
+  Queue->Events[Queue->Written&(INPUT_QUEUE_CAPACITY-1)] = Event;
+  __atomic_store_n(&Queue->Written, Queue->Written+1, __ATOMIC_RELEASE);
+  return 1;
+}
+void InputQueuePushEvent(input_queue *Queue, u64 TimeNs, input_event_kind Kind, s32 PointerId, v2f Pos)
+{
+  input_event Event = { TimeNs, Kind, PointerId, Pos };
+  InputQueuePush(Queue, Event);
+  return;
+}
+//copies out up to MaxCount of the oldest events and releases their slots
+u32 InputQueuePop(input_queue *Queue, input_event *Dest, u32 MaxCount)
+{
+  u64 Written = __atomic_load_n(&Queue->Written, __ATOMIC_ACQUIRE);
+  u32 Count = (u32)Min(Written-Queue->Read, (u64)MaxCount);
+  for(u32 i=0; i<Count; i++)
+  {
+    Dest[i] = Queue->Events[(Queue->Read+i)&(INPUT_QUEUE_CAPACITY-1)];
+  }
+  __atomic_store_n(&Queue->Read, Queue->Read+Count, __ATOMIC_RELEASE);
+  return Count;
+}
+//- state
+void InputStateInit(input_state *State)
+{
+  MemorySet(0, State, sizeof(input_state));
+  State->PrimaryId = INPUT_NULL_POINTER_ID;
+  return;
+}
+input_pointer *InputStateFindPointer(input_state *State, s32 PointerId)
+{
+  for(u32 i=0; i<State->PointerCount; i++)
+  {
+    if(State->Pointers[i].Id == PointerId) return &State->Pointers[i];
+  }
+  return NULL;
+}
+void InputStateRemovePointer(input_state *State, s32 PointerId)
+{
+  input_pointer *Pointer = InputStateFindPointer(State, PointerId);
+  if(Pointer) { *Pointer = State->Pointers[--State->PointerCount]; }
+  if(PointerId == State->PrimaryId)
+  {
+    State->PrimaryId    = INPUT_NULL_POINTER_ID;
+    State->IsPressed    = 0;
+    State->JustReleased = 1;
+  }
+  return;
+}
+void InputStateApply(input_state *State, input_event *Event)
+{
+  switch(Event->Kind)
+  {
+    case InputEvent_Down:
+    {
+      input_pointer *Pointer = InputStateFindPointer(State, Event->PointerId);
+      if(!Pointer && State->PointerCount < INPUT_MAX_POINTERS)
+      {
+        Pointer = &State->Pointers[State->PointerCount++];
+        Pointer->Id = Event->PointerId;
+      }
+      if(Pointer) { Pointer->Pos = Event->Pos; }
+      if(State->PrimaryId == INPUT_NULL_POINTER_ID && State->PointerCount == 1)
+      {
+        State->PrimaryId   = Event->PointerId;
+        State->PrimaryPos  = Event->Pos;
+        State->IsPressed   = 1;
+        State->JustPressed = 1;
+      }
+    } break;
+    case InputEvent_Move:
+    {
+      input_pointer *Pointer = InputStateFindPointer(State, Event->PointerId);
+      if(Pointer) { Pointer->Pos = Event->Pos; }
+      if(Event->PointerId == State->PrimaryId)
+      {
+        State->Delta.x   += Event->Pos.x-State->PrimaryPos.x;
+        State->Delta.y   += Event->Pos.y-State->PrimaryPos.y;
+        State->PrimaryPos = Event->Pos;
+      }
+    } break;
+    case InputEvent_Up:
+    {
+      if(Event->PointerId == State->PrimaryId) { State->PrimaryPos = Event->Pos; }
+      InputStateRemovePointer(State, Event->PointerId);
+    } break;
+    case InputEvent_Cancel:
+    {
+      while(State->PointerCount) { InputStateRemovePointer(State, State->Pointers[0].Id); }
+    } break;
+  }
+  return;
+}
+// NOTE(MIGUEL): start of a frame, drains the queue into the frame's event list and folds the
+//               events into the state in the order they happened
+void InputStateUpdate(input_state *State, input_queue *Queue)
+{
+  State->JustPressed  = 0;
+  State->JustReleased = 0;
+  State->Delta        = V2f(0.0f, 0.0f);
+  State->EventCount   = InputQueuePop(Queue, State->Events, INPUT_FRAME_MAX_EVENTS);
+  for(u32 i=0; i<State->EventCount; i++) { InputStateApply(State, &State->Events[i]); }
+  return;
+}
+
+#endif //INPUT_H
@@ -0,0 +1,272 @@
+#ifndef JOBS_H
+#define JOBS_H
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+// NOTE(MIGUEL): Job system. One thread per core, the thread that calls JobSystemInit is thread 0
+//               and the rest are workers. Every thread owns a Chase-Lev work stealing deque: it
+//               pushes and pops its own jobs at the bottom (lifo, stays in cache) and idle threads
+//               steal from the top of someone else's. Jobs only push to the deque of the thread
+//               they run on, so the owner side never needs a lock.
+//               Dependencies are counters: JobRun bumps the counter, the job finishing drops it
+//               and JobWait runs other jobs until it hits 0, so waiting inside a job is fine.
+//               Workers with nothing to steal spin a little and then sleep until something is
+//               pushed.
+#define JOB_MAX_THREADS    (16)
+#define JOB_DEQUE_CAPACITY (256) //power of 2, a full deque runs the job inline instead
+#define JOB_SPIN_COUNT     (64)  //empty steal rounds before a worker goes to sleep
+#define JOB_CACHE_LINE     (64)
+typedef void job_proc(void *Data);
+typedef struct job_counter job_counter;
+struct job_counter
+{
+  s32 Pending;
+};
+typedef struct job job;
+struct job
+{
+  job_proc *Proc;
+  void *Data;
+  job_counter *Counter;
+};
+typedef struct job_deque job_deque;
+struct job_deque
+{
+  s64 Top;    //thieves take from here
+  u8  TopPad[JOB_CACHE_LINE-sizeof(s64)];
+  s64 Bottom; //only the owner writes this
+  u8  BottomPad[JOB_CACHE_LINE-sizeof(s64)];
+  job Jobs[JOB_DEQUE_CAPACITY];
+};
+typedef struct job_system job_system;
+typedef struct job_thread job_thread;
+struct job_thread
+{
+  job_deque Deque;
+  job_system *System;
+  pthread_t Thread;
+  u32 Index;
+  u32 Random;        //victim picking, xorshift
+  u64 ExecutedCount; //only written by this thread, relaxed atomics so stats can read it live
+  u64 StolenCount;
+};
+struct job_system
+{
+  job_thread Threads[JOB_MAX_THREADS];
+  u32 ThreadCount;
+  s32 QueuedCount;   //pushed and not taken yet, what sleeping workers wait on
+  s32 SleepingCount;
+  b32 IsRunning;
+  pthread_mutex_t Lock;
+  pthread_cond_t  Wake;
+};
+//thread the calling code is on, NULL on threads the job system doesnt know about
+__thread job_thread *GlobalJobThread = NULL;
+//~ DEQUE
+// NOTE(MIGUEL): Le, Pop, Cohen, Zappa Nardelli "Correct and Efficient Work-Stealing for Weak
+//               Memory Models", fixed size. Push and Pop are owner only, Steal is any thread.
+// NOTE(MIGUEL): a thief can read a slot while the owner wraps around and refills it, the CAS on
+//               Top throws that copy away but the slot itself still has to be accessed
+//               atomically, field by field (relaxed, ordering comes from Top/Bottom).
+void JobSlotStore(job *Slot, job Job)
+{
+  __atomic_store_n(&Slot->Proc,    Job.Proc,    __ATOMIC_RELAXED);
+  __atomic_store_n(&Slot->Data,    Job.Data,    __ATOMIC_RELAXED);
+  __atomic_store_n(&Slot->Counter, Job.Counter, __ATOMIC_RELAXED);
+  return;
+}
+job JobSlotLoad(job *Slot)
+{
+  job Result;
+  Result.Proc    = __atomic_load_n(&Slot->Proc,    __ATOMIC_RELAXED);
+  Result.Data    = __atomic_load_n(&Slot->Data,    __ATOMIC_RELAXED);
+  Result.Counter = __atomic_load_n(&Slot->Counter, __ATOMIC_RELAXED);
+  return Result;
+}
+b32 JobDequePush(job_deque *Deque, job Job)
+{
+  s64 Bottom = __atomic_load_n(&Deque->Bottom, __ATOMIC_RELAXED);
+  s64 Top    = __atomic_load_n(&Deque->Top, __ATOMIC_ACQUIRE);
+  if(Bottom-Top >= JOB_DEQUE_CAPACITY) return 0;
+  JobSlotStore(&Deque->Jobs[Bottom&(JOB_DEQUE_CAPACITY-1)], Job);
+  //a release store rather than the paper's release fence, same ordering and tsan can see it
+  __atomic_store_n(&Deque->Bottom, Bottom+1, __ATOMIC_RELEASE);
+  return 1;
+}
+b32 JobDequePop(job_deque *Deque, job *Job)
+{
+  s64 Bottom = __atomic_load_n(&Deque->Bottom, __ATOMIC_RELAXED)-1;
+  __atomic_store_n(&Deque->Bottom, Bottom, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  s64 Top = __atomic_load_n(&Deque->Top, __ATOMIC_RELAXED);
+  b32 Result = 0;
+  if(Top <= Bottom)
+  {
+    *Job = JobSlotLoad(&Deque->Jobs[Bottom&(JOB_DEQUE_CAPACITY-1)]);
+    Result = 1;
+    if(Top == Bottom)
+    {
+      //last job, race the thieves for it
+      Result = __atomic_compare_exchange_n(&Deque->Top, &Top, Top+1, 0,
+                                           __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+      __atomic_store_n(&Deque->Bottom, Bottom+1, __ATOMIC_RELAXED);
+    }
+  }
+  else
+  {
+    __atomic_store_n(&Deque->Bottom, Bottom+1, __ATOMIC_RELAXED);
+  }
+  return Result;
+}
+b32 JobDequeSteal(job_deque *Deque, job *Job)
+{
+  s64 Top = __atomic_load_n(&Deque->Top, __ATOMIC_ACQUIRE);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  s64 Bottom = __atomic_load_n(&Deque->Bottom, __ATOMIC_ACQUIRE);
+  if(Top >= Bottom) return 0;
+  *Job = JobSlotLoad(&Deque->Jobs[Top&(JOB_DEQUE_CAPACITY-1)]);
+  return __atomic_compare_exchange_n(&Deque->Top, &Top, Top+1, 0,
+                                     __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+}
+//~ RUNNING
+void JobExecute(job_thread *Self, job Job)
+{
+  Job.Proc(Job.Data);
+  __atomic_store_n(&Self->ExecutedCount, Self->ExecutedCount+1, __ATOMIC_RELAXED);
+  if(Job.Counter) { __atomic_sub_fetch(&Job.Counter->Pending, 1, __ATOMIC_RELEASE); }
+  return;
+}
+// NOTE(MIGUEL): own deque first, then one pass over the others starting at a random one
+b32 JobTryRunOne(job_system *System, job_thread *Self)
+{
+  job Job;
+  b32 IsTaken = JobDequePop(&Self->Deque, &Job);
+  u32 ThreadCount = __atomic_load_n(&System->ThreadCount, __ATOMIC_ACQUIRE);
+  for(u32 i=0; !IsTaken && i<ThreadCount; i++)
+  {
+    Self->Random ^= Self->Random<<13;
+    Self->Random ^= Self->Random>>17;
+    Self->Random ^= Self->Random<<5;
+    job_thread *Victim = &System->Threads[(Self->Random+i)%ThreadCount];
+    if(Victim == Self) continue;
+    IsTaken = JobDequeSteal(&Victim->Deque, &Job);
+    if(IsTaken) { __atomic_store_n(&Self->StolenCount, Self->StolenCount+1, __ATOMIC_RELAXED); }
+  }
+  if(!IsTaken) return 0;
+  __atomic_sub_fetch(&System->QueuedCount, 1, __ATOMIC_SEQ_CST);
+  JobExecute(Self, Job);
+  return 1;
+}
+void *JobThreadProc(void *Param)
+{
+  job_thread *Self = (job_thread *)Param;
+  job_system *System = Self->System;
+  GlobalJobThread = Self;
+  u32 IdleCount = 0;
+  while(__atomic_load_n(&System->IsRunning, __ATOMIC_ACQUIRE))
+  {
+    if(JobTryRunOne(System, Self)) { IdleCount = 0; continue; }
+    if(++IdleCount < JOB_SPIN_COUNT) { sched_yield(); continue; }
+    //sleeping is announced before QueuedCount is checked and JobRun checks them the other way
+    //round, so either this sees the job or JobRun sees the sleeper
+    pthread_mutex_lock(&System->Lock);
+    __atomic_add_fetch(&System->SleepingCount, 1, __ATOMIC_SEQ_CST);
+    while(__atomic_load_n(&System->QueuedCount, __ATOMIC_SEQ_CST) <= 0 &&
+          __atomic_load_n(&System->IsRunning, __ATOMIC_ACQUIRE))
+    {
+      pthread_cond_wait(&System->Wake, &System->Lock);
+    }
+    __atomic_sub_fetch(&System->SleepingCount, 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&System->Lock);
+    IdleCount = 0;
+  }
+  return NULL;
+}
+// NOTE(MIGUEL): queues Proc(Data) on the calling thread's deque. From a thread the system
+//               doesnt own, or with the deque full, the job just runs here.
+void JobRun(job_system *System, job_proc *Proc, void *Data, job_counter *Counter)
+{
+  job Job = { Proc, Data, Counter };
+  job_thread *Self = GlobalJobThread;
+  if(Counter) { __atomic_add_fetch(&Counter->Pending, 1, __ATOMIC_RELAXED); }
+  if(!Self || Self->System != System || !JobDequePush(&Self->Deque, Job))
+  {
+    Proc(Data);
+    if(Counter) { __atomic_sub_fetch(&Counter->Pending, 1, __ATOMIC_RELEASE); }
+    return;
+  }
+  __atomic_add_fetch(&System->QueuedCount, 1, __ATOMIC_SEQ_CST);
+  if(__atomic_load_n(&System->SleepingCount, __ATOMIC_SEQ_CST) > 0)
+  {
+    pthread_mutex_lock(&System->Lock);
+    pthread_cond_signal(&System->Wake);
+    pthread_mutex_unlock(&System->Lock);
+  }
+  return;
+}
+// NOTE(MIGUEL): helps out instead of blocking, on a single thread system this is what runs
+//               everything
+void JobWait(job_system *System, job_counter *Counter)
+{
+  job_thread *Self = GlobalJobThread;
+  while(__atomic_load_n(&Counter->Pending, __ATOMIC_ACQUIRE) > 0)
+  {
+    if(!Self || !JobTryRunOne(System, Self)) { sched_yield(); }
+  }
+  return;
+}
+//~ SETUP
+u32 JobSystemDefaultThreadCount(void)
+{
+  long CoreCount = sysconf(_SC_NPROCESSORS_ONLN);
+  return (u32)Min(Max(CoreCount, 1), JOB_MAX_THREADS);
+}
+// NOTE(MIGUEL): ThreadCount counts the calling thread, 0 means one per core. Ends up with fewer
+//               threads (down to just the caller) if some fail to start. Workers are already
+//               stealing while the rest start, so the count only grows and is published
+//               atomically once a thread is really up.
+void JobSystemInit(job_system *System, u32 ThreadCount)
+{
+  MemorySet(0, System, sizeof(job_system));
+  if(ThreadCount == 0) { ThreadCount = JobSystemDefaultThreadCount(); }
+  ThreadCount = Min(ThreadCount, JOB_MAX_THREADS);
+  pthread_mutex_init(&System->Lock, NULL);
+  pthread_cond_init(&System->Wake, NULL);
+  System->IsRunning = 1;
+  for(u32 Index=0; Index<ThreadCount; Index++)
+  {
+    job_thread *Thread = &System->Threads[Index];
+    Thread->System = System;
+    Thread->Index  = Index;
+    Thread->Random = 2463534242u+Index*2654435761u;
+  }
+  GlobalJobThread = &System->Threads[0];
+  __atomic_store_n(&System->ThreadCount, 1, __ATOMIC_RELEASE);
+  for(u32 Index=1; Index<ThreadCount; Index++)
+  {
+    job_thread *Thread = &System->Threads[Index];
+    if(pthread_create(&Thread->Thread, NULL, JobThreadProc, Thread) != 0) break;
+    __atomic_store_n(&System->ThreadCount, Index+1, __ATOMIC_RELEASE);
+  }
+  return;
+}
+// NOTE(MIGUEL): nothing may be in flight, call from thread 0
+void JobSystemTerm(job_system *System)
+{
+  __atomic_store_n(&System->IsRunning, 0, __ATOMIC_RELEASE);
+  pthread_mutex_lock(&System->Lock);
+  pthread_cond_broadcast(&System->Wake);
+  pthread_mutex_unlock(&System->Lock);
+  for(u32 Index=1; Index<System->ThreadCount; Index++)
+  {
+    pthread_join(System->Threads[Index].Thread, NULL);
+  }
+  pthread_mutex_destroy(&System->Lock);
+  pthread_cond_destroy(&System->Wake);
+  __atomic_store_n(&System->ThreadCount, 0, __ATOMIC_RELEASE);
+  if(GlobalJobThread && GlobalJobThread->System == System) { GlobalJobThread = NULL; }
+  return;
+}
+
+#endif //JOBS_H
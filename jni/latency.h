@@ -0,0 +1,54 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+// NOTE(MIGUEL): Rolling latency histogram. Fixed width buckets, the last one takes everything
+//               past the range. Only the last LATENCY_WINDOW_COUNT samples are in the buckets,
+//               the window remembers each sample's bucket so the oldest can be taken back out,
+//               so percentiles follow what the app is doing now and adding is O(1).
+#define LATENCY_BUCKET_NS (250000) //0.25ms
+#define LATENCY_BUCKET_COUNT (256) //64ms, fits the window's u8
+#define LATENCY_WINDOW_COUNT (4096)
+typedef struct latency_histogram latency_histogram;
+struct latency_histogram
+{
+  u32 Buckets[LATENCY_BUCKET_COUNT];
+  u8  Window[LATENCY_WINDOW_COUNT];
+  u32 WindowCount;
+  u32 Next;
+  u64 TotalCount; //ever added
+  u64 MaxNs;      //ever seen
+};
+void LatencyHistogramAdd(latency_histogram *Histogram, u64 Ns)
+{
+  u32 Bucket = (u32)Min(Ns/LATENCY_BUCKET_NS, (u64)LATENCY_BUCKET_COUNT-1);
+  if(Histogram->WindowCount == LATENCY_WINDOW_COUNT)
+  {
+    Histogram->Buckets[Histogram->Window[Histogram->Next]]--;
+  }
+  else
+  {
+    Histogram->WindowCount++;
+  }
+  Histogram->Window[Histogram->Next] = (u8)Bucket;
+  Histogram->Next = (Histogram->Next+1)%LATENCY_WINDOW_COUNT;
+  Histogram->Buckets[Bucket]++;
+  Histogram->TotalCount++;
+  Histogram->MaxNs = Max(Histogram->MaxNs, Ns);
+  return;
+}
+// NOTE(MIGUEL): upper edge of the bucket the percentile lands in, ns. 0 with no samples.
+u64 LatencyHistogramPercentile(latency_histogram *Histogram, f64 Percentile)
+{
+  if(Histogram->WindowCount == 0) return 0;
+  u32 Rank = (u32)(Percentile*(f64)(Histogram->WindowCount-1)+0.5);
+  u32 Seen = 0;
+  u32 Bucket = 0;
+  for(; Bucket<LATENCY_BUCKET_COUNT-1; Bucket++)
+  {
+    Seen += Histogram->Buckets[Bucket];
+    if(Seen > Rank) break;
+  }
+  return (u64)(Bucket+1)*LATENCY_BUCKET_NS;
+}
+
+#endif //LATENCY_H
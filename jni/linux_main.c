@@ -0,0 +1,632 @@
+// NOTE(MIGUEL): headless linux platform layer. builds the same engine core as main.c against the
+//               null gl backend and drives it with scripted touch input to get per-phase frame times.
+//               see host.sh at the project root for how to build/run it.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#define GFX_BACKEND_NULL 1
+
+int GlobalHostVerbose = 0;
+#define LOG(...) \
+do { \
+if(GlobalHostVerbose) { fprintf(stderr, __VA_ARGS__); fputc('\n', stderr); } \
+} while(0)
+#define Assert(condition, ...) \
+do { \
+if(!(condition)) \
+{ fprintf(stderr, "NativeApp[ASSERT]! "); fprintf(stderr, __VA_ARGS__); fputc('\n', stderr); } \
+} while(0)
+
+#include "engine.h"
+
+//~ ASSETS
+typedef struct host_file host_file;
+struct host_file
+{
+  char *Data;
+  s32   Size;
+};
+host_file HostReadEntireFile(const char *Dir, const char *Name)
+{
+  host_file Result = {0};
+  char Path[1024];
+  snprintf(Path, sizeof(Path), "%s/%s", Dir, Name);
+  FILE *File = fopen(Path, "rb");
+  if(!File) { fprintf(stderr, "error opening %s\n", Path); return Result; }
+  fseek(File, 0, SEEK_END);
+  long Size = ftell(File);
+  fseek(File, 0, SEEK_SET);
+  Result.Data = malloc(Size+1);
+  Result.Size = (s32)fread(Result.Data, 1, Size, File);
+  Result.Data[Result.Size] = 0;
+  fclose(File);
+  return Result;
+}
+
+//~ INPUT SCRIPT
+typedef enum bench_touch_kind bench_touch_kind;
+enum bench_touch_kind
+{
+  BenchTouch_Down,
+  BenchTouch_Move,
+  BenchTouch_Up,
+};
+typedef struct bench_touch bench_touch;
+struct bench_touch
+{
+  u32 Frame;
+  bench_touch_kind Kind;
+  v2f Pos;
+};
+#define BENCH_SCRIPT_MAX_COUNT (4096)
+typedef struct bench_script bench_script;
+struct bench_script
+{
+  bench_touch Touches[BENCH_SCRIPT_MAX_COUNT];
+  u32 Count;
+  u32 Period; //script loops every Period frames
+};
+void BenchScriptPush(bench_script *Script, u32 Frame, bench_touch_kind Kind, f32 x, f32 y)
+{
+  if(Script->Count >= BENCH_SCRIPT_MAX_COUNT) return;
+  bench_touch *Touch = &Script->Touches[Script->Count++];
+  Touch->Frame = Frame;
+  Touch->Kind  = Kind;
+  Touch->Pos   = V2f(x, y);
+  return;
+}
+void BenchScriptDefault(bench_script *Script, v2f Res)
+{
+  // NOTE(MIGUEL): v button centers are the hardcoded rects from EngineInit
+  v2f PushBtn = V2f( 40.0f+100.0f, Res.y-980.0f+100.0f);
+  v2f PopBtn  = V2f(240.0f+100.0f, Res.y-980.0f+100.0f);
+  Script->Count  = 0;
+  Script->Period = 120;
+  //push a few elements
+  for(u32 Tap=0; Tap<4; Tap++)
+  {
+    BenchScriptPush(Script, Tap*10+0, BenchTouch_Down, PushBtn.x, PushBtn.y);
+    BenchScriptPush(Script, Tap*10+2, BenchTouch_Up  , PushBtn.x, PushBtn.y);
+  }
+  //select and drag the first pushed element across the screen
+  BenchScriptPush(Script, 40, BenchTouch_Down, 100.0f, 50.0f);
+  BenchScriptPush(Script, 42, BenchTouch_Up  , 100.0f, 50.0f);
+  BenchScriptPush(Script, 44, BenchTouch_Down, 100.0f, 50.0f);
+  for(u32 Step=0; Step<30; Step++)
+  {
+    f32 t = (f32)Step/29.0f;
+    BenchScriptPush(Script, 45+Step, BenchTouch_Move, 100.0f+t*Res.x*0.5f, 50.0f+t*Res.y*0.5f);
+  }
+  BenchScriptPush(Script, 76, BenchTouch_Up, 100.0f+Res.x*0.5f, 50.0f+Res.y*0.5f);
+  //pop some of them back off
+  for(u32 Tap=0; Tap<4; Tap++)
+  {
+    BenchScriptPush(Script, 80+Tap*10+0, BenchTouch_Down, PopBtn.x, PopBtn.y);
+    BenchScriptPush(Script, 80+Tap*10+2, BenchTouch_Up  , PopBtn.x, PopBtn.y);
+  }
+  //swipe across empty terrain panel, lets go of the selection and flings the camera
+  for(u32 Step=0; Step<6; Step++)
+  {
+    BenchScriptPush(Script, 113+Step, Step?BenchTouch_Move:BenchTouch_Down, 1000.0f-Step*80.0f, 1200.0f);
+  }
+  BenchScriptPush(Script, 119, BenchTouch_Up, 520.0f, 1200.0f);
+  return;
+}
+// NOTE(MIGUEL): script file format, one touch per line: <frame> <down|move|up> <x> <y>
+//               an optional "period <frames>" line makes the script loop.
+b32 BenchScriptLoad(bench_script *Script, const char *Path)
+{
+  FILE *File = fopen(Path, "r");
+  if(!File) { fprintf(stderr, "error opening script %s\n", Path); return 0; }
+  Script->Count  = 0;
+  Script->Period = 0;
+  char Line[256];
+  while(fgets(Line, sizeof(Line), File))
+  {
+    u32 Frame = 0; char Kind[16] = {0}; f32 x = 0; f32 y = 0;
+    if(sscanf(Line, "period %u", &Frame) == 1) { Script->Period = Frame; continue; }
+    if(sscanf(Line, "%u %15s %f %f", &Frame, Kind, &x, &y) != 4) continue;
+    bench_touch_kind TouchKind = ((strcmp(Kind, "down")==0)?BenchTouch_Down:
+                                  (strcmp(Kind, "up"  )==0)?BenchTouch_Up:
+                                  BenchTouch_Move);
+    BenchScriptPush(Script, Frame, TouchKind, x, y);
+  }
+  fclose(File);
+  return 1;
+}
+// NOTE(MIGUEL): pushes the frame's touches the way AndroidHandleInput does, single pointer.
+//               stamped with the simulated frame time so gesture velocities are reproducible.
+void BenchPushTouches(bench_script *Script, input_queue *Queue, u32 Frame, u64 TimeNs)
+{
+  u32 ScriptFrame = Script->Period?(Frame%Script->Period):Frame;
+  for(u32 i=0; i<Script->Count; i++)
+  {
+    bench_touch *Touch = &Script->Touches[i];
+    if(Touch->Frame != ScriptFrame) continue;
+    input_event_kind Kind = ((Touch->Kind == BenchTouch_Down)?InputEvent_Down:
+                             (Touch->Kind == BenchTouch_Up  )?InputEvent_Up:
+                             InputEvent_Move);
+    InputQueuePushEvent(Queue, TimeNs, Kind, 0, Touch->Pos);
+  }
+  return;
+}
+
+//~ STATS
+typedef enum bench_phase bench_phase;
+enum bench_phase
+{
+  BenchPhase_UI,
+  BenchPhase_Bucket,
+  BenchPhase_Submit,
+  BenchPhase_Frame,
+  BenchPhase_Count,
+};
+const char *BenchPhaseNames[BenchPhase_Count] = { "ui", "bucket", "submit", "frame" };
+int BenchCompareU64(const void *a, const void *b)
+{
+  u64 x = *(const u64 *)a;
+  u64 y = *(const u64 *)b;
+  return (x>y) - (x<y);
+}
+f64 BenchPercentile(u64 *Sorted, u32 Count, f64 Percentile)
+{
+  u32 Index = (u32)(Percentile*(f64)(Count-1) + 0.5);
+  return (f64)Sorted[Index];
+}
+void BenchReport(u64 *Samples[BenchPhase_Count], u32 FrameCount)
+{
+  printf("%-8s %10s %10s %10s %10s\n", "phase", "p50(us)", "p99(us)", "mean(us)", "max(us)");
+  for(u32 Phase=0; Phase<BenchPhase_Count; Phase++)
+  {
+    u64 *Sorted = Samples[Phase];
+    qsort(Sorted, FrameCount, sizeof(u64), BenchCompareU64);
+    f64 Sum = 0;
+    for(u32 i=0; i<FrameCount; i++) { Sum += (f64)Sorted[i]; }
+    printf("%-8s %10.2f %10.2f %10.2f %10.2f\n", BenchPhaseNames[Phase],
+           BenchPercentile(Sorted, FrameCount, 0.50)/1000.0,
+           BenchPercentile(Sorted, FrameCount, 0.99)/1000.0,
+           Sum/(f64)FrameCount/1000.0,
+           (f64)Sorted[FrameCount-1]/1000.0);
+  }
+  return;
+}
+
+#if defined(GFX_BACKEND_RECORD)
+void BenchReportGfxRecord(b32 DumpCmds)
+{
+  gfx_record *Record = &GlobalGfxRecord;
+  gfx_record_stats *Stats = &Record->Total;
+  f64 Frames = Record->FrameCount?(f64)Record->FrameCount:1.0;
+  printf("\n%-26s %12s %12s\n", "gl call", "calls/frame", "bytes/frame");
+  for(u32 Call=0; Call<GfxCall_Count; Call++)
+  {
+    if(!Stats->Calls[Call]) continue;
+    printf("%-26s %12.2f %12.1f\n", GfxCallNames[Call], Stats->Calls[Call]/Frames, Stats->Bytes[Call]/Frames);
+  }
+  printf("%-26s %12.2f %12.1f\n", "total", Stats->TotalCalls/Frames, Stats->TotalBytes/Frames);
+  if(DumpCmds)
+  {
+    printf("\nlast frame command log:\n");
+    for(u32 i=0; i<Record->CmdCount; i++)
+    {
+      gfx_cmd *Cmd = &Record->Cmds[i];
+      printf("%5u %-26s [", i, GfxCallNames[Cmd->Call]);
+      for(u32 Arg=0; Arg<Cmd->ArgCount; Arg++) { printf(Arg?" %u":"%u", Cmd->Args[Arg]); }
+      printf("] %u bytes\n", Cmd->Bytes);
+    }
+    if(Record->DroppedCount) { printf("%u commands dropped (log full)\n", Record->DroppedCount); }
+  }
+  return;
+}
+#endif
+
+//~ FRAME HOOK
+// NOTE(MIGUEL): runs inside EngineUpdate before the packet is closed. pushes the -quads load
+//               (dashboard style, past the mapped part these grow the bucket in the arena) and
+//               picks up the packet's stats while it still belongs to the update.
+typedef struct host_frame_hook host_frame_hook;
+struct host_frame_hook
+{
+  u32 QuadCount;
+  b32 IsMeasured;
+  u64 DroppedQuads;
+  u64 TerrainChunks;
+  u64 TerrainCulled;
+  u64 TerrainVisited;
+  u64 HeightSamples;
+  u64 InputEvents;
+};
+void HostFrameHook(struct engine *Engine, engine_frame_packet *Packet, void *Data)
+{
+  host_frame_hook *Hook = (host_frame_hook *)Data;
+  for(u32 i=0; i<Hook->QuadCount; i++)
+  {
+    f32 x = (f32)((i*13)%(u32)Engine->Width);
+    f32 y = (f32)((i*29)%(u32)Engine->Height);
+    DrawBucketPushRect(&Packet->Bucket, R2f(x, y, x+8.0f, y+8.0f), V4f(0.2f, 0.6f, 0.9f, 1.0f));
+  }
+  if(!Hook->IsMeasured) return;
+  Hook->DroppedQuads   += Packet->Bucket.DroppedCount;
+  Hook->TerrainChunks  += Packet->TerrainSelection.Count;
+  Hook->TerrainCulled  += Packet->TerrainSelection.CulledCount;
+  Hook->TerrainVisited += Packet->TerrainSelection.VisitedCount;
+  Hook->HeightSamples  += Engine->Terrain.Heightfield.SampleCount;
+  Hook->InputEvents    += Engine->Input.EventCount;
+  return;
+}
+
+//~ RENDER THREAD
+// NOTE(MIGUEL): -renderthread draws the packets on their own thread the way main.c does, the
+//               null backend doesnt care which thread calls it. one packet per frame, so the
+//               render thread knows which are warmup by counting them.
+typedef struct host_render_thread host_render_thread;
+struct host_render_thread
+{
+  struct engine *Engine;
+  pthread_t Thread;
+  u32 WarmupCount;
+  gfx_frame_stats Stats;
+  u64 *SubmitSamples; //render time without the wait for a packet
+  u32 SubmitCount;
+  u32 SubmitCapacity;
+};
+void HostGfxStatsAccumulate(gfx_frame_stats *Total, gfx_frame_stats *Frame)
+{
+  Total->UniformUploads += Frame->UniformUploads;
+  Total->UniformSkips   += Frame->UniformSkips;
+  Total->StateCalls     += Frame->StateCalls;
+  Total->StateSkips     += Frame->StateSkips;
+  Total->StreamBytes    += Frame->StreamBytes;
+  Total->MappedBytes    += Frame->MappedBytes;
+  Total->StreamStalls   += Frame->StreamStalls;
+  Total->OverflowDraws  += Frame->OverflowDraws;
+  Total->RenderCmds     += Frame->RenderCmds;
+  Total->DrawCalls      += Frame->DrawCalls;
+  Total->MergedDraws    += Frame->MergedDraws;
+  return;
+}
+// NOTE(MIGUEL): written after the packet is given back (latency when presented, the wait for the
+//               next packet), so waiting for the queue to go idle doesnt make them safe to
+//               touch. only whoever renders resets them, between two frames.
+void HostResetPresentStats(struct engine *Engine)
+{
+  MemorySet(0, Engine->Latency, sizeof(Engine->Latency));
+  Engine->PacketQueue.ConsumerWaitNs = 0;
+  return;
+}
+void *HostRenderThreadProc(void *Param)
+{
+  host_render_thread *Render = (host_render_thread *)Param;
+  packet_queue *Queue = &Render->Engine->PacketQueue;
+  for(u32 Rendered=0;; Rendered++)
+  {
+    if(Rendered == Render->WarmupCount) { HostResetPresentStats(Render->Engine); }
+    u64 Begin  = GetTimeNanos();
+    u64 WaitNs = Queue->ConsumerWaitNs;
+    if(!EngineRender(Render->Engine, 1)) break;
+    u64 End = GetTimeNanos();
+    //no swap here, the frame counts as presented once it is submitted
+    EngineFramePresented(Render->Engine, End);
+    if(Rendered < Render->WarmupCount) continue;
+    HostGfxStatsAccumulate(&Render->Stats, &GlobalGfxFrameStats);
+    if(Render->SubmitCount < Render->SubmitCapacity)
+    {
+      Render->SubmitSamples[Render->SubmitCount++] = End-Begin-(Queue->ConsumerWaitNs-WaitNs);
+    }
+  }
+  return NULL;
+}
+
+//~ MAIN
+int main(int ArgCount, char **Args)
+{
+  const char *AssetDir   = "assets";
+  const char *ScriptPath = NULL;
+#if defined(GFX_BACKEND_RECORD)
+  b32 DumpCmds = 0;
+#endif
+  u32 FrameCount   = 2000;
+  u32 WarmupCount  = 60;
+  u32 ElementCount = 0;
+  u32 QuadCount    = 0;
+  u32 UIElementCapacity = ENGINE_UI_ELEMENT_CAPACITY;
+  b32 TerrainTriangles  = 0;
+  b32 IsRenderThread    = 0;
+  b32 IsRealTimeInput   = 0;
+  u32 TargetFps         = 0; //0: run flat out
+  u32 JobThreadCount    = 0;
+  u32 FramePackets      = ENGINE_FRAME_PACKETS;
+  s32 TerrainHeights    = -1; //-1: engine default, TerrainHeights_Count: alternate every frame
+  s32 Width  = 1080;
+  s32 Height = 2340;
+  for(int i=1; i<ArgCount; i++)
+  {
+    const char *Arg  = Args[i];
+    const char *Next = (i+1<ArgCount)?Args[i+1]:NULL;
+    if     (strcmp(Arg, "-v"       )==0) { GlobalHostVerbose = 1; }
+#if defined(GFX_BACKEND_RECORD)
+    else if(strcmp(Arg, "-dumpcmds")==0) { DumpCmds = 1; }
+#endif
+    else if(strcmp(Arg, "-triangles")==0) { TerrainTriangles = 1; }
+    else if(strcmp(Arg, "-renderthread")==0) { IsRenderThread = 1; }
+    else if(strcmp(Arg, "-latency" )==0) { IsRealTimeInput = 1; }
+    else if(strcmp(Arg, "-fps"     )==0 && Next) { TargetFps = (u32)atoi(Next); i++; }
+    else if(strcmp(Arg, "-assets"  )==0 && Next) { AssetDir   = Next; i++; }
+    else if(strcmp(Arg, "-script"  )==0 && Next) { ScriptPath = Next; i++; }
+    else if(strcmp(Arg, "-frames"  )==0 && Next) { FrameCount   = (u32)atoi(Next); i++; }
+    else if(strcmp(Arg, "-warmup"  )==0 && Next) { WarmupCount  = (u32)atoi(Next); i++; }
+    else if(strcmp(Arg, "-elements")==0 && Next) { ElementCount = (u32)atoi(Next); i++; }
+    else if(strcmp(Arg, "-quads"   )==0 && Next) { QuadCount    = (u32)atoi(Next); i++; }
+    else if(strcmp(Arg, "-capacity")==0 && Next) { UIElementCapacity = (u32)atoi(Next); i++; }
+    else if(strcmp(Arg, "-jobs"    )==0 && Next) { JobThreadCount = (u32)atoi(Next); i++; }
+    else if(strcmp(Arg, "-packets" )==0 && Next) { FramePackets   = (u32)atoi(Next); i++; }
+    else if(strcmp(Arg, "-heights" )==0 && Next)
+    {
+      TerrainHeights = TerrainHeights_Count;
+      for(s32 Heights=0; Heights<TerrainHeights_Count; Heights++)
+      {
+        if(strcmp(Next, EngineTerrainHeightsNames[Heights])==0) { TerrainHeights = Heights; }
+      }
+      i++;
+    }
+    else if(strcmp(Arg, "-width"   )==0 && Next) { Width  = atoi(Next); i++; }
+    else if(strcmp(Arg, "-height"  )==0 && Next) { Height = atoi(Next); i++; }
+    else
+    {
+      printf("usage: %s [-assets dir] [-script file] [-frames n] [-warmup n] [-elements n]\n"
+             "          [-quads n] [-capacity n] [-triangles] [-heights stream|texture|ab]\n"
+             "          [-jobs n] [-renderthread] [-packets 2|3] [-latency] [-fps hz]\n"
+             "          [-width px] [-height px] [-dumpcmds] [-v]\n",
+             Args[0]);
+      return 1;
+    }
+  }
+  if(FrameCount == 0) { FrameCount = 1; }
+
+  host_file VFile   = HostReadEntireFile(AssetDir, "vertex.glsl");
+  host_file FFile   = HostReadEntireFile(AssetDir, "fragment.glsl");
+  host_file VFile3d = HostReadEntireFile(AssetDir, "vertex3d.glsl");
+  host_file FFile3d = HostReadEntireFile(AssetDir, "fragment3d.glsl");
+  if(!VFile.Data || !FFile.Data || !VFile3d.Data || !FFile3d.Data) { return 1; }
+  engine_shader_src Shader   = { VFile.Data  , VFile.Size  , FFile.Data  , FFile.Size   };
+  engine_shader_src Shader3d = { VFile3d.Data, VFile3d.Size, FFile3d.Data, FFile3d.Size };
+
+  //room for a bigger than default element table on top of the usual block
+  u64 EngineMemorySize = ENGINE_MEMORY_SIZE+(u64)UIElementCapacity*ENGINE_UI_ELEMENT_SIZE;
+  void *EngineMemory = malloc(EngineMemorySize);
+  struct engine *Engine = EngineMemory?EngineCreate(EngineMemory, EngineMemorySize, UIElementCapacity,
+                                                    JobThreadCount):NULL;
+  if(!Engine) { printf("error creating the engine\n"); return 1; }
+  if(TerrainTriangles) { Engine->TerrainTopology = MeshTopology_Triangles; }
+  if(TerrainHeights >= 0 && TerrainHeights < TerrainHeights_Count)
+  {
+    EngineSetTerrainHeights(Engine, (engine_terrain_heights)TerrainHeights);
+  }
+  EngineSetFramePackets(Engine, FramePackets);
+  if(TargetFps) { FramePacerSetRate(&Engine->Pacer, TargetFps); }
+  if(EngineInit(Engine, Width, Height, Shader, Shader3d) != 0) { return 1; }
+
+  // NOTE(MIGUEL): extra static elements to load the ui/bucket paths, declared by the engine every
+  //               frame, a layout element per ENGINE_DASHBOARD_COLUMNS of them for the rows.
+  //               leaves room for the toolbar, the panel and the script's own pushes.
+  u32 MaxPreload = (GlobalUIState.Capacity > 21)?
+    ((GlobalUIState.Capacity-21)*ENGINE_DASHBOARD_COLUMNS/(ENGINE_DASHBOARD_COLUMNS+1)):0;
+  if(ElementCount > MaxPreload) { ElementCount = MaxPreload; }
+  Engine->UIDashboardCount = ElementCount;
+
+  static bench_script Script = {0};
+  if(ScriptPath) { if(!BenchScriptLoad(&Script, ScriptPath)) return 1; }
+  else           { BenchScriptDefault(&Script, GlobalRes); }
+
+  u64 *Samples[BenchPhase_Count];
+  for(u32 Phase=0; Phase<BenchPhase_Count; Phase++)
+  {
+    Samples[Phase] = calloc(FrameCount, sizeof(u64));
+  }
+  host_render_thread Render = {0};
+  Render.Engine         = Engine;
+  Render.WarmupCount    = WarmupCount;
+  Render.SubmitSamples  = Samples[BenchPhase_Submit];
+  Render.SubmitCapacity = FrameCount;
+  if(IsRenderThread && pthread_create(&Render.Thread, NULL, HostRenderThreadProc, &Render) != 0)
+  {
+    printf("error creating the render thread\n");
+    return 1;
+  }
+  host_frame_hook Hook = {0};
+  Hook.QuadCount        = QuadCount;
+  Engine->FrameHook     = HostFrameHook;
+  Engine->FrameHookData = &Hook;
+  u64 PermanentUsed = 0;
+  // NOTE(MIGUEL): fixed timestep so runs are reproducible, the terrain only cares about UTime
+  GlobalDeltaTime = 1.0/60.0;
+  u64 StartNs = GetTimeNanos();
+  for(u32 Frame=0; Frame<WarmupCount+FrameCount; Frame++)
+  {
+    if(Frame == WarmupCount)
+    {
+      //measured frames always have terrain, on a fast host the warmup can outrun the build
+      TerrainBuildWait(&Engine->Terrain);
+      //render side stats are only safe to touch with nothing in flight
+      PacketQueueWaitIdle(&Engine->PacketQueue);
+      //init scratch (terrain build etc) would hide the steady state frame usage
+      for(u32 Slot=0; Slot<PACKET_QUEUE_MAX_COUNT; Slot++) { Engine->Packets[Slot].Arena.HighWater = 0; }
+      PermanentUsed = Engine->Memory.Permanent.Used;
+      MemorySet(0, Engine->HeightsStats, sizeof(Engine->HeightsStats));
+      GlobalUIState.Grid.TestedCount = 0;
+      GlobalUIState.LookupCount  = 0;
+      GlobalUIState.ProbeCount   = 0;
+      GlobalUIState.EvictedCount = 0;
+      GlobalUIState.MeasuredCount = 0;
+      GlobalUIState.ArrangedCount = 0;
+      Engine->Pacer.MissedCount = 0;
+      Engine->Pacer.WakeErrorNs = 0;
+      Engine->PacketQueue.ProducerWaitNs = 0;
+      //the render thread does its own when it gets here
+      if(!IsRenderThread) { HostResetPresentStats(Engine); }
+#if defined(GFX_BACKEND_RECORD)
+      //only the measured frames count towards the gl call averages
+      gfx_record_stats ZeroRecord = {0};
+      GlobalGfxRecord.Total = ZeroRecord;
+      GlobalGfxRecord.FrameCount = 0;
+#endif
+    }
+    if(TerrainHeights == TerrainHeights_Count)
+    {
+      EngineSetTerrainHeights(Engine, (engine_terrain_heights)(Frame%TerrainHeights_Count));
+    }
+    //-latency stamps touches with the real clock, so latency is real and gestures depend on
+    //how fast the host runs
+    BenchPushTouches(&Script, &Engine->InputQueue, Frame,
+                     IsRealTimeInput?GetTimeNanos():StartNs+(u64)(GlobalTimeElapsed*1000000000.0));
+    GlobalRes.x = Engine->Width;
+    GlobalRes.y = Engine->Height;
+
+    if(TargetFps)
+    {
+      //paced like main.c, the delta stays fixed so the run is still reproducible
+      FramePacerSleepUntil(&Engine->Pacer, FramePacerPlan(&Engine->Pacer, GetTimeNanos()));
+      FramePacerFrameBegin(&Engine->Pacer);
+    }
+    //the same update the device runs, the hook adds the -quads load and the stats
+    b32 IsMeasured = (Frame >= WarmupCount);
+    Hook.IsMeasured = IsMeasured;
+    u64 Begin = GetTimeNanos();
+    if(!EngineUpdate(Engine)) break;
+    if(TargetFps) { FramePacerFrameEnd(&Engine->Pacer, EngineIsAnimating(Engine)); }
+    u64 SubmitBegin = GetTimeNanos();
+    if(!IsRenderThread && EngineRender(Engine, 0)) { EngineFramePresented(Engine, GetTimeNanos()); }
+    u64 SubmitEnd = GetTimeNanos();
+
+    GlobalTimeElapsed += GlobalDeltaTime;
+    if(!IsMeasured) continue;
+    u32 Sample = Frame-WarmupCount;
+    if(!IsRenderThread)
+    {
+      HostGfxStatsAccumulate(&Render.Stats, &GlobalGfxFrameStats);
+      Samples[BenchPhase_Submit][Sample] = SubmitEnd-SubmitBegin;
+    }
+    Samples[BenchPhase_UI    ][Sample] = Engine->UpdateUINs;
+    Samples[BenchPhase_Bucket][Sample] = Engine->UpdateBucketNs;
+    Samples[BenchPhase_Frame ][Sample] = SubmitEnd-Begin;
+  }
+  PacketQueueWaitIdle(&Engine->PacketQueue);
+  if(IsRenderThread)
+  {
+    PacketQueueClose(&Engine->PacketQueue);
+    pthread_join(Render.Thread, NULL);
+  }
+  gfx_frame_stats GfxStats = Render.Stats;
+
+  printf("frames: %u  res: %dx%d  ui elements: %u  extra quads: %u\n",
+         FrameCount, Width, Height, GlobalUIState.ElementCount, QuadCount);
+  BenchReport(Samples, FrameCount);
+  printf("\nuniforms/frame: %.2f uploaded, %.2f skipped (unchanged)\n",
+         (f64)GfxStats.UniformUploads/FrameCount, (f64)GfxStats.UniformSkips/FrameCount);
+  printf("state changes/frame: %.2f sent, %.2f filtered (redundant)\n",
+         (f64)GfxStats.StateCalls/FrameCount, (f64)GfxStats.StateSkips/FrameCount);
+  printf("stream ring/frame: %.1f bytes, %u stalls total\n",
+         (f64)GfxStats.StreamBytes/FrameCount, GfxStats.StreamStalls);
+  printf("ui bucket/frame: %.1f bytes written in place, %.2f overflow draws, %llu quads dropped total\n",
+         (f64)GfxStats.MappedBytes/FrameCount, (f64)GfxStats.OverflowDraws/FrameCount,
+         (unsigned long long)Hook.DroppedQuads);
+  printf("render queue/frame: %.2f cmds, %.2f draws, %.2f merged\n",
+         (f64)GfxStats.RenderCmds/FrameCount, (f64)GfxStats.DrawCalls/FrameCount,
+         (f64)GfxStats.MergedDraws/FrameCount);
+  printf("ui picking/frame: %.2f elements tested, %ux%u grid of %.0fpx cells\n",
+         (f64)GlobalUIState.Grid.TestedCount/FrameCount, GlobalUIState.Grid.Width,
+         GlobalUIState.Grid.Height, GlobalUIState.Grid.CellSize);
+  printf("ui keys/frame: %.2f lookups, %.2f probes per lookup, %llu evicted total\n",
+         (f64)GlobalUIState.LookupCount/FrameCount,
+         (f64)GlobalUIState.ProbeCount/Max(GlobalUIState.LookupCount, 1),
+         (unsigned long long)GlobalUIState.EvictedCount);
+  printf("ui layout/frame: %.2f measured, %.2f arranged\n",
+         (f64)GlobalUIState.MeasuredCount/FrameCount, (f64)GlobalUIState.ArrangedCount/FrameCount);
+  printf("terrain/frame: %.2f chunks drawn, %.2f nodes culled, %.2f nodes visited\n",
+         (f64)Hook.TerrainChunks/FrameCount, (f64)Hook.TerrainCulled/FrameCount,
+         (f64)Hook.TerrainVisited/FrameCount);
+  printf("input/frame: %.2f events, %u dropped total\n",
+         (f64)Hook.InputEvents/FrameCount, Engine->InputQueue.DroppedCount);
+  if(TargetFps)
+  {
+    frame_pacer *Pacer = &Engine->Pacer;
+    printf("pacing: %u hz, %llu deadlines missed, %.1fus mean wake error, %.2fms predicted frame\n",
+           TargetFps, (unsigned long long)Pacer->MissedCount, Pacer->WakeErrorNs/1000.0/FrameCount,
+           Pacer->PredictedNs/1000000.0);
+  }
+  if(IsRealTimeInput)
+  {
+    for(u32 Stage=0; Stage<LatencyStage_Count; Stage++)
+    {
+      latency_histogram *Histogram = &Engine->Latency[Stage];
+      printf("input latency %-7s: %llu events, p50 %.2fms, p99 %.2fms, max %.3fms\n",
+             EngineLatencyStageNames[Stage], (unsigned long long)Histogram->TotalCount,
+             LatencyHistogramPercentile(Histogram, 0.50)/1000000.0,
+             LatencyHistogramPercentile(Histogram, 0.99)/1000000.0, Histogram->MaxNs/1000000.0);
+    }
+  }
+  printf("heightfield/frame: %.1f samples evaluated (%s)\n",
+         (f64)Hook.HeightSamples/FrameCount, SIMD_ISA_NAME);
+  for(u32 Heights=0; Heights<TerrainHeights_Count; Heights++)
+  {
+    engine_terrain_heights_stats *Stats = &Engine->HeightsStats[Heights];
+    if(!Stats->FrameCount) continue;
+    f64 Frames = (f64)Stats->FrameCount;
+    printf("terrain heights %-7s: %llu frames, %.2fus frame mean, %.2fus heights mean, %.1f bytes/frame\n",
+           EngineTerrainHeightsNames[Heights], (unsigned long long)Stats->FrameCount,
+           Stats->FrameNs/Frames/1000.0, Stats->HeightsNs/Frames/1000.0, Stats->Bytes/Frames);
+  }
+  u64 JobsExecuted = 0;
+  u64 JobsStolen   = 0;
+  for(u32 Index=0; Index<Engine->Jobs->ThreadCount; Index++)
+  {
+    //workers are still up and may be bumping these
+    JobsExecuted += __atomic_load_n(&Engine->Jobs->Threads[Index].ExecutedCount, __ATOMIC_RELAXED);
+    JobsStolen   += __atomic_load_n(&Engine->Jobs->Threads[Index].StolenCount, __ATOMIC_RELAXED);
+  }
+  printf("jobs: %u threads, %.2f jobs/frame, %.2f stolen/frame (warmup included)\n",
+         Engine->Jobs->ThreadCount, (f64)JobsExecuted/(WarmupCount+FrameCount),
+         (f64)JobsStolen/(WarmupCount+FrameCount));
+  //every run starts cold so this is a real time to first frame for the engine part
+  TerrainBuildWait(&Engine->Terrain);
+  printf("startup: first frame %.3fms, terrain built in %.3fms, ready at %.3fms, drawn at %.3fms\n",
+         (Engine->FirstFrameAtNs-Engine->CreatedAtNs)/1000000.0, Engine->Terrain.BuildNs/1000000.0,
+         (Engine->Terrain.ReadyAtNs-Engine->CreatedAtNs)/1000000.0,
+         (Engine->TerrainShownAtNs-Engine->CreatedAtNs)/1000000.0);
+  arena *Permanent = &Engine->Memory.Permanent;
+  u64 FrameHighWater  = 0;
+  u32 FailedPushCount = Permanent->FailedPushCount;
+  for(u32 Slot=0; Slot<PACKET_QUEUE_MAX_COUNT; Slot++)
+  {
+    FrameHighWater   = Max(FrameHighWater, Engine->Packets[Slot].Arena.HighWater);
+    FailedPushCount += Engine->Packets[Slot].Arena.FailedPushCount;
+  }
+  printf("memory: permanent %llu/%llu bytes (%lld during frames), frame high water %llu/%llu bytes, "
+         "%u failed pushes\n",
+         (unsigned long long)Permanent->Used, (unsigned long long)Permanent->Size,
+         (long long)(Permanent->Used-PermanentUsed),
+         (unsigned long long)FrameHighWater, (unsigned long long)ENGINE_FRAME_ARENA_SIZE,
+         FailedPushCount);
+  //with -renderthread submit is timed on the render thread and frame is the update side only
+  printf("frame packets: %u (%s), update waited %.3fms, render waited %.3fms\n",
+         Engine->PacketQueue.Count, IsRenderThread?"render thread":"inline", Engine->PacketQueue.ProducerWaitNs/1000000.0,
+         Engine->PacketQueue.ConsumerWaitNs/1000000.0);
+#if defined(GFX_BACKEND_RECORD)
+  BenchReportGfxRecord(DumpCmds);
+#endif
+  //the same teardown logs as the device, on stderr with -v
+  EngineLogMemory(Engine);
+  EngineLogTerrainHeights(Engine);
+  EngineLogLatency(Engine);
+  EngineTerm(Engine);
+  EngineDestroy(Engine);
+  for(u32 Phase=0; Phase<BenchPhase_Count; Phase++) { free(Samples[Phase]); }
+  free(EngineMemory);
+  free(VFile.Data);
+  free(FFile.Data);
+  free(VFile3d.Data);
+  free(FFile3d.Data);
+  return 0;
+}
@@ -1,10 +1,14 @@
 #include <jni.h>
 
 #include <assert.h>
+#include <dlfcn.h>
+#include <pthread.h>
+#include <stdlib.h>
 #include <string.h>
 #include <android/log.h>
 #include <android/asset_manager.h>
 #include <android_native_app_glue.h>
+#include <EGL/egl.h>
 
 #define LOG(...) ((void)__android_log_print(ANDROID_LOG_INFO, "NativeApp", __VA_ARGS__))
 #define Assert(condition, ...) \
@@ -13,114 +17,367 @@ if(!(condition)) \
 { ((void)__android_log_print(ANDROID_LOG_WARN, "NativeApp[ASSERT]!", __VA_ARGS__)); } \
 } while(0)
 
-#define ArrayCount(array) (sizeof(array)/sizeof(array[0]))
-#define SymbolToString(symbol) #symbol
-#define ThisFuncionAsString() __FUNCTION__
-#include "types.h"
-#include "mymath.h"
-#include "ui.h"
-
-//Global Input
-v2f GlobalRes      = {0};
-v2f GlobalTouchPos = {0};
-v2f GlobalTouchDelta = {0};
-b32 GlobalIsPressed = 0;
-b32 GlobalJustPressed = 0;
-b32 GlobalJustReleased = 0;
-f64 GlobalDeltaTime = 0;
-f64 GlobalTimeElapsed = 0;
-//Global Input
-#define ELMPUSH_BTN_ELM_ID (0)
-#define ELMPOP_BTN_ELM_ID (1)
-
-#include "widget.h"
-#include "draw.h"
-#include "gfx.h"
-#include "render.h"
-
-
-vertex QuadData[6] =
+#include "engine.h"
+
+// NOTE(MIGUEL): ANativeWindow_setFrameRate, not in the android-26 headers
+typedef int32_t android_set_frame_rate(ANativeWindow *Window, float FrameRate, int8_t Compatibility);
+#define ANDROID_FRAME_RATE_COMPATIBILITY_DEFAULT (0)
+
+// NOTE(MIGUEL): android platform layer. owns the native activity, egl and the input pump.
+//               everything engine related lives in engine.h so it can also be built for the host.
+//               the main thread pumps input and runs EngineUpdate, the egl context belongs to a
+//               render thread (while there is a window) that draws the frame packets and swaps.
+struct android_platform
 {
-  //tri:a//Pos            Color
-  {{-1.0f,  1.0f},    {1.f, 1.f, 0.f,} },
-  {{1.0f ,  1.0f},    {1.f, 0.f, 0.f,} },
-  {{1.0f , -1.0f},    {0.f, 1.f, 0.f,} },
-  //tri:b
-  {{-1.0f, -1.0f},    {0.f, 0.f, 1.f,} },
-  {{1.0f , -1.0f},    {0.f, 1.f, 0.f,} },
-  {{-1.0f,  1.0f},    {1.f, 1.f, 0.f,} },
+  struct android_app* App;
+
+  int Active;
+  EGLDisplay Display;
+  EGLSurface Surface;
+  EGLContext Context;
+  struct engine *Engine; //lives in the memory block allocated in android_main
+  pthread_t RenderThread;
+  b32 IsRenderThreadRunning;
 };
+static int AndroidInitDisplay(struct android_platform* Platform)
+{
+  const EGLint Attribs[] =
+  {
+    EGL_SURFACE_TYPE, EGL_WINDOW_BIT,
+    EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+    EGL_BLUE_SIZE, 8,
+    EGL_GREEN_SIZE, 8,
+    EGL_RED_SIZE, 8,
+    EGL_NONE,
+  };
 
-vertex3d QuadData3d[6] =
+  EGLDisplay Display;
+  if ((Display = eglGetDisplay(EGL_DEFAULT_DISPLAY)) == EGL_NO_DISPLAY)
+  {
+    LOG("error with eglGetDisplay");
+    return -1;
+  }
+
+  if (!eglInitialize(Display, 0, 0))
+  {
+    LOG("error with eglInitialize");
+    return -1;
+  }
+
+  EGLConfig Config;
+  EGLint NumConfigs;
+  if (!eglChooseConfig(Display, Attribs, &Config, 1, &NumConfigs))
+  {
+    LOG("error with eglChooseConfig");
+    return -1;
+  }
+
+  EGLint Format;
+  if (!eglGetConfigAttrib(Display, Config, EGL_NATIVE_VISUAL_ID, &Format))
+  {
+    LOG("error with eglGetConfigAttrib");
+    return -1;
+  }
+
+  ANativeWindow_setBuffersGeometry(Platform->App->window, 0, 0, Format);
+  //ask the display for the rate the pacer aims at. api 30+ only and we build against 26, so it
+  //is looked up at runtime and older devices just skip it
+  void *AndroidLib = dlopen("libandroid.so", RTLD_NOW);
+  if(AndroidLib)
+  {
+    android_set_frame_rate *SetFrameRate = (android_set_frame_rate *)dlsym(AndroidLib, "ANativeWindow_setFrameRate");
+    if(SetFrameRate)
+    {
+      SetFrameRate(Platform->App->window, (f32)ENGINE_TARGET_FPS,
+                   ANDROID_FRAME_RATE_COMPATIBILITY_DEFAULT);
+    }
+    dlclose(AndroidLib);
+  }
+
+  EGLSurface Surface;
+  if (!(Surface = eglCreateWindowSurface(Display, Config, Platform->App->window, NULL)))
+  {
+    LOG("error with eglCreateWindowSurface");
+    return -1;
+  }
+
+  const EGLint CtxAttrib[] = { EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE };
+  EGLContext Context;
+  if (!(Context = eglCreateContext(Display, Config, NULL, CtxAttrib)))
+  {
+    LOG("error with eglCreateContext");
+    return -1;
+  }
+
+  if (eglMakeCurrent(Display, Surface, Surface, Context) == EGL_FALSE)
+  {
+    LOG("error with eglMakeCurrent");
+    return -1;
+  }
+
+  LOG("GL_VENDOR = %s", glGetString(GL_VENDOR));
+  LOG("GL_RENDERER = %s", glGetString(GL_RENDERER));
+  LOG("GL_VERSION = %s", glGetString(GL_VERSION));
+
+  EGLint Width, Height;
+  eglQuerySurface(Display, Surface, EGL_WIDTH, &Width);
+  eglQuerySurface(Display, Surface, EGL_HEIGHT, &Height);
+
+  Platform->Display = Display;
+  Platform->Context = Context;
+  Platform->Surface = Surface;
+
+  AAssetManager *Assets = Platform->App->activity->assetManager;
+  AAsset* VAsset = AAssetManager_open(Assets, "vertex.glsl", AASSET_MODE_BUFFER);
+  AAsset* FAsset = AAssetManager_open(Assets, "fragment.glsl", AASSET_MODE_BUFFER);
+  AAsset* VAsset3d = AAssetManager_open(Assets, "vertex3d.glsl", AASSET_MODE_BUFFER);
+  AAsset* FAsset3d = AAssetManager_open(Assets, "fragment3d.glsl", AASSET_MODE_BUFFER);
+  if (!VAsset) { LOG("error opening vertex.glsl"); return -1; }
+  if (!FAsset) { LOG("error opening vertex.glsl"); return -1; }
+  if (!VAsset3d) { LOG("error opening vertex3d.glsl"); return -1; }
+  if (!FAsset3d) { LOG("error opening vertex3d.glsl"); return -1; }
+
+  engine_shader_src Shader = {
+    .Vert = AAsset_getBuffer(VAsset), .VertLength = AAsset_getLength(VAsset),
+    .Frag = AAsset_getBuffer(FAsset), .FragLength = AAsset_getLength(FAsset),
+  };
+  engine_shader_src Shader3d = {
+    .Vert = AAsset_getBuffer(VAsset3d), .VertLength = AAsset_getLength(VAsset3d),
+    .Frag = AAsset_getBuffer(FAsset3d), .FragLength = AAsset_getLength(FAsset3d),
+  };
+  int Result = EngineInit(Platform->Engine, Width, Height, Shader, Shader3d);
+  AAsset_close(VAsset);
+  AAsset_close(FAsset);
+  AAsset_close(VAsset3d);
+  AAsset_close(FAsset3d);
+  return Result;
+}
+static void *AndroidRenderThreadProc(void *Param)
 {
-  //tri:a       v(Pos)            v(uv)
-  {{-1.f, 0.f,  1.f,}, { 0.f,  1.f,} },
-  {{ 1.f, 0.f,  1.f,}, { 1.f,  1.f,} },
-  {{ 1.f, 0.f, -1.f,}, { 1.f,  0.f,} },
-  //tri:b
-  {{-1.f, 0.f, -1.f,}, { 0.f,  0.f,} },
-  {{ 1.f, 0.f, -1.f,}, { 1.f,  0.f,} },
-  {{-1.f, 0.f,  1.f,}, { 0.f,  1.f,} },
-};
-#include "engine.h"
-u64 GetTimeNanos(void)
+  struct android_platform* Platform = (struct android_platform*)Param;
+  if (eglMakeCurrent(Platform->Display, Platform->Surface, Platform->Surface, Platform->Context) == EGL_FALSE)
+  {
+    LOG("error with eglMakeCurrent on the render thread");
+    return NULL;
+  }
+  //blocks until the update publishes a packet, returns 0 once the queue is closed
+  while (EngineRender(Platform->Engine, 1))
+  {
+    eglSwapBuffers(Platform->Display, Platform->Surface);
+    EngineFramePresented(Platform->Engine, GetTimeNanos());
+  }
+  eglMakeCurrent(Platform->Display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+  return NULL;
+}
+// NOTE(MIGUEL): hands the context initialized on this thread over to the render thread
+static void AndroidRenderThreadStart(struct android_platform* Platform)
+{
+  if (Platform->Display == EGL_NO_DISPLAY || Platform->IsRenderThreadRunning) { return; }
+  eglMakeCurrent(Platform->Display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+  PacketQueueOpen(&Platform->Engine->PacketQueue);
+  if (pthread_create(&Platform->RenderThread, NULL, AndroidRenderThreadProc, Platform) != 0)
+  {
+    LOG("error creating the render thread");
+    eglMakeCurrent(Platform->Display, Platform->Surface, Platform->Surface, Platform->Context);
+    return;
+  }
+  Platform->IsRenderThreadRunning = 1;
+  //a new surface needs a frame even if nothing changed
+  FramePacerWake(&Platform->Engine->Pacer);
+  return;
+}
+// NOTE(MIGUEL): packets still queued are dropped, the context comes back to this thread
+static void AndroidRenderThreadStop(struct android_platform* Platform)
+{
+  if (!Platform->IsRenderThreadRunning) { return; }
+  PacketQueueClose(&Platform->Engine->PacketQueue);
+  pthread_join(Platform->RenderThread, NULL);
+  Platform->IsRenderThreadRunning = 0;
+  eglMakeCurrent(Platform->Display, Platform->Surface, Platform->Surface, Platform->Context);
+  return;
+}
+static void AndroidTermDisplay(struct android_platform* Platform)
+{
+  if (Platform->Display != EGL_NO_DISPLAY)
+  {
+    EngineLogMemory(Platform->Engine);
+    EngineLogTerrainHeights(Platform->Engine);
+    EngineLogLatency(Platform->Engine);
+    EngineTerm(Platform->Engine);
+
+    eglMakeCurrent(Platform->Display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (Platform->Context != EGL_NO_CONTEXT)
+    {
+      eglDestroyContext(Platform->Display, Platform->Context);
+    }
+    if (Platform->Surface != EGL_NO_SURFACE)
+    {
+      eglDestroySurface(Platform->Display, Platform->Surface);
+    }
+    eglTerminate(Platform->Display);
+  }
+  Platform->Active = 0;
+  Platform->Display = EGL_NO_DISPLAY;
+  Platform->Context = EGL_NO_CONTEXT;
+  Platform->Surface = EGL_NO_SURFACE;
+  return;
+}
+static v2f AndroidPointerPos(AInputEvent* Event, size_t PtrIndex, s32 History)
+{
+  //touch pos taking into account offset from stuff like nav bar
+  v2f Result = ((History < 0)?
+                V2f(AMotionEvent_getRawX(Event, PtrIndex), AMotionEvent_getRawY(Event, PtrIndex)):
+                V2f(AMotionEvent_getHistoricalRawX(Event, PtrIndex, History),
+                    AMotionEvent_getHistoricalRawY(Event, PtrIndex, History)));
+  Result.x += AMotionEvent_getXOffset(Event);
+  Result.y += AMotionEvent_getYOffset(Event);
+  return Result;
+}
+// NOTE(MIGUEL): turns motion events into engine input events. moves carry every pointer and the
+//               samples batched since the last event (historical), oldest first.
+static int32_t AndroidHandleInput(struct android_app* App, AInputEvent* Event)
 {
-  struct timespec now;
-  clock_gettime(CLOCK_MONOTONIC, &now);
-  return (u64) now.tv_sec*1000000000LL + now.tv_nsec;
+  struct android_platform* Platform = (struct android_platform*)App->userData;
+  if((AInputEvent_getSource(Event) == AINPUT_SOURCE_TOUCHSCREEN) &&
+     (AInputEvent_getType  (Event) == AINPUT_EVENT_TYPE_MOTION))
+  {
+    input_queue *Queue = &Platform->Engine->InputQueue;
+    FramePacerWake(&Platform->Engine->Pacer);
+    s32 Action   = AMotionEvent_getAction(Event);
+    size_t PtrIndex = ((Action & AMOTION_EVENT_ACTION_POINTER_INDEX_MASK) >>
+                       AMOTION_EVENT_ACTION_POINTER_INDEX_SHIFT);
+    s32 PtrId = AMotionEvent_getPointerId(Event, PtrIndex);
+    u64 Time  = (u64)AMotionEvent_getEventTime(Event);
+    switch(Action & AMOTION_EVENT_ACTION_MASK)
+    {
+      case AMOTION_EVENT_ACTION_DOWN:
+      case AMOTION_EVENT_ACTION_POINTER_DOWN:
+      {
+        InputQueuePushEvent(Queue, Time, InputEvent_Down, PtrId, AndroidPointerPos(Event, PtrIndex, -1));
+      } break;
+      case AMOTION_EVENT_ACTION_UP:
+      case AMOTION_EVENT_ACTION_POINTER_UP:
+      {
+        InputQueuePushEvent(Queue, Time, InputEvent_Up, PtrId, AndroidPointerPos(Event, PtrIndex, -1));
+      } break;
+      case AMOTION_EVENT_ACTION_MOVE:
+      {
+        size_t PtrCount     = AMotionEvent_getPointerCount(Event);
+        size_t HistoryCount = AMotionEvent_getHistorySize(Event);
+        for(size_t History=0; History<=HistoryCount; History++)
+        {
+          b32 IsCurrent = (History == HistoryCount);
+          u64 SampleTime = IsCurrent?Time:(u64)AMotionEvent_getHistoricalEventTime(Event, History);
+          for(size_t Ptr=0; Ptr<PtrCount; Ptr++)
+          {
+            InputQueuePushEvent(Queue, SampleTime, InputEvent_Move, AMotionEvent_getPointerId(Event, Ptr),
+                                AndroidPointerPos(Event, Ptr, IsCurrent?-1:(s32)History));
+          }
+        }
+      } break;
+      case AMOTION_EVENT_ACTION_CANCEL:
+      {
+        InputQueuePushEvent(Queue, Time, InputEvent_Cancel, PtrId, AndroidPointerPos(Event, PtrIndex, -1));
+      } break;
+      default:
+      {
+
+      } break;
+    }
+    return 1;
+  }
+  return 0;
 }
-f64 GetTimeSeconds(void)
+static void AndroidHandleCmd(struct android_app* App, int32_t Cmd)
 {
-  struct timespec now;
-  clock_gettime(CLOCK_MONOTONIC, &now);
-  return (f64)now.tv_sec + (f64)(now.tv_nsec/(f64)1000000000.0);
+  struct android_platform* Platform = (struct android_platform*)App->userData;
+  switch (Cmd)
+  {
+    case APP_CMD_INIT_WINDOW:
+    if (Platform->App->window != NULL)
+    {
+      if (AndroidInitDisplay(Platform) == 0)
+      {
+        AndroidRenderThreadStart(Platform);
+      }
+    }
+    break;
+    case APP_CMD_TERM_WINDOW:
+    AndroidRenderThreadStop(Platform);
+    AndroidTermDisplay(Platform);
+    break;
+    case APP_CMD_GAINED_FOCUS:
+    Platform->Active = 1;
+    FramePacerWake(&Platform->Engine->Pacer);
+    break;
+    case APP_CMD_LOST_FOCUS:
+    //the last packet drawn stays on screen
+    Platform->Active = 0;
+    break;
+  }
 }
 void android_main(struct android_app* State)
 {
-  struct engine Engine;
-  MemorySet(0, &Engine, sizeof(Engine));
-  
-  State->userData     = &Engine;
-  State->onAppCmd     = EngineHandleCmd;
-  State->onInputEvent = EngineHandleInput;
-  Engine.App = State;
-  
-  f64 LastTime = GetTimeSeconds();
+  struct android_platform Platform;
+  MemorySet(0, &Platform, sizeof(Platform));
+
+  State->userData     = &Platform;
+  State->onAppCmd     = AndroidHandleCmd;
+  State->onInputEvent = AndroidHandleInput;
+  Platform.App = State;
+  // NOTE(MIGUEL): all engine memory is one heap block, nothing big sits on this thread's stack
+  void *EngineMemory = malloc(ENGINE_MEMORY_SIZE);
+  Platform.Engine = EngineMemory?EngineCreate(EngineMemory, ENGINE_MEMORY_SIZE, ENGINE_UI_ELEMENT_CAPACITY,
+                                              ENGINE_JOB_THREADS):NULL;
+  if(!Platform.Engine)
+  {
+    LOG("error creating the engine");
+    return;
+  }
+
+  // NOTE(MIGUEL): the event poll doubles as the frame pacer's sleep. while a frame is planned it
+  //               only blocks until that frame's start, idle or in the background it blocks until
+  //               an event comes in.
+  frame_pacer *Pacer = &Platform.Engine->Pacer;
+  u64 WakeNs = 0; //start of the planned frame, 0 when none is planned
   u32 isRunning = 1;
   while(isRunning)
   {
-    int Ident;
     int Events;
     struct android_poll_source* Source;
-    GlobalJustPressed = 0; // NOTE(MIGUEL): sketchy impl
-    while ((Ident=ALooper_pollAll(Engine.Active ? 0 : -1, NULL, &Events, (void**)&Source)) >= 0)
+    for(;;)
     {
+      b32 IsPacing = Platform.Active && Platform.IsRenderThreadRunning && !Pacer->IsIdle;
+      if (IsPacing && !WakeNs) { WakeNs = FramePacerPlan(Pacer, GetTimeNanos()); }
+      if (!IsPacing) { WakeNs = 0; }
+      int Timeout = IsPacing?FramePacerPollTimeout(WakeNs, GetTimeNanos()):-1;
+      if (ALooper_pollAll(Timeout, NULL, &Events, (void**)&Source) < 0) { break; }
       if (Source != NULL)
       {
         Source->process(State, Source);
       }
       if (State->destroyRequested != 0)
       {
-        EngineTermDisplay(&Engine);
+        AndroidRenderThreadStop(&Platform);
+        AndroidTermDisplay(&Platform);
+        //the activity can come back in this same process, nothing may keep running
+        EngineDestroy(Platform.Engine);
+        free(EngineMemory);
         return;
       }
     }
-    if (Engine.Active)
+    if (WakeNs)
     {
-      GlobalRes.x = Engine.Width;
-      GlobalRes.y = Engine.Height;
-      EngineUpdate(&Engine);
-      EngineDrawFrame(&Engine);
+      FramePacerSleepUntil(Pacer, WakeNs);
+      FramePacerFrameBegin(Pacer);
+      WakeNs = 0;
+      GlobalRes.x = Platform.Engine->Width;
+      GlobalRes.y = Platform.Engine->Height;
+      GlobalDeltaTime    = Pacer->DeltaSeconds;
+      GlobalTimeElapsed += GlobalDeltaTime;
+      //blocks while the render thread still has every packet
+      EngineUpdate(Platform.Engine);
+      FramePacerFrameEnd(Pacer, EngineIsAnimating(Platform.Engine));
     }
-    f64 CurrentTime = GetTimeSeconds();
-    GlobalDeltaTime    = CurrentTime-LastTime;
-    GlobalTimeElapsed += GlobalDeltaTime;
-    LastTime = CurrentTime;
-    /*
-    LOG("delta t: %f \n"
-        "elapsed: %f \n",
-        GlobalDeltaTime,
-          GlobalTimeElapsed);
-    */
   }
 }
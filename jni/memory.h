@@ -0,0 +1,85 @@
+#ifndef MEMORY_H
+#define MEMORY_H
+
+// NOTE(MIGUEL): linear arena over a block the platform hands in. pushes bump Used, memory
+//               comes back by popping from the top, ending a temp scope or resetting the
+//               whole thing at once.
+#define ARENA_DEFAULT_ALIGNMENT (16)
+typedef struct arena arena;
+struct arena
+{
+  u8  *Base;
+  u64  Size;
+  u64  Used;
+  u64  HighWater; //most Used has ever been
+  u32  FailedPushCount; //pushes that did not fit
+};
+typedef struct arena_temp arena_temp;
+struct arena_temp
+{
+  arena *Arena;
+  u64    Used;
+};
+void ArenaInit(arena *Arena, void *Base, u64 Size)
+{
+  Arena->Base = Base;
+  Arena->Size = Size;
+  Arena->Used = 0;
+  Arena->HighWater = 0;
+  Arena->FailedPushCount = 0;
+  return;
+}
+// NOTE(MIGUEL): returns NULL when the arena is out of room. Alignment has to be a power of 2.
+void *ArenaPushAligned(arena *Arena, u64 Size, u64 Alignment)
+{
+  u64 Start = (Arena->Used + Alignment-1) & ~(Alignment-1);
+  if(Start+Size > Arena->Size)
+  {
+    Arena->FailedPushCount++;
+    return NULL;
+  }
+  Arena->Used = Start+Size;
+  Arena->HighWater = Max(Arena->HighWater, Arena->Used);
+  return Arena->Base+Start;
+}
+void *ArenaPush(arena *Arena, u64 Size)
+{
+  return ArenaPushAligned(Arena, Size, ARENA_DEFAULT_ALIGNMENT);
+}
+#define ArenaPushArray(Arena, Type, Count) ((Type *)ArenaPush((Arena), sizeof(Type)*(Count)))
+#define ArenaPushStruct(Arena, Type) ArenaPushArray(Arena, Type, 1)
+// NOTE(MIGUEL): gives back the last Size bytes. alignment padding in front of a push is not
+//               tracked, so popping exactly what was pushed can leave a few bytes behind.
+void ArenaPop(arena *Arena, u64 Size)
+{
+  Arena->Used = (Size<Arena->Used)?(Arena->Used-Size):0;
+  return;
+}
+void ArenaReset(arena *Arena)
+{
+  Arena->Used = 0;
+  return;
+}
+// NOTE(MIGUEL): an arena over the next Size bytes of Arena, for scratch that gets handed to a
+//               job so the parent is never pushed to from two threads. empty if it doesnt fit.
+arena ArenaSub(arena *Arena, u64 Size)
+{
+  arena Result;
+  void *Base = ArenaPush(Arena, Size);
+  ArenaInit(&Result, Base, Base?Size:0);
+  return Result;
+}
+// NOTE(MIGUEL): everything pushed inside a temp scope is released by ArenaTempEnd. scopes
+//               nest but have to end in reverse order.
+arena_temp ArenaTempBegin(arena *Arena)
+{
+  arena_temp Result = { Arena, Arena->Used };
+  return Result;
+}
+void ArenaTempEnd(arena_temp Temp)
+{
+  Temp.Arena->Used = Temp.Used;
+  return;
+}
+
+#endif //MEMORY_H
@@ -0,0 +1,202 @@
+#ifndef MESH_H
+#define MESH_H
+
+// NOTE(MIGUEL): Grid mesh generator. (QuadsPerSide+1)^2 unique vertices and a 16 bit index
+//               list per topology, both index lists live back to back in one allocation so
+//               they can share an index buffer.
+//               With a skirt every border vertex gets a copy with Pos.y = -1 after the grid
+//               vertices, the vertex shader pulls those down to hide cracks between lods.
+#define GRID_MESH_MAX_QUADS_PER_SIDE (250) //keeps the vertex count (with skirt) under 16 bit indices
+typedef enum mesh_topology mesh_topology;
+enum mesh_topology
+{
+  MeshTopology_Triangles,
+  MeshTopology_Lines, //wireframe: every quad edge and its diagonal once
+  MeshTopology_Count,
+};
+typedef struct grid_mesh grid_mesh;
+struct grid_mesh
+{
+  u32 QuadsPerSide;
+  b32 HasSkirt;
+  vertex3d *Verts;
+  u32 VertexCount;
+  u16 *Indices;
+  u32 IndexCount;
+  u32 IndexOffset[MeshTopology_Count]; //in indices from the start of Indices
+  u32 IndexCountOf[MeshTopology_Count];
+};
+u32 GridMeshTriangleIndexCount(u32 QuadsPerSide, b32 HasSkirt)
+{
+  u32 QuadCount = QuadsPerSide*QuadsPerSide + (HasSkirt?4*QuadsPerSide:0);
+  return QuadCount*6;
+}
+u32 GridMeshLineIndexCount(u32 QuadsPerSide, b32 HasSkirt)
+{
+  u32 EdgeCount = (2*QuadsPerSide*(QuadsPerSide+1)) + (QuadsPerSide*QuadsPerSide);
+  //skirt: a drop edge per border vertex and the bottom edges
+  if(HasSkirt) { EdgeCount += 4*(QuadsPerSide+1) + 4*QuadsPerSide; }
+  return EdgeCount*2;
+}
+// NOTE(MIGUEL): border vertices walked around the grid as 4 sides of Side vertices each,
+//               corners show up on two sides. Side order: z=0, x=max, z=max, x=0.
+u16 GridMeshBorderIndex(u32 Side, u32 Edge, u32 i)
+{
+  u32 Last = Side-1;
+  u32 Result = 0;
+  switch(Edge)
+  {
+    case 0: { Result = i; } break;
+    case 1: { Result = i*Side+Last; } break;
+    case 2: { Result = Last*Side+(Last-i); } break;
+    case 3: { Result = (Last-i)*Side; } break;
+  }
+  return (u16)Result;
+}
+// NOTE(MIGUEL): only sizes and allocates, GridMeshFill does the work. Split so the storage can
+//               come from an arena on the main thread while the fill runs anywhere.
+b32 GridMeshAlloc(grid_mesh *Mesh, arena *Arena, u32 QuadsPerSide, b32 HasSkirt)
+{
+  if(QuadsPerSide == 0 || QuadsPerSide > GRID_MESH_MAX_QUADS_PER_SIDE) return 0;
+  u32 Side = QuadsPerSide+1;
+  Mesh->QuadsPerSide = QuadsPerSide;
+  Mesh->HasSkirt     = HasSkirt;
+  Mesh->VertexCount  = Side*Side + (HasSkirt?4*Side:0);
+  Mesh->IndexOffset [MeshTopology_Triangles] = 0;
+  Mesh->IndexCountOf[MeshTopology_Triangles] = GridMeshTriangleIndexCount(QuadsPerSide, HasSkirt);
+  Mesh->IndexOffset [MeshTopology_Lines] = Mesh->IndexCountOf[MeshTopology_Triangles];
+  Mesh->IndexCountOf[MeshTopology_Lines] = GridMeshLineIndexCount(QuadsPerSide, HasSkirt);
+  Mesh->IndexCount = (Mesh->IndexCountOf[MeshTopology_Triangles]+
+                      Mesh->IndexCountOf[MeshTopology_Lines]);
+  Mesh->Verts   = ArenaPushArray(Arena, vertex3d, Mesh->VertexCount);
+  Mesh->Indices = ArenaPushArray(Arena, u16, Mesh->IndexCount);
+  return (Mesh->Verts && Mesh->Indices);
+}
+// NOTE(MIGUEL): centered on the origin in xz, QuadSize apart. Uv is the position plus the
+//               vertex's 0..1 coordinate across the grid. No allocation, logging or libm in
+//               here and every grid loop is a straight run with no branches so the compiler
+//               can vectorize it, safe to call off the main thread.
+void GridMeshFill(grid_mesh *Mesh, f32 QuadSize)
+{
+  u32 QuadsPerSide = Mesh->QuadsPerSide;
+  u32 Side = QuadsPerSide+1;
+  f32 HalfExtent = QuadsPerSide*QuadSize*0.5f;
+  f32 UvStep     = 1.0f/(f32)QuadsPerSide;
+  vertex3d *Row = Mesh->Verts;
+  for(u32 z=0; z<Side; z++)
+  {
+    f32 PosZ = z*QuadSize-HalfExtent;
+    f32 UvY  = z*UvStep+PosZ;
+    for(u32 x=0; x<Side; x++)
+    {
+      f32 PosX = x*QuadSize-HalfExtent;
+      Row[x].Pos.x = PosX;
+      Row[x].Pos.y = 0.0f;
+      Row[x].Pos.z = PosZ;
+      Row[x].Uv.x  = x*UvStep+PosX;
+      Row[x].Uv.y  = UvY;
+    }
+    Row += Side;
+  }
+  u32 SkirtStart = Side*Side;
+  if(Mesh->HasSkirt)
+  {
+    vertex3d *Skirt = Mesh->Verts+SkirtStart;
+    for(u32 Edge=0; Edge<4; Edge++)
+    {
+      for(u32 i=0; i<Side; i++)
+      {
+        *Skirt = Mesh->Verts[GridMeshBorderIndex(Side, Edge, i)];
+        Skirt->Pos.y = -1.0f;
+        Skirt++;
+      }
+    }
+  }
+  //triangles: same winding as QuadData3d
+  u16 *Index = Mesh->Indices+Mesh->IndexOffset[MeshTopology_Triangles];
+  for(u32 z=0; z<QuadsPerSide; z++)
+  {
+    u32 RowStart = z*Side;
+    for(u32 x=0; x<QuadsPerSide; x++)
+    {
+      u16 i00 = (u16)(RowStart+x);
+      u16 i10 = (u16)(i00+1);
+      u16 i01 = (u16)(i00+Side);
+      u16 i11 = (u16)(i01+1);
+      Index[0] = i01; Index[1] = i11; Index[2] = i10;
+      Index[3] = i00; Index[4] = i10; Index[5] = i01;
+      Index += 6;
+    }
+  }
+  if(Mesh->HasSkirt)
+  {
+    for(u32 Edge=0; Edge<4; Edge++)
+    {
+      for(u32 i=0; i<QuadsPerSide; i++)
+      {
+        u16 Top0 = GridMeshBorderIndex(Side, Edge, i);
+        u16 Top1 = GridMeshBorderIndex(Side, Edge, i+1);
+        u16 Bot0 = (u16)(SkirtStart+Edge*Side+i);
+        u16 Bot1 = (u16)(Bot0+1);
+        Index[0] = Top0; Index[1] = Bot0; Index[2] = Top1;
+        Index[3] = Top1; Index[4] = Bot0; Index[5] = Bot1;
+        Index += 6;
+      }
+    }
+  }
+  //lines: one pass per edge direction, so no per vertex edge checks
+  Index = Mesh->Indices+Mesh->IndexOffset[MeshTopology_Lines];
+  for(u32 z=0; z<Side; z++)
+  {
+    for(u32 x=0; x<QuadsPerSide; x++)
+    {
+      u16 i00 = (u16)(z*Side+x);
+      Index[0] = i00; Index[1] = (u16)(i00+1);
+      Index += 2;
+    }
+  }
+  for(u32 z=0; z<QuadsPerSide; z++)
+  {
+    for(u32 x=0; x<Side; x++)
+    {
+      u16 i00 = (u16)(z*Side+x);
+      Index[0] = i00; Index[1] = (u16)(i00+Side);
+      Index += 2;
+    }
+  }
+  for(u32 z=0; z<QuadsPerSide; z++)
+  {
+    for(u32 x=0; x<QuadsPerSide; x++)
+    {
+      u16 i00 = (u16)(z*Side+x);
+      Index[0] = (u16)(i00+1); Index[1] = (u16)(i00+Side);
+      Index += 2;
+    }
+  }
+  if(Mesh->HasSkirt)
+  {
+    for(u32 Edge=0; Edge<4; Edge++)
+    {
+      u16 EdgeStart = (u16)(SkirtStart+Edge*Side);
+      for(u32 i=0; i<Side; i++)
+      {
+        Index[0] = GridMeshBorderIndex(Side, Edge, i); Index[1] = (u16)(EdgeStart+i);
+        Index += 2;
+      }
+      for(u32 i=0; i<QuadsPerSide; i++)
+      {
+        Index[0] = (u16)(EdgeStart+i); Index[1] = (u16)(EdgeStart+i+1);
+        Index += 2;
+      }
+    }
+  }
+  return;
+}
+b32 GridMeshBuild(grid_mesh *Mesh, arena *Arena, u32 QuadsPerSide, f32 QuadSize, b32 HasSkirt)
+{
+  if(!GridMeshAlloc(Mesh, Arena, QuadsPerSide, HasSkirt)) return 0;
+  GridMeshFill(Mesh, QuadSize);
+  return 1;
+}
+
+#endif //MESH_H
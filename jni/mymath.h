@@ -7,7 +7,7 @@
 void MemorySet(u32 Value, void *Src, size_t Size)
 {
   u8 *Memory = Src;
-  while(Size--) *Memory = Value;
+  while(Size--) *Memory++ = Value;
   return;
 }
 
@@ -73,11 +73,21 @@ v2f V2fScale(v2f a, f32 Scalar)
   Result.y = a.y*Scalar;
   return Result;
 }
+v2f V2fAdd(v2f a, v2f b)
+{
+  v2f Result = { a.x+b.x, a.y+b.y };
+  return Result;
+}
 v4f V4f(f32 x, f32 y, f32 z, f32 w)
 {
   v4f Result = { x,y,z,w };
   return Result;
 }
+v4f V4fHadamard(v4f a, v4f b)
+{
+  v4f Result = { a.x*b.x, a.y*b.y, a.z*b.z, a.w*b.w };
+  return Result;
+}
 //~ 2x2 MATRIX FUNCTIONS
 m2f M2fScale(f32 x, f32 y)
 {
@@ -237,4 +247,19 @@ r2f R2f(f32 minx, f32 miny, f32 maxx, f32 maxy)
   r2f Result = {minx, miny, maxx, maxy};
   return Result;
 }
+r2f R2fOffset(r2f Rect, v2f Offset)
+{
+  r2f Result = {Rect.min.x+Offset.x, Rect.min.y+Offset.y, Rect.max.x+Offset.x, Rect.max.y+Offset.y};
+  return Result;
+}
+//inside out (min past max) when they don't overlap
+r2f R2fIntersect(r2f a, r2f b)
+{
+  r2f Result = {Max(a.min.x, b.min.x), Max(a.min.y, b.min.y), Min(a.max.x, b.max.x), Min(a.max.y, b.max.y)};
+  return Result;
+}
+b32 R2fIsEmpty(r2f Rect)
+{
+  return (Rect.min.x > Rect.max.x || Rect.min.y > Rect.max.y);
+}
 #endif //MATH_H
@@ -0,0 +1,121 @@
+#ifndef PACING_H
+#define PACING_H
+#include <sched.h>
+#include <time.h>
+
+// NOTE(MIGUEL): Frame pacing. Frames are aimed at deadlines PeriodNs apart (the target refresh
+//               rate) and an update starts PredictedNs before its deadline, PredictedNs being a
+//               moving average of how long update begin to swap return has been taking. A frame
+//               that can't make its deadline anymore moves to the next one instead of arriving
+//               late, and the frame's delta time is the distance between deadlines so it comes in
+//               whole periods instead of whatever the loop happened to measure.
+//               After IdleAfterFrames frames in a row with nothing going on the pacer goes idle:
+//               the platform stops planning frames and sleeps until something wakes it.
+#define FRAME_PACER_SPIN_NS (500000ULL)  //the last bit before a wake is yielded, not slept
+#define FRAME_PACER_AVERAGE_SHIFT (3)    //moving average weight 1/8
+typedef struct frame_pacer frame_pacer;
+struct frame_pacer
+{
+  u64 PeriodNs;
+  u64 PredictedNs;  //update begin to swap return, written by the render side
+  u64 Deadline;     //of the frame planned or running
+  u64 LastDeadline; //0 when there is no frame to pace against (start, idle)
+  f64 DeltaSeconds; //of the frame running
+  u32 IdleAfterFrames; //0 never idles
+  u32 QuietFrames;
+  b32 IsIdle;
+  //stats
+  u64 FrameCount;
+  u64 MissedCount; //deadlines skipped because the frame couldn't make them
+  u64 IdleCount;   //times it went idle
+  u64 WakeErrorNs; //summed lateness of the wakes
+};
+void FramePacerSetRate(frame_pacer *Pacer, u32 Hz)
+{
+  Pacer->PeriodNs = 1000000000ULL/Max(Hz, 1);
+  Pacer->LastDeadline = 0;
+  return;
+}
+void FramePacerInit(frame_pacer *Pacer, u32 Hz, u32 IdleAfterFrames)
+{
+  MemorySet(0, Pacer, sizeof(frame_pacer));
+  FramePacerSetRate(Pacer, Hz);
+  Pacer->PredictedNs     = Pacer->PeriodNs;
+  Pacer->IdleAfterFrames = IdleAfterFrames;
+  return;
+}
+// NOTE(MIGUEL): picks the next frame's deadline and returns when its update should start
+u64 FramePacerPlan(frame_pacer *Pacer, u64 Now)
+{
+  u64 Predicted = __atomic_load_n(&Pacer->PredictedNs, __ATOMIC_RELAXED);
+  if(Pacer->LastDeadline == 0)
+  {
+    Pacer->Deadline = Now+Predicted;
+  }
+  else
+  {
+    Pacer->Deadline = Pacer->LastDeadline+Pacer->PeriodNs;
+    while(Pacer->Deadline < Now+Predicted)
+    {
+      Pacer->Deadline += Pacer->PeriodNs;
+      Pacer->MissedCount++;
+    }
+  }
+  return Pacer->Deadline-Predicted;
+}
+// NOTE(MIGUEL): ms the platform can block in its event poll before it has to go precise
+s32 FramePacerPollTimeout(u64 WakeNs, u64 Now)
+{
+  if(WakeNs <= Now+FRAME_PACER_SPIN_NS) return 0;
+  return (s32)((WakeNs-Now-FRAME_PACER_SPIN_NS)/1000000ULL);
+}
+void FramePacerSleepUntil(frame_pacer *Pacer, u64 WakeNs)
+{
+  u64 Now = GetTimeNanos();
+  if(WakeNs > Now+FRAME_PACER_SPIN_NS)
+  {
+    u64 SleepUntil = WakeNs-FRAME_PACER_SPIN_NS;
+    struct timespec Time = { (time_t)(SleepUntil/1000000000ULL), (long)(SleepUntil%1000000000ULL) };
+    while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &Time, NULL) != 0) {}
+  }
+  while((Now = GetTimeNanos()) < WakeNs) { sched_yield(); }
+  Pacer->WakeErrorNs += Now-WakeNs;
+  return;
+}
+// NOTE(MIGUEL): the planned frame is starting now, sets its delta
+void FramePacerFrameBegin(frame_pacer *Pacer)
+{
+  u64 Elapsed = Pacer->LastDeadline?(Pacer->Deadline-Pacer->LastDeadline):Pacer->PeriodNs;
+  Pacer->DeltaSeconds = (f64)Elapsed/1000000000.0;
+  Pacer->LastDeadline = Pacer->Deadline;
+  Pacer->FrameCount++;
+  return;
+}
+// NOTE(MIGUEL): IsActive is whether the frame had input or animation, enough quiet ones idle
+void FramePacerFrameEnd(frame_pacer *Pacer, b32 IsActive)
+{
+  Pacer->QuietFrames = IsActive?0:(Pacer->QuietFrames+1);
+  if(Pacer->IdleAfterFrames && Pacer->QuietFrames >= Pacer->IdleAfterFrames && !Pacer->IsIdle)
+  {
+    Pacer->IsIdle       = 1;
+    Pacer->LastDeadline = 0;
+    Pacer->IdleCount++;
+  }
+  return;
+}
+void FramePacerWake(frame_pacer *Pacer)
+{
+  Pacer->IsIdle      = 0;
+  Pacer->QuietFrames = 0;
+  return;
+}
+//render side, once a frame's swap returned
+void FramePacerPresented(frame_pacer *Pacer, u64 FrameNs)
+{
+  u64 Predicted = __atomic_load_n(&Pacer->PredictedNs, __ATOMIC_RELAXED);
+  Predicted = Predicted-(Predicted>>FRAME_PACER_AVERAGE_SHIFT)+(FrameNs>>FRAME_PACER_AVERAGE_SHIFT);
+  __atomic_store_n(&Pacer->PredictedNs, Predicted, __ATOMIC_RELAXED);
+  return;
+}
+
+#endif //PACING_H
@@ -0,0 +1,144 @@
+#ifndef PACKET_H
+#define PACKET_H
+#include <pthread.h>
+#include <sched.h>
+
+// NOTE(MIGUEL): Frame packet handoff between the thread that updates (producer) and the one that
+//               owns the gl context (consumer). Count slots used in order as a ring. The producer
+//               owns slot Produced%Count until it publishes it, the consumer owns slot
+//               Consumed%Count until it releases it, so at most Count-1 packets wait while one
+//               is drawn. Count 2 is double buffering, 3 triple.
+//               The handoff itself is just the two counters (seq_cst, they pair with the
+//               sleeper count). Each side spins a little when it has to wait and then sleeps on
+//               the condition variable, the other side only takes the lock when someone
+//               announced they are sleeping.
+#define PACKET_QUEUE_MAX_COUNT (3)
+#define PACKET_QUEUE_SPIN_COUNT (64)
+typedef struct packet_queue packet_queue;
+struct packet_queue
+{
+  u64 Produced; //packets published, written by the producer
+  u8  ProducedPad[64-sizeof(u64)];
+  u64 Consumed; //packets released, written by the consumer
+  u8  ConsumedPad[64-sizeof(u64)];
+  u32 Count;
+  b32 IsClosed;
+  s32 SleepingCount;
+  pthread_mutex_t Lock;
+  pthread_cond_t  Wake;
+  //time each side spent waiting on the other, ns
+  u64 ProducerWaitNs;
+  u64 ConsumerWaitNs;
+};
+void PacketQueueInit(packet_queue *Queue, u32 Count)
+{
+  MemorySet(0, Queue, sizeof(packet_queue));
+  Queue->Count = Min(Max(Count, 1), PACKET_QUEUE_MAX_COUNT);
+  pthread_mutex_init(&Queue->Lock, NULL);
+  pthread_cond_init(&Queue->Wake, NULL);
+  return;
+}
+void PacketQueueTerm(packet_queue *Queue)
+{
+  pthread_mutex_destroy(&Queue->Lock);
+  pthread_cond_destroy(&Queue->Wake);
+  return;
+}
+void PacketQueueWakeAll(packet_queue *Queue)
+{
+  if(__atomic_load_n(&Queue->SleepingCount, __ATOMIC_SEQ_CST) > 0)
+  {
+    pthread_mutex_lock(&Queue->Lock);
+    pthread_cond_broadcast(&Queue->Wake);
+    pthread_mutex_unlock(&Queue->Lock);
+  }
+  return;
+}
+// NOTE(MIGUEL): waits until Ready or the queue closes, same announce-then-check order as the
+//               job system's workers so a wake can't slip between the check and the sleep
+b32 PacketQueueWait(packet_queue *Queue, b32 (*Ready)(packet_queue *), u64 *WaitNs)
+{
+  if(Ready(Queue)) return 1;
+  u64 Begin = GetTimeNanos();
+  for(u32 Spin=0; Spin<PACKET_QUEUE_SPIN_COUNT && !Ready(Queue); Spin++) { sched_yield(); }
+  pthread_mutex_lock(&Queue->Lock);
+  __atomic_add_fetch(&Queue->SleepingCount, 1, __ATOMIC_SEQ_CST);
+  while(!Ready(Queue) && !__atomic_load_n(&Queue->IsClosed, __ATOMIC_ACQUIRE))
+  {
+    pthread_cond_wait(&Queue->Wake, &Queue->Lock);
+  }
+  __atomic_sub_fetch(&Queue->SleepingCount, 1, __ATOMIC_SEQ_CST);
+  pthread_mutex_unlock(&Queue->Lock);
+  *WaitNs += GetTimeNanos()-Begin;
+  return Ready(Queue);
+}
+b32 PacketQueueHasFree(packet_queue *Queue)
+{
+  u64 Consumed = __atomic_load_n(&Queue->Consumed, __ATOMIC_SEQ_CST);
+  return (Queue->Produced-Consumed) < Queue->Count;
+}
+b32 PacketQueueHasPublished(packet_queue *Queue)
+{
+  u64 Produced = __atomic_load_n(&Queue->Produced, __ATOMIC_SEQ_CST);
+  return Produced > Queue->Consumed;
+}
+b32 PacketQueueIsIdle(packet_queue *Queue)
+{
+  u64 Consumed = __atomic_load_n(&Queue->Consumed, __ATOMIC_SEQ_CST);
+  return Consumed == Queue->Produced;
+}
+//- producer
+// NOTE(MIGUEL): slot to fill next, blocks while every packet is still in flight. 0 once closed.
+b32 PacketQueueBeginWrite(packet_queue *Queue, u32 *Slot)
+{
+  if(!PacketQueueWait(Queue, PacketQueueHasFree, &Queue->ProducerWaitNs)) return 0;
+  *Slot = (u32)(Queue->Produced%Queue->Count);
+  return 1;
+}
+void PacketQueueEndWrite(packet_queue *Queue)
+{
+  __atomic_store_n(&Queue->Produced, Queue->Produced+1, __ATOMIC_SEQ_CST);
+  PacketQueueWakeAll(Queue);
+  return;
+}
+//blocks until the consumer has released everything published
+void PacketQueueWaitIdle(packet_queue *Queue)
+{
+  PacketQueueWait(Queue, PacketQueueIsIdle, &Queue->ProducerWaitNs);
+  return;
+}
+//- consumer
+// NOTE(MIGUEL): oldest published slot. with Wait 0 it returns straight away when there is none,
+//               with Wait 1 it only returns 0 once the queue is closed.
+b32 PacketQueueBeginRead(packet_queue *Queue, b32 Wait, u32 *Slot)
+{
+  b32 Result = Wait?PacketQueueWait(Queue, PacketQueueHasPublished, &Queue->ConsumerWaitNs):
+                    PacketQueueHasPublished(Queue);
+  if(Result) { *Slot = (u32)(Queue->Consumed%Queue->Count); }
+  return Result;
+}
+void PacketQueueEndRead(packet_queue *Queue)
+{
+  __atomic_store_n(&Queue->Consumed, Queue->Consumed+1, __ATOMIC_SEQ_CST);
+  PacketQueueWakeAll(Queue);
+  return;
+}
+//- lifetime, neither side may be inside a Begin/End pair
+// NOTE(MIGUEL): wakes whoever is waiting and makes every wait fail until PacketQueueOpen
+void PacketQueueClose(packet_queue *Queue)
+{
+  __atomic_store_n(&Queue->IsClosed, 1, __ATOMIC_RELEASE);
+  pthread_mutex_lock(&Queue->Lock);
+  pthread_cond_broadcast(&Queue->Wake);
+  pthread_mutex_unlock(&Queue->Lock);
+  return;
+}
+//drops anything still published, a new consumer starts from an empty queue
+void PacketQueueOpen(packet_queue *Queue)
+{
+  __atomic_store_n(&Queue->Consumed, Queue->Produced, __ATOMIC_RELEASE);
+  __atomic_store_n(&Queue->IsClosed, 0, __ATOMIC_RELEASE);
+  return;
+}
+
+#endif //PACKET_H
@@ -1,4 +1,156 @@
 #ifndef RENDER_H
 #define RENDER_H
 
+// NOTE(MIGUEL): Render command queue. Buckets get turned into commands with a 64 bit sort
+//               key, the queue is radix sorted once per frame and gfx.h submits it in a single
+//               loop that only touches state when the key says it changed.
+//
+//               key bits: | layer 8 | program 12 | layout 12 | texture 12 | depth 20 |
+//               lower depth draws first. the sort is stable so equal keys keep push order.
+#define RENDER_KEY_DEPTH_BITS   (20)
+#define RENDER_KEY_TEXTURE_BITS (12)
+#define RENDER_KEY_LAYOUT_BITS  (12)
+#define RENDER_KEY_PROGRAM_BITS (12)
+#define RENDER_KEY_LAYER_BITS   (8)
+#define RENDER_KEY_DEPTH_SHIFT   (0)
+#define RENDER_KEY_TEXTURE_SHIFT (RENDER_KEY_DEPTH_SHIFT  +RENDER_KEY_DEPTH_BITS)
+#define RENDER_KEY_LAYOUT_SHIFT  (RENDER_KEY_TEXTURE_SHIFT+RENDER_KEY_TEXTURE_BITS)
+#define RENDER_KEY_PROGRAM_SHIFT (RENDER_KEY_LAYOUT_SHIFT +RENDER_KEY_LAYOUT_BITS)
+#define RENDER_KEY_LAYER_SHIFT   (RENDER_KEY_PROGRAM_SHIFT+RENDER_KEY_PROGRAM_BITS)
+#define RENDER_KEY_STATE_MASK    (~((1ULL<<RENDER_KEY_TEXTURE_SHIFT)-1)) //everything but depth
+#define RENDER_QUEUE_MAX_COUNT (4096)
+typedef enum render_layer render_layer;
+enum render_layer
+{
+  RenderLayer_UI,
+  RenderLayer_World, //the terrain draws into a ui panel, so it goes over the ui
+  RenderLayer_Count,
+};
+typedef enum render_cmd_kind render_cmd_kind;
+enum render_cmd_kind
+{
+  RenderCmd_Quads, //instanced quads of one draw batch
+  RenderCmd_Mesh,  //a range of the ctx's index buffer
+};
+typedef struct gfx_ctx gfx_ctx;
+typedef struct render_cmd render_cmd;
+struct render_cmd
+{
+  u64 Key;
+  render_cmd_kind Kind;
+  gfx_ctx *Ctx;
+  draw_bucket *Bucket; //transforms
+  draw_batch *Batch;   //RenderCmd_Quads
+  u32 Mode;            //RenderCmd_Mesh: gl primitive
+  u32 IndexOffset;     //RenderCmd_Mesh: in indices
+  u32 IndexCount;      //RenderCmd_Mesh
+  v4f MeshParams;      //RenderCmd_Mesh: per draw uniform (UChunk)
+  u32 StreamOffset;    //RenderCmd_Mesh: per vertex heights in the stream ring
+  v4f HeightmapParams; //RenderCmd_Mesh: UHeightmapChunk, when the ctx samples a heightmap instead
+};
+typedef struct render_sort_entry render_sort_entry;
+struct render_sort_entry
+{
+  u64 Key;
+  u32 Index;
+};
+typedef struct render_queue render_queue;
+struct render_queue
+{
+  render_cmd *Cmds;
+  render_sort_entry *Sorted;
+  u32 Count;
+  u32 Capacity;
+  u32 DroppedCount;
+  u32 NextDepth;
+  v2f Res;  //WinRes for the frame being submitted
+  f32 Time;
+  r2f ClipRect; //RenderCmd_Mesh scissor, ui pixels (top left origin)
+};
+u64 RenderKey(render_layer Layer, u32 ProgramId, u32 LayoutId, u32 TextureId, u32 Depth)
+{
+  u64 Result = 0;
+  Result |= ((u64)Layer    &((1ULL<<RENDER_KEY_LAYER_BITS  )-1)) << RENDER_KEY_LAYER_SHIFT;
+  Result |= ((u64)ProgramId&((1ULL<<RENDER_KEY_PROGRAM_BITS)-1)) << RENDER_KEY_PROGRAM_SHIFT;
+  Result |= ((u64)LayoutId &((1ULL<<RENDER_KEY_LAYOUT_BITS )-1)) << RENDER_KEY_LAYOUT_SHIFT;
+  Result |= ((u64)TextureId&((1ULL<<RENDER_KEY_TEXTURE_BITS)-1)) << RENDER_KEY_TEXTURE_SHIFT;
+  Result |= ((u64)Depth    &((1ULL<<RENDER_KEY_DEPTH_BITS  )-1)) << RENDER_KEY_DEPTH_SHIFT;
+  return Result;
+}
+// NOTE(MIGUEL): storage comes from the frame arena, so this runs every frame
+b32 RenderQueueBegin(render_queue *Queue, arena *Arena, u32 Capacity)
+{
+  Queue->Cmds         = ArenaPushArray(Arena, render_cmd, Capacity);
+  Queue->Sorted       = ArenaPushArray(Arena, render_sort_entry, Capacity);
+  Queue->Count        = 0;
+  Queue->Capacity     = (Queue->Cmds && Queue->Sorted)?Capacity:0;
+  Queue->DroppedCount = 0;
+  Queue->NextDepth    = 0;
+  return Queue->Capacity != 0;
+}
+// NOTE(MIGUEL): NULL when the queue is full. the caller fills everything but the key's depth,
+//               which defaults to push order so painter's order survives the sort.
+render_cmd *RenderQueuePush(render_queue *Queue, u64 Key)
+{
+  if(!(Queue->Count<Queue->Capacity))
+  {
+    Queue->DroppedCount++;
+    return NULL;
+  }
+  render_cmd *Cmd = &Queue->Cmds[Queue->Count++];
+  MemorySet(0, Cmd, sizeof(render_cmd));
+  Cmd->Key = Key | RenderKey(0, 0, 0, 0, Queue->NextDepth++);
+  return Cmd;
+}
+// NOTE(MIGUEL): lsd radix sort, 8 bits per pass. passes where every key has the same byte
+//               are skipped, which with this key layout is most of them. short queues (the
+//               common case) use an insertion sort, the histograms alone cost more there.
+#define RENDER_SORT_RADIX_MIN_COUNT (64)
+void RenderQueueSort(render_queue *Queue, arena *Scratch)
+{
+  u32 Count = Queue->Count;
+  render_sort_entry *Src = Queue->Sorted;
+  for(u32 i=0; i<Count; i++)
+  {
+    Src[i].Key   = Queue->Cmds[i].Key;
+    Src[i].Index = i;
+  }
+  if(Count < RENDER_SORT_RADIX_MIN_COUNT)
+  {
+    for(u32 i=1; i<Count; i++)
+    {
+      render_sort_entry Entry = Src[i];
+      u32 j = i;
+      for(; j>0 && Src[j-1].Key>Entry.Key; j--) { Src[j] = Src[j-1]; }
+      Src[j] = Entry;
+    }
+    return;
+  }
+  arena_temp Temp = ArenaTempBegin(Scratch);
+  render_sort_entry *Dst = ArenaPushArray(Scratch, render_sort_entry, Count);
+  if(Dst)
+  {
+    for(u32 Shift=0; Shift<64; Shift+=8)
+    {
+      u32 Offsets[256] = {0};
+      for(u32 i=0; i<Count; i++) { Offsets[(Src[i].Key>>Shift)&0xff]++; }
+      if(Offsets[(Src[0].Key>>Shift)&0xff] == Count) continue;
+      u32 Total = 0;
+      for(u32 Byte=0; Byte<256; Byte++)
+      {
+        u32 ByteCount = Offsets[Byte];
+        Offsets[Byte] = Total;
+        Total += ByteCount;
+      }
+      for(u32 i=0; i<Count; i++) { Dst[Offsets[(Src[i].Key>>Shift)&0xff]++] = Src[i]; }
+      render_sort_entry *Swap = Src;
+      Src = Dst;
+      Dst = Swap;
+    }
+    if(Src != Queue->Sorted) { memcpy(Queue->Sorted, Src, Count*sizeof(render_sort_entry)); }
+  }
+  ArenaTempEnd(Temp);
+  return;
+}
+
 #endif //RENDER_H
@@ -0,0 +1,120 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+// NOTE(MIGUEL): 4 wide float ops over SSE2 (x86/x86_64 always has it), NEON on arm, and plain
+//               loops everywhere else so the same kernel compiles for every ABI. Only what the
+//               kernels actually use is here. Masks are all bits set per lane where true.
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define SIMD_ISA_NAME "sse2"
+typedef __m128 f32x4;
+typedef __m128 f32x4_mask;
+inline f32x4 F32x4Set1(f32 A) { return _mm_set1_ps(A); }
+inline f32x4 F32x4Set(f32 A, f32 B, f32 C, f32 D) { return _mm_setr_ps(A, B, C, D); }
+inline f32x4 F32x4Load(const f32 *A) { return _mm_loadu_ps(A); }
+inline void F32x4Store(f32 *Dest, f32x4 A) { _mm_storeu_ps(Dest, A); return; }
+inline f32x4 F32x4Add(f32x4 A, f32x4 B) { return _mm_add_ps(A, B); }
+inline f32x4 F32x4Sub(f32x4 A, f32x4 B) { return _mm_sub_ps(A, B); }
+inline f32x4 F32x4Mul(f32x4 A, f32x4 B) { return _mm_mul_ps(A, B); }
+inline f32x4 F32x4Max(f32x4 A, f32x4 B) { return _mm_max_ps(A, B); }
+inline f32x4_mask F32x4GreaterEqual(f32x4 A, f32x4 B) { return _mm_cmpge_ps(A, B); }
+inline f32x4_mask F32x4Greater(f32x4 A, f32x4 B) { return _mm_cmpgt_ps(A, B); }
+inline f32x4 F32x4Select(f32x4_mask Mask, f32x4 A, f32x4 B)
+{
+  return _mm_or_ps(_mm_and_ps(Mask, A), _mm_andnot_ps(Mask, B));
+}
+//truncate toward zero, |A| has to fit an s32
+inline f32x4 F32x4Truncate(f32x4 A) { return _mm_cvtepi32_ps(_mm_cvttps_epi32(A)); }
+inline f32x4_mask F32x4MaskAnd(f32x4_mask A, f32x4_mask B) { return _mm_and_ps(A, B); }
+//lane i's mask in bit i
+inline u32 F32x4MaskBits(f32x4_mask A) { return (u32)_mm_movemask_ps(A); }
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define SIMD_ISA_NAME "neon"
+typedef float32x4_t f32x4;
+typedef uint32x4_t  f32x4_mask;
+inline f32x4 F32x4Set1(f32 A) { return vdupq_n_f32(A); }
+inline f32x4 F32x4Set(f32 A, f32 B, f32 C, f32 D) { f32 E[4] = {A, B, C, D}; return vld1q_f32(E); }
+inline f32x4 F32x4Load(const f32 *A) { return vld1q_f32(A); }
+inline void F32x4Store(f32 *Dest, f32x4 A) { vst1q_f32(Dest, A); return; }
+inline f32x4 F32x4Add(f32x4 A, f32x4 B) { return vaddq_f32(A, B); }
+inline f32x4 F32x4Sub(f32x4 A, f32x4 B) { return vsubq_f32(A, B); }
+inline f32x4 F32x4Mul(f32x4 A, f32x4 B) { return vmulq_f32(A, B); }
+inline f32x4 F32x4Max(f32x4 A, f32x4 B) { return vmaxq_f32(A, B); }
+inline f32x4_mask F32x4GreaterEqual(f32x4 A, f32x4 B) { return vcgeq_f32(A, B); }
+inline f32x4_mask F32x4Greater(f32x4 A, f32x4 B) { return vcgtq_f32(A, B); }
+inline f32x4 F32x4Select(f32x4_mask Mask, f32x4 A, f32x4 B) { return vbslq_f32(Mask, A, B); }
+//vrndmq is armv8 only, this works on armeabi-v7a too
+inline f32x4 F32x4Truncate(f32x4 A) { return vcvtq_f32_s32(vcvtq_s32_f32(A)); }
+inline f32x4_mask F32x4MaskAnd(f32x4_mask A, f32x4_mask B) { return vandq_u32(A, B); }
+//no movemask on neon, weigh the lanes and add them up (vaddvq is armv8 only)
+inline u32 F32x4MaskBits(f32x4_mask A)
+{
+  const u32 Weights[4] = {1, 2, 4, 8};
+  uint32x4_t Bits = vandq_u32(A, vld1q_u32(Weights));
+  uint32x2_t Sum  = vpadd_u32(vget_low_u32(Bits), vget_high_u32(Bits));
+  return vget_lane_u32(vpadd_u32(Sum, Sum), 0);
+}
+#else
+#define SIMD_ISA_NAME "scalar"
+typedef struct f32x4 f32x4;
+struct f32x4 { f32 E[4]; };
+typedef struct f32x4_mask f32x4_mask;
+struct f32x4_mask { u32 E[4]; };
+inline f32x4 F32x4Set1(f32 A) { f32x4 R = {{A, A, A, A}}; return R; }
+inline f32x4 F32x4Set(f32 A, f32 B, f32 C, f32 D) { f32x4 R = {{A, B, C, D}}; return R; }
+inline f32x4 F32x4Load(const f32 *A) { f32x4 R; for(u32 i=0; i<4; i++) { R.E[i] = A[i]; } return R; }
+inline void F32x4Store(f32 *Dest, f32x4 A) { for(u32 i=0; i<4; i++) { Dest[i] = A.E[i]; } return; }
+inline f32x4 F32x4Add(f32x4 A, f32x4 B) { for(u32 i=0; i<4; i++) { A.E[i] += B.E[i]; } return A; }
+inline f32x4 F32x4Sub(f32x4 A, f32x4 B) { for(u32 i=0; i<4; i++) { A.E[i] -= B.E[i]; } return A; }
+inline f32x4 F32x4Mul(f32x4 A, f32x4 B) { for(u32 i=0; i<4; i++) { A.E[i] *= B.E[i]; } return A; }
+inline f32x4 F32x4Max(f32x4 A, f32x4 B) { for(u32 i=0; i<4; i++) { A.E[i] = Max(A.E[i], B.E[i]); } return A; }
+inline f32x4_mask F32x4GreaterEqual(f32x4 A, f32x4 B)
+{
+  f32x4_mask R; for(u32 i=0; i<4; i++) { R.E[i] = (A.E[i]>=B.E[i])?~0u:0; } return R;
+}
+inline f32x4_mask F32x4Greater(f32x4 A, f32x4 B)
+{
+  f32x4_mask R; for(u32 i=0; i<4; i++) { R.E[i] = (A.E[i]>B.E[i])?~0u:0; } return R;
+}
+inline f32x4 F32x4Select(f32x4_mask Mask, f32x4 A, f32x4 B)
+{
+  for(u32 i=0; i<4; i++) { A.E[i] = Mask.E[i]?A.E[i]:B.E[i]; } return A;
+}
+inline f32x4 F32x4Truncate(f32x4 A) { for(u32 i=0; i<4; i++) { A.E[i] = (f32)(s32)A.E[i]; } return A; }
+inline f32x4_mask F32x4MaskAnd(f32x4_mask A, f32x4_mask B) { for(u32 i=0; i<4; i++) { A.E[i] &= B.E[i]; } return A; }
+inline u32 F32x4MaskBits(f32x4_mask A)
+{
+  u32 R = 0; for(u32 i=0; i<4; i++) { R |= (A.E[i]&1u)<<i; } return R;
+}
+#endif
+//- built on the ops above
+inline f32x4 F32x4Floor(f32x4 A)
+{
+  f32x4 Trunc = F32x4Truncate(A);
+  return F32x4Select(F32x4Greater(Trunc, A), F32x4Sub(Trunc, F32x4Set1(1.0f)), Trunc);
+}
+inline f32x4 F32x4Fract(f32x4 A) { return F32x4Sub(A, F32x4Floor(A)); }
+// NOTE(MIGUEL): range reduced to [-pi/2, pi/2] and a 9th order taylor series there. ~4e-6 max
+//               error near 0, the f32 range reduction makes that ~1e-4 by |A| = 2000. Good
+//               enough to hash with, not for geometry.
+inline f32x4 F32x4Sin(f32x4 A)
+{
+  f32x4 Pi     = F32x4Set1(3.14159265f);
+  f32x4 HalfPi = F32x4Set1(1.57079633f);
+  f32x4 Turns  = F32x4Floor(F32x4Add(F32x4Mul(A, F32x4Set1(0.159154943f)), F32x4Set1(0.5f)));
+  f32x4 x = F32x4Sub(A, F32x4Mul(Turns, F32x4Set1(6.28318531f)));
+  //fold [-pi, pi] onto [-pi/2, pi/2], sin(pi-x) = sin(x)
+  x = F32x4Select(F32x4Greater(x, HalfPi), F32x4Sub(Pi, x), x);
+  x = F32x4Select(F32x4Greater(F32x4Sub(F32x4Set1(0.0f), HalfPi), x),
+                  F32x4Sub(F32x4Sub(F32x4Set1(0.0f), Pi), x), x);
+  f32x4 x2 = F32x4Mul(x, x);
+  f32x4 r = F32x4Set1(1.0f/362880.0f);
+  r = F32x4Add(F32x4Mul(r, x2), F32x4Set1(-1.0f/5040.0f));
+  r = F32x4Add(F32x4Mul(r, x2), F32x4Set1( 1.0f/120.0f));
+  r = F32x4Add(F32x4Mul(r, x2), F32x4Set1(-1.0f/6.0f));
+  r = F32x4Add(F32x4Mul(r, x2), F32x4Set1( 1.0f));
+  return F32x4Mul(r, x);
+}
+
+#endif //SIMD_H
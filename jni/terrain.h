@@ -0,0 +1,311 @@
+#ifndef TERRAIN_H
+#define TERRAIN_H
+
+#include <pthread.h>
+
+// NOTE(MIGUEL): Terrain. One unit sized chunk mesh (with skirts) is shared by every node of a
+//               quadtree over the terrain extent, each drawn chunk only differs in the UChunk
+//               uniform (center xz, size, skirt depth). Per frame the tree is walked, nodes
+//               outside the frustum are dropped and nodes whose vertex spacing covers too many
+//               pixels are split, so the drawn vertex count stays about the same no matter
+//               how fine the deepest level is.
+//
+//               Heights come from a heightfield over the finest level's vertices that only
+//               re-evaluates the rows and columns the noise scroll moves in. Every frame each
+//               drawn chunk gathers its vertices' heights out of it into the stream ring.
+//
+//               The chunk mesh is allocated once from the permanent arena and filled either
+//               right away or on a worker thread while the first frames go out without
+//               terrain. Once built it outlives gl contexts, a new EngineInit only has to
+//               upload it again.
+#define TERRAIN_CHUNK_QUADS (32)
+#define TERRAIN_LOD_LEVELS (6) //the finest level has TERRAIN_CHUNK_QUADS<<5 = 1024 quads per side
+#define TERRAIN_EXTENT (1.0f/32.0f) //the size the old single 64x64 plane had
+#define TERRAIN_HEIGHT_MAX (3.0f) //vertex3d.glsl scales the noise by this
+#define TERRAIN_SKIRT_DEPTH (TERRAIN_HEIGHT_MAX)
+#define TERRAIN_LOD_ERROR_PX (4.0f) //split nodes whose vertex spacing is wider than this on screen
+#define TERRAIN_MAX_CHUNKS (512)
+#define TERRAIN_NOISE_SCALE (100.0f) //terrain units to noise space
+#define TERRAIN_NOISE_SCROLL_SPEED (0.3f) //noise space units per second, along x and z
+#define TERRAIN_HEIGHTFIELD_SIDE ((TERRAIN_CHUNK_QUADS<<(TERRAIN_LOD_LEVELS-1))+1)
+#define TERRAIN_SCROLL_JOB_ROWS (128) //heightfield rows per scroll job
+#define TERRAIN_SCROLL_JOB_COUNT ((TERRAIN_HEIGHTFIELD_SIDE+TERRAIN_SCROLL_JOB_ROWS-1)/TERRAIN_SCROLL_JOB_ROWS)
+typedef struct terrain_chunk terrain_chunk;
+struct terrain_chunk
+{
+  v4f Params; //UChunk: center x, center z, size, skirt depth
+  u32 Level;
+  u32 SampleX; //heightfield sample of the chunk's first vertex
+  u32 SampleZ;
+  u32 SampleStride; //heightfield samples between vertices
+  u32 HeightsOffset; //where the gathered heights went in the stream ring
+  v4f HeightmapParams; //UHeightmapChunk, depends on the scroll so the update fills it in
+};
+typedef struct terrain_view terrain_view;
+struct terrain_view
+{
+  mat4 ClipFromLocal;
+  vec4 Planes[6];
+  f32 HalfWidth;
+  f32 HalfHeight;
+  f32 MaxErrorPx;
+};
+typedef struct terrain_selection terrain_selection;
+struct terrain_selection
+{
+  terrain_chunk *Chunks;
+  u32 Count;
+  u32 Capacity;
+  u32 VisitedCount;
+  u32 CulledCount;
+  u32 DroppedCount;
+};
+typedef struct terrain terrain;
+struct terrain
+{
+  grid_mesh Mesh;
+  heightfield Heightfield;
+  f32 QuadSize;
+  u32 IsReady; //set by the builder once Mesh is complete, read with acquire
+  b32 IsThreadRunning;
+  pthread_t Thread;
+  u64 BuildBeginNs;
+  u64 BuildNs;   //fill time on whatever thread did it
+  u64 ReadyAtNs; //GetTimeNanos() when the mesh was done
+};
+void TerrainBuild(terrain *Terrain)
+{
+  u64 Begin = GetTimeNanos();
+  GridMeshFill(&Terrain->Mesh, Terrain->QuadSize);
+  HeightfieldUpdate(&Terrain->Heightfield, 0);
+  u64 End = GetTimeNanos();
+  Terrain->BuildNs   = End-Begin;
+  Terrain->ReadyAtNs = End;
+  __atomic_store_n(&Terrain->IsReady, 1, __ATOMIC_RELEASE);
+  return;
+}
+void *TerrainBuildThreadProc(void *Param)
+{
+  TerrainBuild((terrain *)Param);
+  return NULL;
+}
+// NOTE(MIGUEL): allocation happens here on the calling thread, only the fill moves off it.
+//               Falls back to building inline if the thread can't be started.
+b32 TerrainBuildBegin(terrain *Terrain, arena *Arena, u32 QuadsPerSide, b32 Async)
+{
+  MemorySet(0, Terrain, sizeof(terrain));
+  if(!GridMeshAlloc(&Terrain->Mesh, Arena, QuadsPerSide, 1)) return 0;
+  f32 SampleSpacing = TERRAIN_EXTENT/(f32)(TERRAIN_HEIGHTFIELD_SIDE-1);
+  if(!HeightfieldAlloc(&Terrain->Heightfield, Arena, TERRAIN_HEIGHTFIELD_SIDE,
+                       -0.5f*TERRAIN_EXTENT*TERRAIN_NOISE_SCALE, SampleSpacing*TERRAIN_NOISE_SCALE,
+                       TERRAIN_HEIGHT_MAX)) return 0;
+  Terrain->QuadSize     = 1.0f/(f32)QuadsPerSide;
+  Terrain->BuildBeginNs = GetTimeNanos();
+  if(Async && pthread_create(&Terrain->Thread, NULL, TerrainBuildThreadProc, Terrain) == 0)
+  {
+    Terrain->IsThreadRunning = 1;
+  }
+  else
+  {
+    TerrainBuild(Terrain);
+  }
+  return 1;
+}
+// NOTE(MIGUEL): non blocking, reaps the worker the first time it sees the mesh done
+b32 TerrainIsReady(terrain *Terrain)
+{
+  b32 Result = __atomic_load_n(&Terrain->IsReady, __ATOMIC_ACQUIRE);
+  if(Result && Terrain->IsThreadRunning)
+  {
+    pthread_join(Terrain->Thread, NULL);
+    Terrain->IsThreadRunning = 0;
+  }
+  return Result;
+}
+void TerrainBuildWait(terrain *Terrain)
+{
+  if(Terrain->IsThreadRunning)
+  {
+    pthread_join(Terrain->Thread, NULL);
+    Terrain->IsThreadRunning = 0;
+  }
+  return;
+}
+//~ LOD SELECTION
+void TerrainViewInit(terrain_view *View, mat4 ClipFromLocal, f32 Width, f32 Height, f32 MaxErrorPx)
+{
+  glm_mat4_copy(ClipFromLocal, View->ClipFromLocal);
+  glm_frustum_planes(View->ClipFromLocal, View->Planes);
+  View->HalfWidth  = Width*0.5f;
+  View->HalfHeight = Height*0.5f;
+  View->MaxErrorPx = MaxErrorPx;
+  return;
+}
+// NOTE(MIGUEL): pixels covered by one vertex spacing of a node, measured at its center along
+//               x and z. anything at or behind the eye counts as infinitely large.
+f32 TerrainNodeErrorPx(terrain_view *View, f32 CenterX, f32 CenterZ, f32 Size)
+{
+  f32 Spacing = Size/(f32)TERRAIN_CHUNK_QUADS;
+  vec4 Points[3] =
+  {
+    {CenterX        , 0.0f, CenterZ        , 1.0f},
+    {CenterX+Spacing, 0.0f, CenterZ        , 1.0f},
+    {CenterX        , 0.0f, CenterZ+Spacing, 1.0f},
+  };
+  vec2 Screen[3];
+  for(u32 i=0; i<3; i++)
+  {
+    vec4 Clip;
+    glm_mat4_mulv(View->ClipFromLocal, Points[i], Clip);
+    if(Clip[3] <= 1e-6f) return 1e30f;
+    Screen[i][0] = Clip[0]/Clip[3]*View->HalfWidth;
+    Screen[i][1] = Clip[1]/Clip[3]*View->HalfHeight;
+  }
+  f32 ErrorX = glm_vec2_distance(Screen[0], Screen[1]);
+  f32 ErrorZ = glm_vec2_distance(Screen[0], Screen[2]);
+  return Max(ErrorX, ErrorZ);
+}
+void TerrainSelectNode(terrain_selection *Selection, terrain_view *View,
+                       f32 CenterX, f32 CenterZ, f32 Size, u32 Level,
+                       u32 SampleX, u32 SampleZ, u32 SampleStride)
+{
+  Selection->VisitedCount++;
+  f32 Half = Size*0.5f;
+  vec3 Box[2] =
+  {
+    {CenterX-Half, -TERRAIN_HEIGHT_MAX-TERRAIN_SKIRT_DEPTH, CenterZ-Half},
+    {CenterX+Half,  TERRAIN_HEIGHT_MAX                    , CenterZ+Half},
+  };
+  if(!glm_aabb_frustum(Box, View->Planes))
+  {
+    Selection->CulledCount++;
+    return;
+  }
+  if(Level+1 < TERRAIN_LOD_LEVELS &&
+     TerrainNodeErrorPx(View, CenterX, CenterZ, Size) > View->MaxErrorPx)
+  {
+    f32 Quarter = Size*0.25f;
+    u32 Stride  = SampleStride/2;
+    u32 Mid     = (TERRAIN_CHUNK_QUADS/2)*SampleStride;
+    TerrainSelectNode(Selection, View, CenterX-Quarter, CenterZ-Quarter, Half, Level+1,
+                      SampleX    , SampleZ    , Stride);
+    TerrainSelectNode(Selection, View, CenterX+Quarter, CenterZ-Quarter, Half, Level+1,
+                      SampleX+Mid, SampleZ    , Stride);
+    TerrainSelectNode(Selection, View, CenterX-Quarter, CenterZ+Quarter, Half, Level+1,
+                      SampleX    , SampleZ+Mid, Stride);
+    TerrainSelectNode(Selection, View, CenterX+Quarter, CenterZ+Quarter, Half, Level+1,
+                      SampleX+Mid, SampleZ+Mid, Stride);
+    return;
+  }
+  if(!(Selection->Count<Selection->Capacity))
+  {
+    Selection->DroppedCount++;
+    return;
+  }
+  terrain_chunk *Chunk = &Selection->Chunks[Selection->Count++];
+  Chunk->Params = V4f(CenterX, CenterZ, Size, TERRAIN_SKIRT_DEPTH);
+  Chunk->Level  = Level;
+  Chunk->SampleX = SampleX;
+  Chunk->SampleZ = SampleZ;
+  Chunk->SampleStride  = SampleStride;
+  Chunk->HeightsOffset = 0;
+  return;
+}
+// NOTE(MIGUEL): chunk list comes from the frame arena
+void TerrainSelect(terrain_selection *Selection, terrain_view *View, arena *Arena)
+{
+  MemorySet(0, Selection, sizeof(terrain_selection));
+  Selection->Chunks   = ArenaPushArray(Arena, terrain_chunk, TERRAIN_MAX_CHUNKS);
+  Selection->Capacity = Selection->Chunks?TERRAIN_MAX_CHUNKS:0;
+  TerrainSelectNode(Selection, View, 0.0f, 0.0f, TERRAIN_EXTENT, 0,
+                    0, 0, 1<<(TERRAIN_LOD_LEVELS-1));
+  return;
+}
+//~ HEIGHTS
+typedef struct terrain_scroll_job terrain_scroll_job;
+struct terrain_scroll_job
+{
+  heightfield *Heightfield;
+  s64 Scroll;
+  u32 RowBegin;
+  u32 RowEnd;
+  u32 SampleCount;
+};
+void TerrainScrollJob(void *Data)
+{
+  terrain_scroll_job *Job = (terrain_scroll_job *)Data;
+  Job->SampleCount = HeightfieldUpdateRows(Job->Heightfield, Job->Scroll, Job->RowBegin, Job->RowEnd);
+  return;
+}
+// NOTE(MIGUEL): the shader used to scroll the noise continuously, the heightfield moves in whole
+//               samples (1/1024th of the terrain, less than a vertex at any lod). the rows are
+//               spread over jobs and this waits for them.
+void TerrainScroll(terrain *Terrain, f64 Time, job_system *Jobs)
+{
+  heightfield *Heightfield = &Terrain->Heightfield;
+  s64 Scroll = HeightfieldScrollFor(Heightfield, Time*TERRAIN_NOISE_SCROLL_SPEED);
+  Heightfield->SampleCount = 0;
+  if(!HeightfieldNeedsUpdate(Heightfield, Scroll)) return;
+  terrain_scroll_job ScrollJobs[TERRAIN_SCROLL_JOB_COUNT];
+  job_counter Counter = {0};
+  u32 JobCount = 0;
+  for(u32 Row=0; Row<Heightfield->Side; Row+=TERRAIN_SCROLL_JOB_ROWS)
+  {
+    terrain_scroll_job *Job = &ScrollJobs[JobCount++];
+    Job->Heightfield = Heightfield;
+    Job->Scroll      = Scroll;
+    Job->RowBegin    = Row;
+    Job->RowEnd      = Min(Row+TERRAIN_SCROLL_JOB_ROWS, Heightfield->Side);
+    Job->SampleCount = 0;
+    JobRun(Jobs, TerrainScrollJob, Job, &Counter);
+  }
+  JobWait(Jobs, &Counter);
+  u32 SampleCount = 0;
+  for(u32 i=0; i<JobCount; i++) { SampleCount += ScrollJobs[i].SampleCount; }
+  HeightfieldUpdateEnd(Heightfield, Scroll, SampleCount);
+  return;
+}
+// NOTE(MIGUEL): UHeightmapChunk for a chunk, when the heights come from a texture copy of the
+//               heightfield's storage instead of being gathered
+v4f TerrainChunkHeightmapParams(terrain *Terrain, terrain_chunk *Chunk)
+{
+  heightfield *Heightfield = &Terrain->Heightfield;
+  s64 Scroll = Heightfield->Scroll;
+  v4f Result = V4f((f32)HeightfieldWrap(Heightfield, Scroll+Chunk->SampleX),
+                   (f32)HeightfieldWrap(Heightfield, Scroll+Chunk->SampleZ),
+                   (f32)(TERRAIN_CHUNK_QUADS*Chunk->SampleStride),
+                   1.0f/(f32)Heightfield->Side);
+  return Result;
+}
+// NOTE(MIGUEL): one height per chunk mesh vertex in mesh order, skirt vertices repeat the
+//               border vertex they hang from. Dest needs Mesh.VertexCount floats.
+void TerrainChunkHeights(terrain *Terrain, terrain_chunk *Chunk, f32 *Dest)
+{
+  heightfield *Heightfield = &Terrain->Heightfield;
+  u32 Side = TERRAIN_CHUNK_QUADS+1;
+  u32 Cols[TERRAIN_CHUNK_QUADS+1];
+  s64 Scroll = Heightfield->Scroll;
+  for(u32 x=0; x<Side; x++)
+  {
+    Cols[x] = HeightfieldWrap(Heightfield, Scroll+Chunk->SampleX+x*Chunk->SampleStride);
+  }
+  f32 *Row = Dest;
+  for(u32 z=0; z<Side; z++)
+  {
+    u32 RowIndex = HeightfieldWrap(Heightfield, Scroll+Chunk->SampleZ+z*Chunk->SampleStride);
+    f32 *Src = Heightfield->Heights + (u64)RowIndex*Heightfield->Side;
+    for(u32 x=0; x<Side; x++) { Row[x] = Src[Cols[x]]; }
+    Row += Side;
+  }
+  if(Terrain->Mesh.HasSkirt)
+  {
+    f32 *Skirt = Dest+Side*Side;
+    for(u32 Edge=0; Edge<4; Edge++)
+    {
+      for(u32 i=0; i<Side; i++) { *Skirt++ = Dest[GridMeshBorderIndex(Side, Edge, i)]; }
+    }
+  }
+  return;
+}
+
+#endif //TERRAIN_H
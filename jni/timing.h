@@ -0,0 +1,19 @@
+#ifndef TIMING_H
+#define TIMING_H
+
+#include <time.h>
+
+u64 GetTimeNanos(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (u64) now.tv_sec*1000000000LL + now.tv_nsec;
+}
+f64 GetTimeSeconds(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (f64)now.tv_sec + (f64)(now.tv_nsec/(f64)1000000000.0);
+}
+
+#endif //TIMING_H
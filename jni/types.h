@@ -6,7 +6,9 @@
 #define NULLPTR ((void *)0x00UL)
 
 typedef int32_t  s32;
+typedef int64_t  s64;
 typedef uint8_t   u8;
+typedef uint16_t u16;
 typedef uint32_t u32;
 typedef uint64_t u64;
 typedef uint32_t b32;
@@ -14,4 +16,10 @@ typedef float    f32;
 typedef double   f64;
 #define U32Max UINT32_MAX
 
+#define Min(a, b) (((a)<(b))?(a):(b))
+#define Max(a, b) (((a)>(b))?(a):(b))
+#define ArrayCount(array) (sizeof(array)/sizeof(array[0]))
+#define SymbolToString(symbol) #symbol
+#define ThisFuncionAsString() __FUNCTION__
+
 #endif //TYPES_H
@@ -1,37 +1,127 @@
 #ifndef UI_H
 #define UI_H
 
-// current element identifiers:
-//   - pointers
-//   - id (indexes atm)
-//   - hashed keys(not impl)
+// NOTE(MIGUEL): Keyed immediate mode ui. Widgets are declared every frame under a key (hashed
+//               string, pointer or a parent key combined with an index) and the key finds the
+//               element that carries their state between frames (rect, z, selection) through an
+//               open addressing table. Declaring stamps the element with the frame's generation,
+//               elements that weren't declared by UIStateEndFrame are evicted and their slot
+//               reused, so a ui can be rebuilt from scratch every frame and still only costs a
+//               lookup per widget.
+typedef u64 ui_key;
+#define UI_NULL_KEY (0)
 typedef enum ui_elm_flags ui_elm_flags;
 enum ui_elm_flags
 {
   UI_Flag_None       = (0<<0),
   UI_Flag_Selectable = (1<<0),
+  UI_Flag_Layout     = (1<<1), //only arranges its children, not drawn or picked
 };
-#define UI_NULL_ELEMENT_ID (U32Max)
+// NOTE(MIGUEL): Layout. Elements declared between UIStatePushParent/UIStatePopParent become
+//               children of that parent and get their rect from it: measure goes bottom up and
+//               sizes everything (fixed px, fit the children, or at least fit and grow into what
+//               the parent has left), arrange goes top down and stacks the children along the
+//               parent's axis. Both passes cache per element. A change to a layout, a size or the
+//               children of an element marks it and its ancestors dirty, measure only walks dirty
+//               elements and arrange stops at any subtree whose rect came out the same, so one
+//               changed child costs its ancestors and the siblings it pushes around.
+//               Elements with no parent are roots and keep their own rect (drags move them), a
+//               root only lays its children out at its min corner.
+//               New elements go to the bottom of the z list, under the parent declared before them,
+//               so containers with children should be UI_Flag_Layout.
+typedef enum ui_axis ui_axis;
+enum ui_axis
+{
+  UI_Axis_X,
+  UI_Axis_Y,
+  UI_Axis_Count,
+};
+typedef enum ui_size_kind ui_size_kind;
+enum ui_size_kind
+{
+  UI_Size_Fixed, //Value px
+  UI_Size_Fit,   //the children
+  UI_Size_Grow,  //fit, then Value weighted share of the parent's free space
+};
+typedef struct ui_size ui_size;
+struct ui_size
+{
+  ui_size_kind Kind;
+  f32 Value;
+};
+typedef struct ui_layout ui_layout;
+struct ui_layout
+{
+  ui_size Size[UI_Axis_Count];
+  ui_axis Axis; //children are stacked along this one
+  f32 Padding;
+  f32 Gap;
+};
+inline ui_size UISizeFixed(f32 Px)     { ui_size Result = { UI_Size_Fixed, Px }; return Result; }
+inline ui_size UISizeFit(void)         { ui_size Result = { UI_Size_Fit, 0.0f }; return Result; }
+inline ui_size UISizeGrow(f32 Weight)  { ui_size Result = { UI_Size_Grow, Weight }; return Result; }
+inline b32 UILayoutIsEqual(ui_layout *A, ui_layout *B)
+{
+  return (A->Size[0].Kind == B->Size[0].Kind && A->Size[0].Value == B->Size[0].Value &&
+          A->Size[1].Kind == B->Size[1].Kind && A->Size[1].Value == B->Size[1].Value &&
+          A->Axis == B->Axis && A->Padding == B->Padding && A->Gap == B->Gap);
+}
+inline ui_layout UILayout(ui_axis Axis, ui_size Width, ui_size Height, f32 Padding, f32 Gap)
+{
+  ui_layout Result = { .Size = { Width, Height }, .Axis = Axis, .Padding = Padding, .Gap = Gap };
+  return Result;
+}
+#define UI_NULL_SLOT (U32Max)
 typedef struct ui_elm ui_elm;
 struct ui_elm
 {
-  u32 Id;
+  ui_key Key; //UI_NULL_KEY while the slot is free
+  u64 Generation; //frame it was last declared in
   r2f Rect;
   v4f Color;
   ui_elm_flags Flags;
   //z list: draw order
   ui_elm *Next;
   ui_elm *Prev;
+  s32 Z; //higher is closer to the top, follows the z list
+  //attribute stack tops when it was last declared
+  v4f Tint;
+  v2f Offset;
+  r2f Clip;
   //u32 *Text;
-  //hierarcy
-  //...
+  //hierarchy, children in declaration order
+  ui_elm *Parent;
+  ui_elm *FirstChild;
+  ui_elm *LastChild;
+  ui_elm *NextSibling;
+  ui_elm *PrevSibling;
+  ui_elm *LastDeclaredChild; //this frame, while it is a parent on the stack
+  u32 ChildCount;
+  //layout
+  ui_layout Layout;
+  v2f Measured; //cached, valid while !IsMeasureDirty
+  b32 IsMeasureDirty;
+  b32 IsArrangeDirty;
 };
+// NOTE(MIGUEL): Attribute stacks. Whatever is on top when an element is declared sticks to it: the
+//               colors multiply into a tint, the offsets add up and the clips intersect, so each
+//               entry already holds the combined value and reading the top is all it takes. The
+//               element's quad gets them baked in when it goes into the draw bucket (moved,
+//               clipped on the cpu, tinted) so nested panels and scroll regions stay one flat
+//               bucket with no per widget state on the gpu. Picking uses the same visible rect.
+//               Fixed arrays in the ui state, pushing and popping never allocates.
 #define UI_STACKS_MAX_COUNT (64)
+#define UI_CLIP_NONE_MIN (-3.0e38f)
+#define UI_CLIP_NONE_MAX ( 3.0e38f)
 typedef struct ui_stacks ui_stacks;
 struct ui_stacks
 {
   v4f Color [UI_STACKS_MAX_COUNT];
   v2f Offset[UI_STACKS_MAX_COUNT];
+  r2f Clip  [UI_STACKS_MAX_COUNT];
+  u32 ColorCount; //entry 0 is the default and never pops
+  u32 OffsetCount;
+  u32 ClipCount;
 };
 typedef struct ui_zlist ui_zlist;
 struct ui_zlist
@@ -39,42 +129,444 @@ struct ui_zlist
   ui_elm *Top;
   ui_elm *Bottom;
 };
-#define UI_ELEMENT_MAX_COUNT (256)
+// NOTE(MIGUEL): screen space uniform grid for picking. every element is linked into the cells
+//               its rect covers, a hit test only looks at the one cell under the point and keeps
+//               the highest Z that contains it. elements covering more than UI_GRID_MAX_SPAN_CELLS
+//               cells go in an overflow list every test checks instead, so a few big panels
+//               can't eat the node pool. rect changes, pushes and pops update it in place.
+#define UI_GRID_CELL_SIZE (128.0f) //px, grows when the screen needs more than UI_GRID_MAX_DIM
+#define UI_GRID_MAX_DIM (64)
+#define UI_GRID_MAX_SPAN_CELLS (64)
+#define UI_GRID_NODES_PER_ELEMENT (8) //node pool sizing, full pool sends elements to overflow
+#define UI_GRID_NULL_NODE (U32Max)
+typedef struct ui_grid_node ui_grid_node;
+struct ui_grid_node
+{
+  u32 Element; //slot in the element table
+  u32 Next;
+};
+typedef struct ui_grid_span ui_grid_span;
+struct ui_grid_span
+{
+  u16 x0, y0, x1, y1; //covered cells, inclusive
+  b32 IsLinked;
+  b32 IsOverflow;
+};
+typedef struct ui_grid ui_grid;
+struct ui_grid
+{
+  u32 Cells[UI_GRID_MAX_DIM*UI_GRID_MAX_DIM]; //first node
+  u32 Width;
+  u32 Height;
+  f32 CellSize;
+  u32 Overflow;  //first node of the overflow list
+  ui_grid_node *Nodes;
+  u32 NodeCapacity;
+  u32 FreeNode;
+  ui_grid_span *Spans; //one per element slot
+  u32 TestedCount; //entries looked at by hit tests since the caller last zeroed it
+};
+// NOTE(MIGUEL): element rects again as structure of arrays, slot i of each array is element slot i.
+//               the kernels below test 4 slots per op and hand back one bit per slot, 32 slots a
+//               word, for anything that asks the same question of lots of elements (picking, hover,
+//               culling). Capacity is rounded up to whole groups of 4, free and padding slots hold
+//               an inside out rect no test can hit.
+#define UI_RECTS_EMPTY_MIN ( 3.0e38f)
+#define UI_RECTS_EMPTY_MAX (-3.0e38f)
+#define UIRectsCapacity(Count) (((Count)+3)&~3u)
+#define UIRectsBitWords(Count) (((Count)+31)/32)
+typedef struct ui_rects ui_rects;
+struct ui_rects
+{
+  f32 *MinX; //16 byte aligned, Capacity each
+  f32 *MinY;
+  f32 *MaxX;
+  f32 *MaxY;
+  u32 Capacity;
+};
+// NOTE(MIGUEL): linear probing, the capacity is a power of 2 at least twice the element capacity
+//               so it stays at most half full. removal shifts the entries after it back instead of
+//               leaving tombstones, so eviction churn doesn't make lookups slower over time.
+typedef struct ui_table_entry ui_table_entry;
+struct ui_table_entry
+{
+  ui_key Key;
+  u32 Slot;
+};
+#define UITableCapacity(ElementCapacity) (UIRoundUpPow2(2*(ElementCapacity)))
+inline u32 UIRoundUpPow2(u32 Value) { u32 Result = 1; while(Result < Value) { Result <<= 1; } return Result; }
 typedef struct ui_state ui_state;
 struct ui_state
 {
-  ui_elm Elements[UI_ELEMENT_MAX_COUNT];
-  ui_elm *NextSlot;
-  ui_elm *OnePastLastSlot;
+  ui_elm *Elements; //storage comes from the engine's permanent arena
+  u32 Capacity;
+  u32 SlotCount;    //slots ever handed out, the rest were never used
+  ui_elm *FreeList; //evicted slots, linked through Next
   u32 ElementCount;
-  u32 SelectedId;
+  ui_key SelectedKey;
+  ui_table_entry *Table;
+  u32 TableMask;
+  u64 Generation;
+  //stats
+  u64 LookupCount;
+  u64 ProbeCount;
+  u64 EvictedCount;
+  u64 MeasuredCount; //elements measure/arrange actually recomputed
+  u64 ArrangedCount;
+  //layout
+  ui_elm *Parents[UI_STACKS_MAX_COUNT];
+  u32 ParentCount;
+  ui_stacks Stacks;
   //draw order not stack dependent
   ui_zlist ZList;
+  s32 ZTop;    //Z handed to the last element put at the top
+  s32 ZBottom; //Z handed to the last element pushed to the bottom
+  ui_grid Grid;
+  ui_rects Rects;
 };
 ui_state GlobalUIState = {0};
-inline b32 ElementIsBeforeLastPushed(ui_state *State, ui_elm *elm_ptr) {return (elm_ptr < State->NextSlot);}
-inline b32 ElementStorageEmpty      (ui_state *State) {return (State->NextSlot == State->Elements);}
-inline b32 ElementStorageFull       (ui_state *State) {return (State->NextSlot == State->OnePastLastSlot);}
+inline b32 ElementStorageEmpty      (ui_state *State) {return (State->ElementCount == 0);}
+inline b32 ElementStorageFull       (ui_state *State) {return (State->ElementCount == State->Capacity);}
 inline u32 ElementStorageCount      (ui_state *State) {return (State->ElementCount);}
-inline u32 ElementIsSelected        (ui_state *State, ui_elm *Element) {return (State->SelectedId == Element->Id);}
-inline u32 ElementNoneSelected      (ui_state *State)                  {return (State->SelectedId == UI_NULL_ELEMENT_ID);}
-inline u32 ElementSelect            (ui_state *State, ui_elm *Element) {return (State->SelectedId = Element->Id);}
-inline u32 ElementIsNull            (ui_elm *Element)                  {return (Element->Id == UI_NULL_ELEMENT_ID);}
+inline u32 ElementIsSelected        (ui_state *State, ui_elm *Element) {return (State->SelectedKey == Element->Key);}
+inline u32 ElementNoneSelected      (ui_state *State)                  {return (State->SelectedKey == UI_NULL_KEY);}
+inline void ElementSelect           (ui_state *State, ui_elm *Element) {State->SelectedKey = Element->Key; return;}
+inline u32 ElementIsNull            (ui_elm *Element)                  {return (Element->Key == UI_NULL_KEY);}
 #include "ui_logs.h"
 
-void UIStateInit(ui_state *State)
+void UIStacksReset(ui_stacks *Stacks)
 {
-  State->ElementCount    = 0;
-  State->NextSlot        = (State->Elements);
-  State->OnePastLastSlot = (State->Elements + UI_ELEMENT_MAX_COUNT);
-  State->SelectedId   = UI_NULL_ELEMENT_ID;
+  Stacks->Color [0] = V4f(1.0f, 1.0f, 1.0f, 1.0f);
+  Stacks->Offset[0] = V2f(0.0f, 0.0f);
+  Stacks->Clip  [0] = R2f(UI_CLIP_NONE_MIN, UI_CLIP_NONE_MIN, UI_CLIP_NONE_MAX, UI_CLIP_NONE_MAX);
+  Stacks->ColorCount  = 1;
+  Stacks->OffsetCount = 1;
+  Stacks->ClipCount   = 1;
+  return;
+}
+// NOTE(MIGUEL): Table holds UITableCapacity(Capacity) entries, both arrays are owned by the caller
+void UIStateInit(ui_state *State, ui_elm *Elements, u32 Capacity, ui_table_entry *Table)
+{
+  MemorySet(0, Elements, Capacity*sizeof(ui_elm));
+  MemorySet(0, Table, UITableCapacity(Capacity)*sizeof(ui_table_entry));
+  State->Elements     = Elements;
+  State->Capacity     = Capacity;
+  State->SlotCount    = 0;
+  State->FreeList     = NULL;
+  State->ElementCount = 0;
+  State->SelectedKey  = UI_NULL_KEY;
+  State->Table        = Table;
+  State->TableMask    = UITableCapacity(Capacity)-1;
+  State->Generation   = 0;
+  State->ParentCount  = 0;
+  UIStacksReset(&State->Stacks);
   State->ZList.Top    = NULL;
   State->ZList.Bottom = NULL;
+  State->ZTop    = 0;
+  State->ZBottom = 0;
+  return;
+}
+//~ KEYS
+// NOTE(MIGUEL): 64 bit finalizer from splitmix, good enough spread for a power of 2 table
+inline ui_key UIKeyMix(u64 Value)
+{
+  Value ^= Value>>30; Value *= 0xbf58476d1ce4e5b9ULL;
+  Value ^= Value>>27; Value *= 0x94d049bb133111ebULL;
+  Value ^= Value>>31;
+  return (Value==UI_NULL_KEY)?1:Value;
+}
+ui_key UIKeyFromString(const char *String)
+{
+  u64 Hash = 0xcbf29ce484222325ULL; //fnv-1a
+  for(; *String; String++) { Hash = (Hash^(u8)*String)*0x100000001b3ULL; }
+  return UIKeyMix(Hash);
+}
+ui_key UIKeyFromPointer(const void *Pointer) { return UIKeyMix((u64)(uintptr_t)Pointer); }
+//for lists: the n-th child of a parent key
+ui_key UIKeyCombine(ui_key Parent, u64 Index) { return UIKeyMix(Parent^UIKeyMix(Index+1)); }
+//~ TABLE
+u32 UITableFind(ui_state *State, ui_key Key)
+{
+  State->LookupCount++;
+  for(u32 Entry=(u32)Key&State->TableMask;; Entry=(Entry+1)&State->TableMask)
+  {
+    State->ProbeCount++;
+    if(State->Table[Entry].Key == Key) return State->Table[Entry].Slot;
+    if(State->Table[Entry].Key == UI_NULL_KEY) return UI_NULL_SLOT;
+  }
+}
+void UITableInsert(ui_state *State, ui_key Key, u32 Slot)
+{
+  u32 Entry = (u32)Key&State->TableMask;
+  while(State->Table[Entry].Key != UI_NULL_KEY) { Entry = (Entry+1)&State->TableMask; }
+  State->Table[Entry].Key  = Key;
+  State->Table[Entry].Slot = Slot;
   return;
 }
-ui_elm *UIElementGetById(u32 Id)
+void UITableRemove(ui_state *State, ui_key Key)
 {
-  ui_elm *Result = (Id!=UI_NULL_ELEMENT_ID)?&GlobalUIState.Elements[Id]:NULL;
+  u32 Mask  = State->TableMask;
+  u32 Entry = (u32)Key&Mask;
+  while(State->Table[Entry].Key != Key)
+  {
+    if(State->Table[Entry].Key == UI_NULL_KEY) return;
+    Entry = (Entry+1)&Mask;
+  }
+  //backward shift: pull later entries of the run into the hole unless they'd end up before
+  //their home entry
+  for(u32 Next=(Entry+1)&Mask; State->Table[Next].Key != UI_NULL_KEY; Next=(Next+1)&Mask)
+  {
+    u32 Home = (u32)State->Table[Next].Key&Mask;
+    if(((Next-Home)&Mask) >= ((Next-Entry)&Mask))
+    {
+      State->Table[Entry] = State->Table[Next];
+      Entry = Next;
+    }
+  }
+  State->Table[Entry].Key = UI_NULL_KEY;
+  return;
+}
+//~ GRID
+b32 UIGridLink(ui_grid *Grid, u32 *Head, u32 Element)
+{
+  u32 Node = Grid->FreeNode;
+  if(Node == UI_GRID_NULL_NODE) return 0;
+  Grid->FreeNode = Grid->Nodes[Node].Next;
+  Grid->Nodes[Node].Element = Element;
+  Grid->Nodes[Node].Next    = *Head;
+  *Head = Node;
+  return 1;
+}
+void UIGridUnlink(ui_grid *Grid, u32 *Head, u32 Element)
+{
+  for(u32 *Link = Head; *Link != UI_GRID_NULL_NODE; Link = &Grid->Nodes[*Link].Next)
+  {
+    u32 Node = *Link;
+    if(Grid->Nodes[Node].Element != Element) continue;
+    *Link = Grid->Nodes[Node].Next;
+    Grid->Nodes[Node].Next = Grid->FreeNode;
+    Grid->FreeNode = Node;
+    return;
+  }
+  return;
+}
+u32 UIGridCellOf(ui_grid *Grid, f32 Pos, u32 Count)
+{
+  s32 Cell = (s32)floorf(Pos/Grid->CellSize);
+  return (u32)Min(Max(Cell, 0), (s32)Count-1);
+}
+void UIGridRemove(ui_grid *Grid, u32 Element)
+{
+  ui_grid_span *Span = &Grid->Spans[Element];
+  if(!Span->IsLinked) return;
+  if(Span->IsOverflow)
+  {
+    UIGridUnlink(Grid, &Grid->Overflow, Element);
+  }
+  else
+  {
+    for(u32 y=Span->y0; y<=Span->y1; y++)
+    {
+      for(u32 x=Span->x0; x<=Span->x1; x++) { UIGridUnlink(Grid, &Grid->Cells[y*Grid->Width+x], Element); }
+    }
+  }
+  Span->IsLinked = 0;
+  return;
+}
+void UIGridInsert(ui_grid *Grid, u32 Element, r2f Rect)
+{
+  ui_grid_span *Span = &Grid->Spans[Element];
+  Span->x0 = (u16)UIGridCellOf(Grid, Rect.min.x, Grid->Width);
+  Span->y0 = (u16)UIGridCellOf(Grid, Rect.min.y, Grid->Height);
+  Span->x1 = (u16)UIGridCellOf(Grid, Rect.max.x, Grid->Width);
+  Span->y1 = (u16)UIGridCellOf(Grid, Rect.max.y, Grid->Height);
+  Span->IsLinked   = 1;
+  Span->IsOverflow = ((Span->x1-Span->x0+1)*(Span->y1-Span->y0+1) > UI_GRID_MAX_SPAN_CELLS);
+  b32 IsOutOfNodes = 0;
+  for(u32 y=Span->y0; y<=Span->y1 && !Span->IsOverflow; y++)
+  {
+    for(u32 x=Span->x0; x<=Span->x1 && !IsOutOfNodes; x++)
+    {
+      IsOutOfNodes = !UIGridLink(Grid, &Grid->Cells[y*Grid->Width+x], Element);
+    }
+    Span->IsOverflow = IsOutOfNodes;
+  }
+  if(IsOutOfNodes)
+  {//pool ran dry partway, take back what got linked and fall back to the overflow list
+    for(u32 y=Span->y0; y<=Span->y1; y++)
+    {
+      for(u32 x=Span->x0; x<=Span->x1; x++) { UIGridUnlink(Grid, &Grid->Cells[y*Grid->Width+x], Element); }
+    }
+  }
+  if(Span->IsOverflow && !UIGridLink(Grid, &Grid->Overflow, Element)) { Span->IsLinked = 0; }
+  return;
+}
+// NOTE(MIGUEL): Nodes/NodeCount and Spans (one per element slot) are owned by the caller. clears
+//               the grid and sizes its cells for a screen of Res, elements have to go back in.
+void UIGridInit(ui_grid *Grid, ui_grid_node *Nodes, u32 NodeCount, ui_grid_span *Spans, u32 SpanCount, v2f Res)
+{
+  Grid->CellSize = Max(UI_GRID_CELL_SIZE, Max(Res.x, Res.y)/(f32)UI_GRID_MAX_DIM);
+  Grid->Width    = (u32)Min(Max((s32)ceilf(Res.x/Grid->CellSize), 1), UI_GRID_MAX_DIM);
+  Grid->Height   = (u32)Min(Max((s32)ceilf(Res.y/Grid->CellSize), 1), UI_GRID_MAX_DIM);
+  for(u32 Cell=0; Cell<ArrayCount(Grid->Cells); Cell++) { Grid->Cells[Cell] = UI_GRID_NULL_NODE; }
+  Grid->Overflow     = UI_GRID_NULL_NODE;
+  Grid->Nodes        = Nodes;
+  Grid->NodeCapacity = NodeCount;
+  Grid->FreeNode     = NodeCount?0:UI_GRID_NULL_NODE;
+  for(u32 Node=0; Node<NodeCount; Node++)
+  {
+    Nodes[Node].Next = (Node+1<NodeCount)?(Node+1):UI_GRID_NULL_NODE;
+  }
+  Grid->Spans = Spans;
+  MemorySet(0, Spans, SpanCount*sizeof(ui_grid_span));
+  Grid->TestedCount = 0;
+  return;
+}
+//~ RECTS
+void UIRectsSet(ui_rects *Rects, u32 Slot, r2f Rect)
+{
+  Rects->MinX[Slot] = Rect.min.x;
+  Rects->MinY[Slot] = Rect.min.y;
+  Rects->MaxX[Slot] = Rect.max.x;
+  Rects->MaxY[Slot] = Rect.max.y;
+  return;
+}
+void UIRectsClear(ui_rects *Rects, u32 Slot)
+{
+  UIRectsSet(Rects, Slot, R2f(UI_RECTS_EMPTY_MIN, UI_RECTS_EMPTY_MIN, UI_RECTS_EMPTY_MAX, UI_RECTS_EMPTY_MAX));
+  return;
+}
+// NOTE(MIGUEL): Storage is 4*UIRectsCapacity(Count) floats, 16 byte aligned, owned by the caller
+void UIRectsInit(ui_rects *Rects, f32 *Storage, u32 Count)
+{
+  Rects->Capacity = UIRectsCapacity(Count);
+  Rects->MinX = Storage;
+  Rects->MinY = Rects->MinX+Rects->Capacity;
+  Rects->MaxX = Rects->MinY+Rects->Capacity;
+  Rects->MaxY = Rects->MaxX+Rects->Capacity;
+  for(u32 Slot=0; Slot<Rects->Capacity; Slot++) { UIRectsClear(Rects, Slot); }
+  return;
+}
+// NOTE(MIGUEL): bit i of Bits is set when Pos is in slot i, same edges as IsInRect. Bits holds
+//               UIRectsBitWords(Count) words and is overwritten.
+void UIRectsHitTestPoint(ui_rects *Rects, u32 Count, v2f Pos, u32 *Bits)
+{
+  f32x4 x = F32x4Set1(Pos.x);
+  f32x4 y = F32x4Set1(Pos.y);
+  MemorySet(0, Bits, UIRectsBitWords(Count)*sizeof(u32));
+  for(u32 Slot=0; Slot<Count; Slot+=4)
+  {
+    f32x4_mask Hit = F32x4MaskAnd(F32x4MaskAnd(F32x4GreaterEqual(x, F32x4Load(Rects->MinX+Slot)),
+                                               F32x4GreaterEqual(F32x4Load(Rects->MaxX+Slot), x)),
+                                  F32x4MaskAnd(F32x4GreaterEqual(y, F32x4Load(Rects->MinY+Slot)),
+                                               F32x4GreaterEqual(F32x4Load(Rects->MaxY+Slot), y)));
+    Bits[Slot/32] |= F32x4MaskBits(Hit)<<(Slot%32);
+  }
+  //the last group can run past Count into padding or free slots, which never hit
+  return;
+}
+// NOTE(MIGUEL): bit i of Bits is set when slot i overlaps Rect, edges touching counts
+void UIRectsHitTestRect(ui_rects *Rects, u32 Count, r2f Rect, u32 *Bits)
+{
+  f32x4 MinX = F32x4Set1(Rect.min.x);
+  f32x4 MinY = F32x4Set1(Rect.min.y);
+  f32x4 MaxX = F32x4Set1(Rect.max.x);
+  f32x4 MaxY = F32x4Set1(Rect.max.y);
+  MemorySet(0, Bits, UIRectsBitWords(Count)*sizeof(u32));
+  for(u32 Slot=0; Slot<Count; Slot+=4)
+  {
+    f32x4_mask Hit = F32x4MaskAnd(F32x4MaskAnd(F32x4GreaterEqual(MaxX, F32x4Load(Rects->MinX+Slot)),
+                                               F32x4GreaterEqual(F32x4Load(Rects->MaxX+Slot), MinX)),
+                                  F32x4MaskAnd(F32x4GreaterEqual(MaxY, F32x4Load(Rects->MinY+Slot)),
+                                               F32x4GreaterEqual(F32x4Load(Rects->MaxY+Slot), MinY)));
+    Bits[Slot/32] |= F32x4MaskBits(Hit)<<(Slot%32);
+  }
+  return;
+}
+r2f UIRectsGet(ui_rects *Rects, u32 Slot)
+{
+  return R2f(Rects->MinX[Slot], Rects->MinY[Slot], Rects->MaxX[Slot], Rects->MaxY[Slot]);
+}
+inline b32 UIBitsIsSet(u32 *Bits, u32 Slot) { return (Bits[Slot/32]>>(Slot%32))&1; }
+//~ PICKING
+// NOTE(MIGUEL): topmost element under Pos whose flags include Flags, NULL for none
+ui_elm *UIStateHitTest(ui_state *State, v2f Pos, ui_elm_flags Flags)
+{
+  ui_grid *Grid = &State->Grid;
+  ui_elm *Result = NULL;
+  u32 Cell = UIGridCellOf(Grid, Pos.y, Grid->Height)*Grid->Width+UIGridCellOf(Grid, Pos.x, Grid->Width);
+  u32 Lists[2] = { Grid->Cells[Cell], Grid->Overflow };
+  for(u32 List=0; List<2; List++)
+  {
+    for(u32 Node=Lists[List]; Node!=UI_GRID_NULL_NODE; Node=Grid->Nodes[Node].Next)
+    {
+      ui_elm *Element = &State->Elements[Grid->Nodes[Node].Element];
+      Grid->TestedCount++;
+      if((Element->Flags & Flags) != Flags || (Element->Flags & UI_Flag_Layout)) continue;
+      if(!IsInRect(UIRectsGet(&State->Rects, Grid->Nodes[Node].Element), Pos)) continue;
+      if(!Result || Element->Z > Result->Z) { Result = Element; }
+    }
+  }
+  return Result;
+}
+//where it is on screen: its rect moved by its offset and clipped, inside out when clipped away
+r2f UIElementVisibleRect(ui_elm *Element)
+{
+  return R2fIntersect(R2fOffset(Element->Rect, Element->Offset), Element->Clip);
+}
+// NOTE(MIGUEL): the grid and the soa rects hold visible rects, anything that changes one goes
+//               through here
+void UIStateSyncElementRect(ui_state *State, ui_elm *Element)
+{
+  u32 Slot = (u32)(Element-State->Elements);
+  r2f Visible = UIElementVisibleRect(Element);
+  if(R2fIsEmpty(Visible)) { UIRectsClear(&State->Rects, Slot); }
+  else                    { UIRectsSet(&State->Rects, Slot, Visible); }
+  UIGridRemove(&State->Grid, Slot);
+  if(!R2fIsEmpty(Visible)) { UIGridInsert(&State->Grid, Slot, Visible); }
+  return;
+}
+// NOTE(MIGUEL): rects only change through here so the grid stays in sync. Rect is before the offset.
+void UIStateElementSetRect(ui_state *State, ui_elm *Element, r2f Rect)
+{
+  Element->Rect = Rect;
+  Element->IsArrangeDirty = 1; //a root's children follow it
+  UIStateSyncElementRect(State, Element);
+  return;
+}
+//~ STACKS
+void UIStatePushColor(ui_state *State, v4f Color)
+{
+  ui_stacks *Stacks = &State->Stacks;
+  assert(Stacks->ColorCount < UI_STACKS_MAX_COUNT);
+  Stacks->Color[Stacks->ColorCount] = V4fHadamard(Stacks->Color[Stacks->ColorCount-1], Color);
+  Stacks->ColorCount++;
+  return;
+}
+void UIStatePushOffset(ui_state *State, v2f Offset)
+{
+  ui_stacks *Stacks = &State->Stacks;
+  assert(Stacks->OffsetCount < UI_STACKS_MAX_COUNT);
+  Stacks->Offset[Stacks->OffsetCount] = V2fAdd(Stacks->Offset[Stacks->OffsetCount-1], Offset);
+  Stacks->OffsetCount++;
+  return;
+}
+//Clip is in screen space, the offsets on the stack don't move it
+void UIStatePushClip(ui_state *State, r2f Clip)
+{
+  ui_stacks *Stacks = &State->Stacks;
+  assert(Stacks->ClipCount < UI_STACKS_MAX_COUNT);
+  Stacks->Clip[Stacks->ClipCount] = R2fIntersect(Stacks->Clip[Stacks->ClipCount-1], Clip);
+  Stacks->ClipCount++;
+  return;
+}
+void UIStatePopColor (ui_state *State) { assert(State->Stacks.ColorCount  > 1); State->Stacks.ColorCount--;  return; }
+void UIStatePopOffset(ui_state *State) { assert(State->Stacks.OffsetCount > 1); State->Stacks.OffsetCount--; return; }
+void UIStatePopClip  (ui_state *State) { assert(State->Stacks.ClipCount   > 1); State->Stacks.ClipCount--;   return; }
+ui_elm *UIStateFindElement(ui_state *State, ui_key Key)
+{
+  u32 Slot = (Key!=UI_NULL_KEY)?UITableFind(State, Key):UI_NULL_SLOT;
+  ui_elm *Result = (Slot!=UI_NULL_SLOT)?&State->Elements[Slot]:NULL;
   return Result;
 }
 void UIStateZListPutElementAtTop(ui_state *State, ui_elm *Element)
@@ -89,6 +581,7 @@ void UIStateZListPutElementAtTop(ui_state *State, ui_elm *Element)
   }
   else if(Element == State->ZList.Bottom)
   {// there is at least one elm ahead
+    Element->Z = ++State->ZTop;
     ui_elm *LastTop = State->ZList.Top;
     State->ZList.Bottom = Element->Next;
     State->ZList.Top    = Element;
@@ -101,6 +594,7 @@ void UIStateZListPutElementAtTop(ui_state *State, ui_elm *Element)
   }
   else
   {// there is at least one elm behind and ahead
+    Element->Z = ++State->ZTop;
     ui_elm *LastTop = State->ZList.Top;
     State->ZList.Top = Element;
     // fix disconect
@@ -116,14 +610,14 @@ void UIStateZListPutElementAtTop(ui_state *State, ui_elm *Element)
 }
 void UIStateZListHandlePushedElement(ui_state *State, ui_elm *Element)
 {
-  // NOTE(MIGUEL): v This condition is highly dependent on stack mgmt code and may falsly report
-  //                 storage as not empty on first elm push.
   if(ElementStorageEmpty(State))
   {
     State->ZList.Top = State->ZList.Bottom = Element;
+    Element->Z = State->ZTop = State->ZBottom = 0;
   }
   else
   {//push to the bottom/front
+    Element->Z = --State->ZBottom;
     ui_elm *LastBottom = State->ZList.Bottom;
     //forward link
     State->ZList.Bottom = Element;
@@ -151,6 +645,7 @@ void UIStateZListHandlePoppedElement(ui_state *State, ui_elm *Element)
   }
   else if(Element == State->ZList.Top)
   {// there is at least one elm behind
+    State->ZList.Top = Element->Prev;
     //cleanup
     State->ZList.Top->Next = NULL;
   }
@@ -165,45 +660,261 @@ void UIStateZListHandlePoppedElement(ui_state *State, ui_elm *Element)
   Element->Prev = NULL;
   return;
 }
-void UIStateElementPush(ui_state *State, ui_elm Element)
+//~ HIERARCHY
+// NOTE(MIGUEL): dirty elements always have dirty ancestors, so marking stops at the first one
+void UIElementMarkDirty(ui_elm *Element)
+{
+  for(; Element && !Element->IsMeasureDirty; Element = Element->Parent) { Element->IsMeasureDirty = 1; }
+  return;
+}
+void UIElementDetach(ui_elm *Element)
+{
+  ui_elm *Parent = Element->Parent;
+  if(!Parent) return;
+  if(Element->PrevSibling) { Element->PrevSibling->NextSibling = Element->NextSibling; }
+  else                     { Parent->FirstChild = Element->NextSibling; }
+  if(Element->NextSibling) { Element->NextSibling->PrevSibling = Element->PrevSibling; }
+  else                     { Parent->LastChild = Element->PrevSibling; }
+  if(Parent->LastDeclaredChild == Element) { Parent->LastDeclaredChild = Element->PrevSibling; }
+  Parent->ChildCount--;
+  Element->Parent      = NULL;
+  Element->NextSibling = NULL;
+  Element->PrevSibling = NULL;
+  UIElementMarkDirty(Parent);
+  return;
+}
+//After NULL makes it the first child
+void UIElementAttach(ui_elm *Parent, ui_elm *Element, ui_elm *After)
+{
+  Element->Parent      = Parent;
+  Element->PrevSibling = After;
+  Element->NextSibling = After?After->NextSibling:Parent->FirstChild;
+  if(Element->NextSibling) { Element->NextSibling->PrevSibling = Element; }
+  else                     { Parent->LastChild = Element; }
+  if(After) { After->NextSibling = Element; }
+  else      { Parent->FirstChild = Element; }
+  Parent->ChildCount++;
+  UIElementMarkDirty(Parent);
+  return;
+}
+// NOTE(MIGUEL): puts a just declared element where this frame's declarations say it goes. when the
+//               order matches last frame's children nothing changes, so a stable ui never dirties.
+void UIStateHandleDeclaredElement(ui_state *State, ui_elm *Element)
+{
+  ui_elm *Parent = State->ParentCount?State->Parents[State->ParentCount-1]:NULL;
+  if(!Parent)
+  {
+    UIElementDetach(Element);
+    return;
+  }
+  ui_elm *After    = Parent->LastDeclaredChild;
+  ui_elm *Expected = After?After->NextSibling:Parent->FirstChild;
+  if(Element != Expected)
+  {
+    UIElementDetach(Element);
+    UIElementAttach(Parent, Element, After);
+  }
+  Parent->LastDeclaredChild = Element;
+  return;
+}
+void UIStatePushParent(ui_state *State, ui_elm *Element)
+{
+  assert(State->ParentCount < UI_STACKS_MAX_COUNT);
+  //a NULL parent (table full) still has to pair with its pop, its children become roots
+  State->Parents[State->ParentCount++] = Element;
+  if(Element) { Element->LastDeclaredChild = NULL; }
+  return;
+}
+void UIStatePopParent(ui_state *State)
+{
+  assert(State->ParentCount > 0);
+  State->ParentCount--;
+  return;
+}
+void UIElementSetLayout(ui_elm *Element, ui_layout Layout)
+{
+  if(!UILayoutIsEqual(&Element->Layout, &Layout))
+  {
+    Element->Layout = Layout;
+    Element->IsMeasureDirty = 0; //so marking goes all the way up
+    UIElementMarkDirty(Element);
+  }
+  return;
+}
+//~ LAYOUT
+v2f UIElementMeasure(ui_state *State, ui_elm *Element)
+{
+  if(!Element->IsMeasureDirty) return Element->Measured;
+  ui_layout *Layout = &Element->Layout;
+  ui_axis Main  = Layout->Axis;
+  ui_axis Cross = (ui_axis)!Main;
+  f32 Content[UI_Axis_Count] = {0};
+  for(ui_elm *Child = Element->FirstChild; Child; Child = Child->NextSibling)
+  {
+    v2f Size = UIElementMeasure(State, Child);
+    Content[Main]  += Size.comp[Main];
+    Content[Cross]  = Max(Content[Cross], Size.comp[Cross]);
+  }
+  if(Element->ChildCount) { Content[Main] += Layout->Gap*(f32)(Element->ChildCount-1); }
+  v2f Measured;
+  for(u32 Axis=0; Axis<UI_Axis_Count; Axis++)
+  {
+    Measured.comp[Axis] = ((Layout->Size[Axis].Kind == UI_Size_Fixed)?Layout->Size[Axis].Value:
+                        Content[Axis]+2.0f*Layout->Padding);
+  }
+  Element->Measured       = Measured;
+  Element->IsMeasureDirty = 0;
+  Element->IsArrangeDirty = 1;
+  State->MeasuredCount++;
+  return Measured;
+}
+void UIElementArrange(ui_state *State, ui_elm *Element, r2f Rect)
+{
+  b32 IsSameRect = (Rect.min.x == Element->Rect.min.x && Rect.min.y == Element->Rect.min.y &&
+                    Rect.max.x == Element->Rect.max.x && Rect.max.y == Element->Rect.max.y);
+  if(IsSameRect && !Element->IsArrangeDirty) return;
+  if(!IsSameRect) { UIStateElementSetRect(State, Element, Rect); }
+  State->ArrangedCount++;
+  ui_layout *Layout = &Element->Layout;
+  ui_axis Main  = Layout->Axis;
+  ui_axis Cross = (ui_axis)!Main;
+  v2f Min  = V2f(Rect.min.x+Layout->Padding, Rect.min.y+Layout->Padding);
+  v2f Size = V2f(Rect.max.x-Rect.min.x-2.0f*Layout->Padding, Rect.max.y-Rect.min.y-2.0f*Layout->Padding);
+  //space the children don't need goes to the growing ones
+  f32 Free   = Size.comp[Main]-Layout->Gap*(f32)(Element->ChildCount?(Element->ChildCount-1):0);
+  f32 Weight = 0.0f;
+  for(ui_elm *Child = Element->FirstChild; Child; Child = Child->NextSibling)
+  {
+    Free -= Child->Measured.comp[Main];
+    if(Child->Layout.Size[Main].Kind == UI_Size_Grow) { Weight += Child->Layout.Size[Main].Value; }
+  }
+  f32 At = Min.comp[Main];
+  for(ui_elm *Child = Element->FirstChild; Child; Child = Child->NextSibling)
+  {
+    ui_size *ChildSize = Child->Layout.Size;
+    v2f ChildMin, ChildDim;
+    ChildDim.comp[Main] = Child->Measured.comp[Main];
+    if(ChildSize[Main].Kind == UI_Size_Grow && Weight > 0.0f && Free > 0.0f)
+    {
+      ChildDim.comp[Main] += Free*ChildSize[Main].Value/Weight;
+    }
+    ChildDim.comp[Cross] = (ChildSize[Cross].Kind == UI_Size_Grow)?Size.comp[Cross]:Child->Measured.comp[Cross];
+    ChildMin.comp[Main]  = At;
+    ChildMin.comp[Cross] = Min.comp[Cross];
+    At += ChildDim.comp[Main]+Layout->Gap;
+    UIElementArrange(State, Child, R2f(ChildMin.x, ChildMin.y, ChildMin.x+ChildDim.x, ChildMin.y+ChildDim.y));
+  }
+  Element->IsArrangeDirty = 0;
+  return;
+}
+// NOTE(MIGUEL): roots with children, at their min corner with their measured size
+void UIStateLayout(ui_state *State)
 {
-  if(ElementStorageFull(State)) return;
-  ui_elm *NewElement = State->NextSlot;
-  *NewElement = Element;
-  UIStateZListHandlePushedElement(State, NewElement); 
-  // NOTE(MIGUEL): ^ this call is relying on the next slot pointer
-  //                 pointing at the first slot indicating empty to handle linked list operations
-  State->ElementCount++;
-  State->NextSlot++;
+  for(u32 Slot=0; Slot<State->SlotCount; Slot++)
+  {
+    ui_elm *Root = &State->Elements[Slot];
+    if(Root->Parent || !Root->FirstChild) continue;
+    if(!Root->IsMeasureDirty && !Root->IsArrangeDirty) continue;
+    v2f Size = UIElementMeasure(State, Root);
+    UIElementArrange(State, Root, R2f(Root->Rect.min.x, Root->Rect.min.y,
+                                      Root->Rect.min.x+Size.x, Root->Rect.min.y+Size.y));
+  }
   return;
 }
-void UIStateElementPop(ui_state *State)
+//~ ELEMENTS
+// NOTE(MIGUEL): declares the widget under Key for this frame. a key seen for the first time gets a
+//               slot at the bottom of the z list with Rect, Color and Flags, after that the
+//               element keeps its own rect (a drag moves it) and only Flags follows the caller.
+//               NULL when the table is full, stale elements only free their slots in UIStateEndFrame.
+ui_elm *UIStateDeclare(ui_state *State, ui_key Key, r2f Rect, v4f Color, ui_elm_flags Flags)
+{
+  ui_elm *Element = UIStateFindElement(State, Key);
+  if(!Element)
+  {
+    if(ElementStorageFull(State)) return NULL;
+    if(State->FreeList)
+    {
+      Element = State->FreeList;
+      State->FreeList = Element->Next;
+    }
+    else
+    {
+      Element = &State->Elements[State->SlotCount++];
+    }
+    u32 Slot = (u32)(Element-State->Elements);
+    ui_elm NewElement = { .Key = Key, .Rect = Rect, .Color = Color, .Next = NULL, .Prev = NULL,
+                          .Layout = UILayout(UI_Axis_X, UISizeFixed(Rect.max.x-Rect.min.x),
+                                             UISizeFixed(Rect.max.y-Rect.min.y), 0.0f, 0.0f),
+                          .IsMeasureDirty = 1 };
+    *Element = NewElement;
+    UIStateZListHandlePushedElement(State, Element);
+    UITableInsert(State, Key, Slot);
+    State->ElementCount++;
+  }
+  ui_stacks *Stacks = &State->Stacks;
+  v2f Offset = Stacks->Offset[Stacks->OffsetCount-1];
+  r2f Clip   = Stacks->Clip[Stacks->ClipCount-1];
+  //a scroll moves every element under it, only then does the grid have to hear about it
+  if(Element->Generation == 0 ||
+     Offset.x != Element->Offset.x || Offset.y != Element->Offset.y ||
+     Clip.min.x != Element->Clip.min.x || Clip.min.y != Element->Clip.min.y ||
+     Clip.max.x != Element->Clip.max.x || Clip.max.y != Element->Clip.max.y)
+  {
+    Element->Offset = Offset;
+    Element->Clip   = Clip;
+    UIStateSyncElementRect(State, Element);
+  }
+  Element->Tint       = Stacks->Color[Stacks->ColorCount-1];
+  Element->Flags      = Flags;
+  Element->Generation = State->Generation;
+  UIStateHandleDeclaredElement(State, Element);
+  return Element;
+}
+// NOTE(MIGUEL): declare for elements that get their rect from a layout. without a parent it is a
+//               root at Min.
+ui_elm *UIStateDeclareLayout(ui_state *State, ui_key Key, v2f Min, ui_layout Layout, v4f Color,
+                             ui_elm_flags Flags)
+{
+  ui_elm *Element = UIStateDeclare(State, Key, R2f(Min.x, Min.y, Min.x, Min.y), Color, Flags);
+  if(Element) { UIElementSetLayout(Element, Layout); }
+  return Element;
+}
+void UIStateRemoveElement(ui_state *State, ui_elm *Element)
 {
-  if(ElementStorageEmpty(State)) return;
-  ui_elm *TopElement = (State->NextSlot - 1);
+  u32 Slot = (u32)(Element-State->Elements);
+  if(ElementIsSelected(State, Element)) { State->SelectedKey = UI_NULL_KEY; }
+  UIElementDetach(Element);
+  while(Element->FirstChild) { UIElementDetach(Element->FirstChild); }
+  UIStateZListHandlePoppedElement(State, Element);
+  UITableRemove(State, Element->Key);
+  UIRectsClear(&State->Rects, Slot);
+  UIGridRemove(&State->Grid, Slot);
   ui_elm ZeroedElement = {0};
-  UIStateZListHandlePoppedElement(State, TopElement);
-  // NOTE(MIGUEL): ^ this call is relying on the top element not being zeroed
-  //                 to handle linked list operations
-  *TopElement = ZeroedElement;
+  *Element = ZeroedElement;
+  Element->Next = State->FreeList;
+  State->FreeList = Element;
   State->ElementCount--;
-  State->NextSlot--;
-  return;
-}
-ui_elm UIElementInit(r2f Rect, v4f Color, u32 Id, ui_elm_flags Flags)
-{
-  // NOTE(MIGUEL): assisgned id could point to somethind out side the table
-  assert(Id<UI_ELEMENT_MAX_COUNT);
-  assert(Id!=UI_NULL_ELEMENT_ID);
-  ui_elm Element = { 
-    .Rect = Rect, 
-    .Color = Color,
-    .Flags = Flags,
-    .Id = Id,
-    .Next = NULL,
-    .Prev = NULL,
-  };
-  return Element;
+  return;
+}
+void UIStateBeginFrame(ui_state *State)
+{
+  State->Generation++;
+  State->ParentCount = 0;
+  UIStacksReset(&State->Stacks);
+  return;
+}
+//evicts every element that wasn't declared since UIStateBeginFrame, then lays out what's left
+void UIStateEndFrame(ui_state *State)
+{
+  for(u32 Slot=0; Slot<State->SlotCount; Slot++)
+  {
+    ui_elm *Element = &State->Elements[Slot];
+    if(ElementIsNull(Element) || Element->Generation == State->Generation) continue;
+    UIStateRemoveElement(State, Element);
+    State->EvictedCount++;
+  }
+  UIStateLayout(State);
+  return;
 }
 
 #endif //UI_H
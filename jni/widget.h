@@ -8,25 +8,28 @@ struct ui_user_sig
   b32 JustPressed;
   b32 IsPressed;
   b32 IsSelected;
+  b32 IsTapped; //a tap gesture ended on it this frame
 };
-ui_user_sig UIDoButton(ui_elm *Element)
+// NOTE(MIGUEL): Hot and TapHot are what the frame's hit tests picked under the touch and the tap,
+//               so a button doesn't test its own rect and only the topmost one reacts. Element is
+//               what UIStateDeclare returned, NULL (table full) does nothing.
+ui_user_sig UIDoButton(ui_elm *Element, v4f Color, v4f PressedColor, ui_elm *Hot, ui_elm *TapHot)
 {
-  ui_user_sig Result = {
-    .IsTouched   = IsInRect(Element->Rect, GlobalTouchPos),
+  ui_user_sig Result = {0};
+  if(!Element) return Result;
+  Result = (ui_user_sig){
+    .IsTouched   = (Element == Hot),
     .IsSelected  = ElementIsSelected(&GlobalUIState, Element),
     .JustPressed = GlobalJustPressed,
     .IsPressed   = GlobalIsPressed,
+    .IsTapped    = (Element == TapHot),
   };
-  Element->Color = ((Element->Id==ELMPUSH_BTN_ELM_ID)?V4f(0.0f, 0.8f, 0.8f, 0.8f):
-                    (Element->Id==ELMPOP_BTN_ELM_ID )?V4f(0.8f, 0.0f, 0.0f, 0.8f):
-                    V4f(0.08f, 0.08f, 0.08f, 0.8f));
+  Element->Color = Color;
   
   
   if(Result.IsTouched && Result.IsPressed)
   {
-    Element->Color = ((Element->Id==ELMPUSH_BTN_ELM_ID)?V4f(0.0f, 1.0f, 1.0f, 1.0f):
-                      (Element->Id==ELMPOP_BTN_ELM_ID )?V4f(1.0f, 0.0f, 0.0f, 1.0f):
-                      V4f(0.2f, 0.2f, 0.2f, 1.0f));
+    Element->Color = PressedColor;
   }
   if(Element->Flags & UI_Flag_Selectable)
   {
@@ -38,17 +41,17 @@ ui_user_sig UIDoButton(ui_elm *Element)
     {
       Element->Color = V4f(1.0f, 1.0f, 1.0f, 0.4f);
     }
-    if(Result.IsSelected)
+    if(Result.IsSelected && !Element->Parent) //a parent's layout owns its children's rects
     {
       if(!Result.JustPressed && Result.IsPressed)
       {
         v2f HalfDim = V2f((Element->Rect.max.x-Element->Rect.min.x)*0.5f,
                           (Element->Rect.max.y-Element->Rect.min.y)*0.5f);
         
-        Element->Rect.min.x = GlobalTouchPos.x-HalfDim.x;
-        Element->Rect.min.y = GlobalTouchPos.y-HalfDim.y;
-        Element->Rect.max.x = GlobalTouchPos.x+HalfDim.x;
-        Element->Rect.max.y = GlobalTouchPos.y+HalfDim.y;
+        v2f Center  = V2f(GlobalTouchPos.x-Element->Offset.x, GlobalTouchPos.y-Element->Offset.y);
+        UIStateElementSetRect(&GlobalUIState, Element,
+                              R2f(Center.x-HalfDim.x, Center.y-HalfDim.y,
+                                  Center.x+HalfDim.x, Center.y+HalfDim.y));
       }
     }
     if(Result.JustPressed && Result.IsTouched && 